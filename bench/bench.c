@@ -0,0 +1,261 @@
+// Times the load and save path piece by piece on one diary file.
+//
+//   bench <diary.json> [min_seconds]
+//
+// Prints one JSON object per benchmark and line:
+//   {"bench": ..., "records": ..., "bytes": ..., "iterations": ..., "ns_per_op": ..., "mb_per_s": ..., "allocs_per_op": ...}
+// mb_per_s is null for benchmarks that do not process the file, allocs_per_op is null
+// when the binary was built without allocation counting (it needs GNU ld's --wrap).
+
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#endif
+
+#include "file.h"
+#include "i18n.h"
+#include "linked_list.h"
+#include "record.h"
+
+#if defined(BENCH_COUNT_ALLOCS)
+// Linked with -Wl,--wrap=malloc,... so every allocation made by the diary code lands here.
+// Allocations libc makes internally (strdup, fopen) are not seen.
+static unsigned long long alloc_count = 0;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size)
+{
+    alloc_count++;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size)
+{
+    alloc_count++;
+    return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+    alloc_count++;
+    return __real_realloc(ptr, size);
+}
+#endif
+
+// One benchmark's accumulated measurements
+typedef struct BenchResult
+{
+    const char *name;
+    double ns;                // Time spent inside the measured calls
+    unsigned long long ops;   // Measured calls
+    unsigned long long allocs;
+    size_t bytes_per_op;      // 0 if the benchmark does not process the file
+} BenchResult;
+
+static double now_ns(void)
+{
+#if defined(_WIN32)
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart * 1e9 / (double)frequency.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+#endif
+}
+
+static unsigned long long allocs_now(void)
+{
+#if defined(BENCH_COUNT_ALLOCS)
+    return alloc_count;
+#else
+    return 0;
+#endif
+}
+
+static double start_ns = 0;
+static unsigned long long start_allocs = 0;
+
+static void measure_start(void)
+{
+    start_allocs = allocs_now();
+    start_ns = now_ns();
+}
+
+static void measure_stop(BenchResult *result, unsigned long long ops)
+{
+    result->ns += now_ns() - start_ns;
+    result->allocs += allocs_now() - start_allocs;
+    result->ops += ops;
+}
+
+static void report(const BenchResult *result, int records)
+{
+    double ns_per_op = result->ops > 0 ? result->ns / (double)result->ops : 0;
+    printf("{\"bench\": \"%s\", \"records\": %d, \"bytes\": %lu, \"iterations\": %llu, \"ns_per_op\": %.1f, \"mb_per_s\": ",
+           result->name, records, (unsigned long)result->bytes_per_op, result->ops, ns_per_op);
+    if (result->bytes_per_op > 0 && ns_per_op > 0)
+    {
+        printf("%.1f", (double)result->bytes_per_op / ns_per_op * 1e9 / (1024.0 * 1024.0));
+    }
+    else
+    {
+        printf("null");
+    }
+#if defined(BENCH_COUNT_ALLOCS)
+    printf(", \"allocs_per_op\": %.1f}\n", result->ops > 0 ? (double)result->allocs / (double)result->ops : 0);
+#else
+    printf(", \"allocs_per_op\": null}\n");
+#endif
+    fflush(stdout);
+}
+
+// Each benchmark repeats until it has run for at least this long
+static double min_ns = 0.5e9;
+
+static int keep_going(const BenchResult *result)
+{
+    return result->ops < 3 || result->ns < min_ns;
+}
+
+static int load_list(const char *json, Node **head, Node **tail, int *length)
+{
+    *head = NULL;
+    *tail = NULL;
+    *length = 0;
+    return ll_from_json_string(json, head, tail, deserialize_record, length, record_alloc, (free_data_func)free_record);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "Usage: %s <diary.json> [min_seconds]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    const char *path = argv[1];
+    if (argc >= 3)
+    {
+        min_ns = atof(argv[2]) * 1e9;
+    }
+    char out_path[4096];
+    snprintf(out_path, sizeof(out_path), "%s.bench-out", path);
+
+    char *json = read_file(path);
+    if (json == NULL)
+    {
+        fprintf(stderr, "Failed to read '%s'.\n", path);
+        return EXIT_FAILURE;
+    }
+    size_t json_len = strlen(json);
+
+    Node *head = NULL;
+    Node *tail = NULL;
+    int records = 0;
+    if (load_list(json, &head, &tail, &records) != 0)
+    {
+        fprintf(stderr, "Failed to parse '%s'.\n", path);
+        free(json);
+        return EXIT_FAILURE;
+    }
+
+    BenchResult read_bench = {"read_file", 0, 0, 0, json_len};
+    while (keep_going(&read_bench))
+    {
+        measure_start();
+        char *data = read_file(path);
+        measure_stop(&read_bench, 1);
+        free(data);
+    }
+    report(&read_bench, records);
+
+    // Every parse needs an empty list, so the previous one is freed outside the measurement
+    BenchResult parse = {"ll_from_json_string", 0, 0, 0, json_len};
+    while (keep_going(&parse))
+    {
+        ll_free_list(&head, (free_data_func)free_record);
+        records_free_all();
+        measure_start();
+        int failed = load_list(json, &head, &tail, &records);
+        measure_stop(&parse, 1);
+        if (failed)
+        {
+            fprintf(stderr, "Failed to parse '%s'.\n", path);
+            return EXIT_FAILURE;
+        }
+    }
+    report(&parse, records);
+
+    char *serialized = NULL;
+    BenchResult serialize = {"ll_to_json_string", 0, 0, 0, 0};
+    while (keep_going(&serialize))
+    {
+        free(serialized);
+        measure_start();
+        ll_to_json_string(head, &serialized, serialize_record);
+        measure_stop(&serialize, 1);
+    }
+    serialize.bytes_per_op = serialized != NULL ? strlen(serialized) : 0;
+    report(&serialize, records);
+
+    BenchResult write_bench = {"write_file", 0, 0, 0, serialize.bytes_per_op};
+    while (serialized != NULL && keep_going(&write_bench))
+    {
+        measure_start();
+        write_file(out_path, serialized);
+        measure_stop(&write_bench, 1);
+    }
+    remove(out_path);
+    free(serialized);
+    report(&write_bench, records);
+
+    ll_free_list(&head, (free_data_func)free_record);
+    records_free_all();
+    BenchResult free_list = {"ll_free_list", 0, 0, 0, 0};
+    while (keep_going(&free_list))
+    {
+        load_list(json, &head, &tail, &records);
+        measure_start();
+        ll_free_list(&head, (free_data_func)free_record);
+        measure_stop(&free_list, 1);
+        records_free_all();
+    }
+    report(&free_list, records);
+    ll_free_all(&head, &tail);
+    free(json);
+
+    // The keys the main loop looks up on every redraw
+    static const char *keys[] = {"help", "record_num", "date", "enter_command", "cmd_prev", "cmd_next",
+                                 "cmd_new", "cmd_save", "cmd_delete", "cmd_close", "missing_key"};
+    const size_t num_keys = sizeof(keys) / sizeof(keys[0]);
+    // The translations are compiled in, so only the lookups by name are left to time
+    i18n_set_language("en");
+    BenchResult lookup = {"i18n_get_string", 0, 0, 0, 0};
+    size_t found = 0;
+    while (keep_going(&lookup))
+    {
+        measure_start();
+        for (int i = 0; i < 100000; i++)
+        {
+            found += strlen(i18n_get_string(keys[i % num_keys])) > 0;
+        }
+        measure_stop(&lookup, 100000);
+    }
+    report(&lookup, 0);
+
+    return found > 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
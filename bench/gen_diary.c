@@ -0,0 +1,161 @@
+// Writes a synthetic diary.json to stdout for the benchmarks.
+//
+//   gen_diary [--records N] [--notes short|medium|long|mixed] [--czech] [--seed S]
+//
+// Records are dated one or two per day starting at 1.1.2000. Note lengths follow the
+// chosen distribution, --czech mixes in UTF-8 words with diacritics. Some notes contain
+// quotes and line breaks so the escaping paths are exercised too.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *english_words[] = {
+    "the", "day", "was", "long", "and", "quiet", "we", "went", "to", "town", "rain", "again",
+    "coffee", "with", "friends", "work", "meeting", "walked", "home", "late", "evening", "book",
+    "read", "slept", "early", "morning", "sun", "garden", "letter", "train", "station", "dinner"};
+
+static const char *czech_words[] = {
+    "dnes", "jsem", "byl", "venku", "počasí", "bylo", "krásné", "šli", "jsme", "do", "města",
+    "večer", "čtení", "knihy", "přítel", "práce", "schůzka", "domů", "pozdě", "ráno", "slunce",
+    "zahrada", "dopis", "vlak", "nádraží", "večeře", "řeka", "pěkný", "den", "úterý", "čaj"};
+
+#define NUM_WORDS(list) (sizeof(list) / sizeof(list[0]))
+
+static unsigned long long rng_state = 88172645463325252ULL;
+
+static unsigned long long next_random(void)
+{
+    rng_state ^= rng_state << 13; // xorshift64
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+static size_t random_between(size_t low, size_t high)
+{
+    return low + (size_t)(next_random() % (high - low + 1));
+}
+
+// Picks a note length in bytes for the distribution
+static size_t note_length(const char *notes)
+{
+    if (strcmp(notes, "short") == 0)
+    {
+        return random_between(20, 80);
+    }
+    if (strcmp(notes, "medium") == 0)
+    {
+        return random_between(200, 800);
+    }
+    if (strcmp(notes, "long") == 0)
+    {
+        return random_between(2000, 8000);
+    }
+
+    // mixed: mostly short entries with the occasional long one
+    unsigned long long roll = next_random() % 100;
+    if (roll < 70)
+    {
+        return random_between(20, 80);
+    }
+    if (roll < 95)
+    {
+        return random_between(200, 800);
+    }
+    return random_between(2000, 8000);
+}
+
+static void write_note(size_t length, int czech)
+{
+    size_t written = 0;
+    while (written < length)
+    {
+        const char *word = NULL;
+        if (czech && next_random() % 2 == 0)
+        {
+            word = czech_words[next_random() % NUM_WORDS(czech_words)];
+        }
+        else
+        {
+            word = english_words[next_random() % NUM_WORDS(english_words)];
+        }
+
+        if (written > 0)
+        {
+            unsigned long long roll = next_random() % 40;
+            const char *separator = roll == 0 ? "\\n" : roll == 1 ? ". " : " ";
+            fputs(separator, stdout);
+            written += strlen(separator);
+        }
+        if (next_random() % 200 == 0)
+        {
+            fputs("\\\"", stdout);
+            written += 2;
+        }
+        fputs(word, stdout);
+        written += strlen(word);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    unsigned long records = 1000;
+    const char *notes = "mixed";
+    int czech = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--records") == 0 && i + 1 < argc)
+        {
+            records = strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--notes") == 0 && i + 1 < argc)
+        {
+            notes = argv[++i];
+        }
+        else if (strcmp(argv[i], "--czech") == 0)
+        {
+            czech = 1;
+        }
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+        {
+            rng_state = strtoull(argv[++i], NULL, 10) | 1;
+        }
+        else
+        {
+            fprintf(stderr, "Usage: %s [--records N] [--notes short|medium|long|mixed] [--czech] [--seed S]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    static const int days_in_month[] = {0, 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    int day = 1;
+    int month = 1;
+    int year = 2000;
+
+    fputc('[', stdout);
+    for (unsigned long i = 0; i < records; i++)
+    {
+        printf("%s{\"day\": %d, \"month\": %d, \"year\": %d, \"note\": \"", i > 0 ? "," : "", day, month, year);
+        write_note(note_length(notes), czech);
+        fputs("\"}", stdout);
+
+        if (next_random() % 4 != 0) // Some days get a second entry
+        {
+            int leap = month == 2 && ((year % 4 == 0 && year % 100 != 0) || year % 400 == 0);
+            if (++day > days_in_month[month] + leap)
+            {
+                day = 1;
+                if (++month > 12)
+                {
+                    month = 1;
+                    year++;
+                }
+            }
+        }
+    }
+    fputs("]", stdout);
+
+    return ferror(stdout) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,716 @@
+// Replays a scripted session against the real diary binary and measures how long each
+// command takes, from sending its input until the main prompt is printed again.
+//
+//   replay [--binary PATH] [--runs N] [--baseline FILE] [--threshold RATIO] <script> <diary.json>
+//
+// The binary runs on a pseudo-terminal, so it buffers its output the way it does for a user.
+// It works on a copy of the diary, so the original file is left alone. The first run only warms up
+// the copy (it builds the search index, for one), the later runs are measured.
+//
+// A script has one step per line, '#' starts a comment:
+//   <repeat> <input>[ | <input>...]
+// Every input is sent as one line. A step has to end back at the main prompt, so
+// "1 new | 1.5.2021 | Walked home. | save" adds a record, "5 delete | yes" removes five
+// and "1 grep rain |" lists the matches and presses Enter.
+// Steps are reported by their first word.
+//
+// Prints one JSON object per step and line:
+//   {"script": ..., "diary": ..., "step": ..., "samples": ..., "p50_us": ..., "p99_us": ..., "max_us": ...}
+// With --baseline the file is read back in the same format. A step whose p50 (or p99, for steps
+// with enough samples) grew past the threshold ratio and by more than REPLAY_NOISE_US is marked
+// "regressed" and the exit status is 1.
+
+#ifndef _XOPEN_SOURCE
+#define _XOPEN_SOURCE 600 // posix_openpt
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+
+int main(void)
+{
+    fprintf(stderr, "The replay benchmark needs a POSIX pseudo-terminal.\n");
+    return EXIT_FAILURE;
+}
+
+#else
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_STEPS 64
+#define MAX_INPUTS 16
+#define MAX_BASELINE 1024
+#define REPLAY_TIMEOUT_MS 60000 // A command that takes longer is treated as a hang
+#define REPLAY_NOISE_US 200.0   // Smaller slowdowns are within the noise of a pseudo-terminal round trip
+#define REPLAY_TAIL_SAMPLES 100 // With fewer samples p99 is just the slowest one, too noisy to compare
+
+// What the main loop prints when it waits for the next command (enter_command in strings.ini)
+static const char *prompt = "Enter command: ";
+
+// One line of the script
+typedef struct Step
+{
+    char label[32];
+    int repeat;
+    char *inputs[MAX_INPUTS];
+    int num_inputs;
+} Step;
+
+// Every latency measured for one label
+typedef struct Samples
+{
+    char label[32];
+    double *us;
+    size_t count;
+    size_t capacity;
+} Samples;
+
+// One line of a baseline file
+typedef struct BaselineEntry
+{
+    char script[64];
+    char diary[128];
+    char step[32];
+    double p50_us;
+    double p99_us;
+} BaselineEntry;
+
+// A running copy of the binary
+typedef struct Session
+{
+    pid_t pid;
+    int master;
+    size_t matched; // Prompt bytes matched at the end of the output so far
+} Session;
+
+static Samples samples[MAX_STEPS + 1];
+static int num_samples = 0;
+
+static double now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e6 + (double)ts.tv_nsec / 1e3;
+}
+
+static Samples *samples_for(const char *label)
+{
+    for (int i = 0; i < num_samples; i++)
+    {
+        if (strcmp(samples[i].label, label) == 0)
+        {
+            return &samples[i];
+        }
+    }
+    if (num_samples == MAX_STEPS + 1)
+    {
+        return NULL;
+    }
+    Samples *entry = &samples[num_samples++];
+    snprintf(entry->label, sizeof(entry->label), "%s", label);
+    return entry;
+}
+
+static int add_sample(const char *label, double us)
+{
+    Samples *entry = samples_for(label);
+    if (entry == NULL)
+    {
+        return -1;
+    }
+    if (entry->count == entry->capacity)
+    {
+        size_t capacity = entry->capacity ? entry->capacity * 2 : 64;
+        double *grown = (double *)realloc(entry->us, capacity * sizeof(double));
+        if (grown == NULL)
+        {
+            return -1; // Memory allocation failed
+        }
+        entry->us = grown;
+        entry->capacity = capacity;
+    }
+    entry->us[entry->count++] = us;
+    return 0;
+}
+
+static int compare_doubles(const void *a, const void *b)
+{
+    double first = *(const double *)a;
+    double second = *(const double *)b;
+    return (first > second) - (first < second);
+}
+
+// Nearest-rank percentile of sorted samples
+static double percentile(const Samples *entry, int p)
+{
+    size_t rank = (entry->count * (size_t)p + 99) / 100;
+    return entry->us[rank > 0 ? rank - 1 : 0];
+}
+
+static int parse_script(const char *path, Step *steps, int *num_steps)
+{
+    FILE *file = fopen(path, "r");
+    if (file == NULL)
+    {
+        return -1;
+    }
+
+    char text[4096];
+    int line_number = 0;
+    *num_steps = 0;
+    while (fgets(text, sizeof(text), file) != NULL)
+    {
+        line_number++;
+        text[strcspn(text, "\r\n")] = '\0';
+        char *start = text;
+        while (*start == ' ' || *start == '\t')
+        {
+            start++;
+        }
+        if (*start == '\0' || *start == '#')
+        {
+            continue;
+        }
+
+        char *rest = NULL;
+        long repeat = strtol(start, &rest, 10);
+        if (rest == start || repeat < 1 || *rest != ' ' || *num_steps == MAX_STEPS)
+        {
+            fprintf(stderr, "%s:%d: expected '<repeat> <input>[ | <input>...]'.\n", path, line_number);
+            fclose(file);
+            return -1;
+        }
+        Step *step = &steps[(*num_steps)++];
+        memset(step, 0, sizeof(*step));
+        step->repeat = (int)repeat;
+        while (*rest == ' ')
+        {
+            rest++;
+        }
+        size_t label_len = strcspn(rest, " ");
+        snprintf(step->label, sizeof(step->label), "%.*s", (int)label_len, rest);
+
+        // Inputs are separated by '|', an input may be empty (just Enter)
+        int trailing_empty = rest[strlen(rest) - 1] == '|';
+        const char *input = strtok(rest, "|");
+        while (input != NULL || trailing_empty)
+        {
+            if (input == NULL)
+            {
+                input = "";
+                trailing_empty = 0;
+            }
+            if (step->num_inputs == MAX_INPUTS)
+            {
+                fprintf(stderr, "%s:%d: more than %d inputs.\n", path, line_number, MAX_INPUTS);
+                fclose(file);
+                return -1;
+            }
+            while (*input == ' ')
+            {
+                input++;
+            }
+            size_t len = strlen(input);
+            while (len > 0 && input[len - 1] == ' ')
+            {
+                len--;
+            }
+            char *copy = (char *)malloc(len + 2);
+            if (copy == NULL)
+            {
+                fclose(file);
+                return -1; // Memory allocation failed
+            }
+            memcpy(copy, input, len);
+            copy[len] = '\n';
+            copy[len + 1] = '\0';
+            step->inputs[step->num_inputs++] = copy;
+            input = strtok(NULL, "|");
+        }
+    }
+    fclose(file);
+    return *num_steps > 0 ? 0 : -1;
+}
+
+static void free_script(Step *steps, int num_steps)
+{
+    for (int i = 0; i < num_steps; i++)
+    {
+        for (int j = 0; j < steps[i].num_inputs; j++)
+        {
+            free(steps[i].inputs[j]);
+        }
+    }
+}
+
+static int session_start(Session *session, const char *binary, const char *diary)
+{
+    session->matched = 0;
+    session->master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (session->master < 0 || grantpt(session->master) != 0 || unlockpt(session->master) != 0)
+    {
+        return -1;
+    }
+    const char *slave_name = ptsname(session->master);
+    if (slave_name == NULL)
+    {
+        close(session->master);
+        return -1;
+    }
+
+    session->pid = fork();
+    if (session->pid < 0)
+    {
+        close(session->master);
+        return -1;
+    }
+    if (session->pid == 0)
+    {
+        setsid();
+        int slave = open(slave_name, O_RDWR);
+        if (slave < 0)
+        {
+            _exit(127);
+        }
+        struct termios settings;
+        if (tcgetattr(slave, &settings) == 0)
+        {
+            settings.c_lflag &= ~(tcflag_t)ECHO; // The commands are not part of the output
+            tcsetattr(slave, TCSANOW, &settings);
+        }
+        dup2(slave, STDIN_FILENO);
+        dup2(slave, STDOUT_FILENO);
+        dup2(slave, STDERR_FILENO);
+        close(slave);
+        close(session->master);
+        setenv("DIARY_FILE", diary, 1);
+        setenv("LANG", "C", 1); // The script is written against the English commands
+        unsetenv("DIARY_ORDER");
+        execl(binary, binary, (char *)NULL);
+        _exit(127);
+    }
+    return 0;
+}
+
+// Reads the binary's output until the main prompt shows up
+static int wait_for_prompt(Session *session)
+{
+    size_t prompt_len = strlen(prompt);
+    char buffer[65536];
+    while (1)
+    {
+        struct pollfd fds = {session->master, POLLIN, 0};
+        int ready = poll(&fds, 1, REPLAY_TIMEOUT_MS);
+        if (ready == 0)
+        {
+            fprintf(stderr, "The binary did not come back to the prompt within %d ms.\n", REPLAY_TIMEOUT_MS);
+            return -1;
+        }
+        if (ready < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return -1;
+        }
+
+        ssize_t got = read(session->master, buffer, sizeof(buffer));
+        if (got <= 0)
+        {
+            if (got < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            fprintf(stderr, "The binary exited before the prompt.\n");
+            return -1;
+        }
+
+        // The prompt can be split across reads, so the match carries over
+        for (ssize_t i = 0; i < got; i++)
+        {
+            if (buffer[i] == prompt[session->matched])
+            {
+                session->matched++;
+            }
+            else
+            {
+                session->matched = buffer[i] == prompt[0] ? 1 : 0;
+            }
+            if (session->matched == prompt_len)
+            {
+                session->matched = 0;
+                if (i + 1 < got)
+                {
+                    continue; // Output after the prompt means it was not waiting yet
+                }
+                return 0;
+            }
+        }
+    }
+}
+
+static int send_input(Session *session, const char *input)
+{
+    size_t len = strlen(input);
+    while (len > 0)
+    {
+        ssize_t written = write(session->master, input, len);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return -1;
+        }
+        input += written;
+        len -= (size_t)written;
+    }
+    return 0;
+}
+
+static int session_finish(Session *session)
+{
+    int status = 0;
+    send_input(session, "close\n");
+
+    // Drain the output so the binary is never blocked on a full terminal
+    char buffer[4096];
+    struct pollfd fds = {session->master, POLLIN, 0};
+    while (poll(&fds, 1, REPLAY_TIMEOUT_MS) > 0 && read(session->master, buffer, sizeof(buffer)) > 0)
+    {
+    }
+    close(session->master);
+    if (waitpid(session->pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+    {
+        fprintf(stderr, "The binary did not exit cleanly.\n");
+        return -1;
+    }
+    return 0;
+}
+
+static void session_kill(Session *session)
+{
+    kill(session->pid, SIGKILL);
+    close(session->master);
+    waitpid(session->pid, NULL, 0);
+}
+
+static int run_session(const char *binary, const char *diary, Step *steps, int num_steps, int measure)
+{
+    Session session;
+    if (session_start(&session, binary, diary) != 0)
+    {
+        fprintf(stderr, "Failed to start '%s'.\n", binary);
+        return -1;
+    }
+
+    double start = now_us();
+    if (wait_for_prompt(&session) != 0)
+    {
+        session_kill(&session);
+        return -1;
+    }
+    if (measure && add_sample("startup", now_us() - start) != 0)
+    {
+        session_kill(&session);
+        return -1;
+    }
+
+    for (int i = 0; i < num_steps; i++)
+    {
+        for (int r = 0; r < steps[i].repeat; r++)
+        {
+            start = now_us();
+            for (int j = 0; j < steps[i].num_inputs; j++)
+            {
+                if (send_input(&session, steps[i].inputs[j]) != 0)
+                {
+                    session_kill(&session);
+                    return -1;
+                }
+            }
+            if (wait_for_prompt(&session) != 0)
+            {
+                fprintf(stderr, "Step '%s' failed.\n", steps[i].label);
+                session_kill(&session);
+                return -1;
+            }
+            if (measure && add_sample(steps[i].label, now_us() - start) != 0)
+            {
+                session_kill(&session);
+                return -1;
+            }
+        }
+    }
+    return session_finish(&session);
+}
+
+static int copy_file(const char *from, const char *to)
+{
+    FILE *in = fopen(from, "rb");
+    if (in == NULL)
+    {
+        return -1;
+    }
+    FILE *out = fopen(to, "wb");
+    if (out == NULL)
+    {
+        fclose(in);
+        return -1;
+    }
+    char buffer[65536];
+    size_t got = 0;
+    int result = 0;
+    while ((got = fread(buffer, 1, sizeof(buffer), in)) > 0)
+    {
+        if (fwrite(buffer, 1, got, out) != got)
+        {
+            result = -1;
+            break;
+        }
+    }
+    if (ferror(in))
+    {
+        result = -1;
+    }
+    fclose(in);
+    if (fclose(out) != 0)
+    {
+        result = -1;
+    }
+    return result;
+}
+
+// Removes the working copy and everything the binary keeps next to it
+static void remove_copy(const char *copy)
+{
+    static const char *suffixes[] = {"", ".log", ".tmp", ".idx", ".idx.tmp"};
+    char path[4096];
+    for (size_t i = 0; i < sizeof(suffixes) / sizeof(suffixes[0]); i++)
+    {
+        snprintf(path, sizeof(path), "%s%s", copy, suffixes[i]);
+        remove(path);
+    }
+}
+
+// The file name without its directory and extension
+static void base_name(const char *path, char *name, size_t size)
+{
+    const char *start = strrchr(path, '/');
+    start = start != NULL ? start + 1 : path;
+    const char *dot = strrchr(start, '.');
+    size_t len = dot != NULL ? (size_t)(dot - start) : strlen(start);
+    snprintf(name, size, "%.*s", (int)len, start);
+}
+
+// Reads a string or number member of one baseline line, the file is always written by this program
+static int field(const char *text, const char *key, char *value, size_t size)
+{
+    char pattern[64];
+    snprintf(pattern, sizeof(pattern), "\"%s\": ", key);
+    const char *found = strstr(text, pattern);
+    if (found == NULL)
+    {
+        return -1;
+    }
+    found += strlen(pattern);
+    if (*found == '"')
+    {
+        found++;
+        size_t len = strcspn(found, "\"");
+        snprintf(value, size, "%.*s", (int)len, found);
+    }
+    else
+    {
+        size_t len = strcspn(found, ",}");
+        snprintf(value, size, "%.*s", (int)len, found);
+    }
+    return 0;
+}
+
+static int load_baseline(const char *path, BaselineEntry *entries, int *count)
+{
+    FILE *file = fopen(path, "r");
+    if (file == NULL)
+    {
+        return -1;
+    }
+    char text[1024];
+    char p50[32];
+    char p99[32];
+    *count = 0;
+    while (fgets(text, sizeof(text), file) != NULL && *count < MAX_BASELINE)
+    {
+        BaselineEntry *entry = &entries[*count];
+        if (field(text, "script", entry->script, sizeof(entry->script)) == 0 &&
+            field(text, "diary", entry->diary, sizeof(entry->diary)) == 0 &&
+            field(text, "step", entry->step, sizeof(entry->step)) == 0 &&
+            field(text, "p50_us", p50, sizeof(p50)) == 0 &&
+            field(text, "p99_us", p99, sizeof(p99)) == 0)
+        {
+            entry->p50_us = atof(p50);
+            entry->p99_us = atof(p99);
+            (*count)++;
+        }
+    }
+    fclose(file);
+    return 0;
+}
+
+static const BaselineEntry *find_baseline(const BaselineEntry *entries, int count,
+                                          const char *script, const char *diary, const char *step)
+{
+    for (int i = 0; i < count; i++)
+    {
+        if (strcmp(entries[i].script, script) == 0 && strcmp(entries[i].diary, diary) == 0 &&
+            strcmp(entries[i].step, step) == 0)
+        {
+            return &entries[i];
+        }
+    }
+    return NULL;
+}
+
+static int regressed(double now, double before, double threshold)
+{
+    return now > before * threshold && now - before > REPLAY_NOISE_US;
+}
+
+int main(int argc, char **argv)
+{
+    const char *binary = "./a.out";
+    const char *baseline_path = NULL;
+    double threshold = 1.5;
+    int runs = 5;
+    const char *script_path = NULL;
+    const char *diary_path = NULL;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--binary") == 0 && i + 1 < argc)
+        {
+            binary = argv[++i];
+        }
+        else if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc)
+        {
+            runs = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc)
+        {
+            baseline_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--threshold") == 0 && i + 1 < argc)
+        {
+            threshold = atof(argv[++i]);
+        }
+        else if (script_path == NULL)
+        {
+            script_path = argv[i];
+        }
+        else if (diary_path == NULL)
+        {
+            diary_path = argv[i];
+        }
+        else
+        {
+            script_path = NULL;
+            break;
+        }
+    }
+    if (script_path == NULL || diary_path == NULL || runs < 1 || threshold <= 0)
+    {
+        fprintf(stderr, "Usage: %s [--binary PATH] [--runs N] [--baseline FILE] [--threshold RATIO] <script> <diary.json>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    static Step steps[MAX_STEPS];
+    int num_steps = 0;
+    if (parse_script(script_path, steps, &num_steps) != 0)
+    {
+        fprintf(stderr, "Failed to read the script '%s'.\n", script_path);
+        free_script(steps, num_steps);
+        return EXIT_FAILURE;
+    }
+
+    static BaselineEntry baseline[MAX_BASELINE];
+    int baseline_count = 0;
+    if (baseline_path != NULL && load_baseline(baseline_path, baseline, &baseline_count) != 0)
+    {
+        fprintf(stderr, "Failed to read the baseline '%s'.\n", baseline_path);
+        free_script(steps, num_steps);
+        return EXIT_FAILURE;
+    }
+
+    char script_name[64];
+    char diary_name[128];
+    base_name(script_path, script_name, sizeof(script_name));
+    base_name(diary_path, diary_name, sizeof(diary_name));
+    char copy[4096];
+    snprintf(copy, sizeof(copy), "%s.replay", diary_path);
+
+    int failed = 0;
+    remove_copy(copy);
+    if (copy_file(diary_path, copy) != 0)
+    {
+        fprintf(stderr, "Failed to copy '%s'.\n", diary_path);
+        failed = 1;
+    }
+    for (int run = 0; run <= runs && !failed; run++)
+    {
+        failed = run_session(binary, copy, steps, num_steps, run > 0) != 0;
+    }
+    remove_copy(copy);
+    free_script(steps, num_steps);
+
+    int regressions = 0;
+    for (int i = 0; i < num_samples && !failed; i++)
+    {
+        Samples *entry = &samples[i];
+        qsort(entry->us, entry->count, sizeof(double), compare_doubles);
+        double p50 = percentile(entry, 50);
+        double p99 = percentile(entry, 99);
+        printf("{\"script\": \"%s\", \"diary\": \"%s\", \"step\": \"%s\", \"samples\": %lu, \"p50_us\": %.1f, \"p99_us\": %.1f, \"max_us\": %.1f",
+               script_name, diary_name, entry->label, (unsigned long)entry->count, p50, p99, entry->us[entry->count - 1]);
+
+        const BaselineEntry *before = find_baseline(baseline, baseline_count, script_name, diary_name, entry->label);
+        if (before != NULL)
+        {
+            int worse = regressed(p50, before->p50_us, threshold) ||
+                        (entry->count >= REPLAY_TAIL_SAMPLES && regressed(p99, before->p99_us, threshold));
+            printf(", \"baseline_p50_us\": %.1f, \"baseline_p99_us\": %.1f, \"regressed\": %s",
+                   before->p50_us, before->p99_us, worse ? "true" : "false");
+            regressions += worse;
+        }
+        printf("}\n");
+    }
+    for (int i = 0; i < num_samples; i++)
+    {
+        free(samples[i].us);
+    }
+
+    if (failed)
+    {
+        return EXIT_FAILURE;
+    }
+    if (regressions > 0)
+    {
+        fprintf(stderr, "%d step(s) of '%s' on '%s' got slower than the baseline allows.\n", regressions, script_name, diary_name);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+#endif
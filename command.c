@@ -0,0 +1,126 @@
+#include "command.h"
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int compare_words(const void *a, const void *b)
+{
+    const CommandWord *first = (const CommandWord *)a;
+    const CommandWord *second = (const CommandWord *)b;
+    int order = strcmp(first->word, second->word);
+    if (order != 0)
+    {
+        return order;
+    }
+    return first->index < second->index ? -1 : first->index > second->index;
+}
+
+// Takes the words from the active language, once per language switch
+static void sort_words(CommandTable *table)
+{
+    for (size_t i = 0; i < table->count; i++)
+    {
+        table->words[i].word = i18n_strings[table->commands[i].word];
+        table->words[i].len = strlen(table->words[i].word);
+        table->words[i].index = i;
+    }
+    qsort(table->words, table->count, sizeof(CommandWord), compare_words);
+    table->strings = i18n_strings;
+}
+
+int command_table_init(CommandTable *table, const Command *commands, size_t count)
+{
+    if (table == NULL || commands == NULL || count == 0)
+    {
+        return -1; // Invalid input
+    }
+    table->commands = commands;
+    table->count = count;
+    table->strings = NULL;
+    table->words = (CommandWord *)malloc(count * sizeof(CommandWord));
+    if (table->words == NULL)
+    {
+        return -1; // Memory allocation failed
+    }
+    return 0;
+}
+
+const Command *command_find(CommandTable *table, char *input, char **argument)
+{
+    if (table == NULL || table->words == NULL || input == NULL)
+    {
+        return NULL; // Invalid input
+    }
+    if (table->strings != i18n_strings)
+    {
+        sort_words(table);
+    }
+
+    size_t len = strlen(input);
+    while (len > 0 && isspace((unsigned char)input[len - 1]))
+    {
+        input[--len] = '\0';
+    }
+    size_t word_len = strcspn(input, " ");
+    if (word_len == 0)
+    {
+        return NULL;
+    }
+
+    // The first word not sorting before the input, every word the input is a prefix of follows it
+    size_t low = 0;
+    size_t high = table->count;
+    while (low < high)
+    {
+        size_t mid = low + (high - low) / 2;
+        if (strncmp(table->words[mid].word, input, word_len) < 0)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+
+    const CommandWord *found = NULL;
+    for (size_t i = low; i < table->count && strncmp(table->words[i].word, input, word_len) == 0; i++)
+    {
+        if (table->words[i].len == word_len)
+        {
+            found = &table->words[i]; // The whole word beats abbreviations of longer ones
+            break;
+        }
+        if (found == NULL || table->words[i].index < found->index)
+        {
+            found = &table->words[i];
+        }
+    }
+    if (found == NULL)
+    {
+        return NULL;
+    }
+
+    char *rest = input + word_len;
+    while (*rest == ' ')
+    {
+        rest++;
+    }
+    if (argument != NULL)
+    {
+        *argument = rest;
+    }
+    return &table->commands[found->index];
+}
+
+void command_table_destroy(CommandTable *table)
+{
+    if (table == NULL)
+    {
+        return;
+    }
+    free(table->words);
+    table->words = NULL;
+    table->strings = NULL;
+}
@@ -0,0 +1,65 @@
+#ifndef COMMAND_H
+#define COMMAND_H
+
+#include <stddef.h>
+
+#include "i18n.h"
+
+/**
+ * @brief A function pointer type for the function that runs a command.
+ * @param argument What followed the command word, without the spaces in between ("" if nothing did).
+ * @return 1 to close the diary, 0 otherwise.
+ */
+typedef int (*command_func)(char *argument);
+
+// One command, typed as its word in the active language
+typedef struct Command
+{
+    StringKey word;
+    const char *name; // The trace span name, a string literal
+    command_func run;
+} Command;
+
+// One localized word of the table, sorted by the word
+typedef struct CommandWord
+{
+    const char *word;
+    size_t len;
+    size_t index; // Of the command in the table, earlier commands win ambiguous abbreviations
+} CommandWord;
+
+// The commands and their words in the language they were sorted for
+typedef struct CommandTable
+{
+    const Command *commands;
+    size_t count;
+    CommandWord *words;
+    const char *const *strings; // The i18n_strings the words were taken from
+} CommandTable;
+
+/**
+ * @brief Initializes a table over a list of commands. The words are looked up when the first line is dispatched.
+ * @param table The table to initialize.
+ * @param commands The commands. They are not copied, so they must outlive the table.
+ * @param count The number of commands.
+ * @return 0 on success, -1 on failure.
+ */
+int command_table_init(CommandTable *table, const Command *commands, size_t count);
+
+/**
+ * @brief Finds the command an input line starts with. The word can be abbreviated to any prefix,
+ * a prefix of several words picks the command listed first. After a language switch the words are sorted again.
+ * @param table The table to search.
+ * @param input The input line. Trailing whitespace is cut off in place.
+ * @param argument Set to what followed the word.
+ * @return The command, or NULL if the line is empty or starts with no command's word.
+ */
+const Command *command_find(CommandTable *table, char *input, char **argument);
+
+/**
+ * @brief Releases the sorted words.
+ * @param table The table to destroy.
+ */
+void command_table_destroy(CommandTable *table);
+
+#endif // COMMAND_H
@@ -1,10 +1,33 @@
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+#ifndef _DARWIN_C_SOURCE
+#define _DARWIN_C_SOURCE // st_mtimespec on macOS
+#endif
+
+#include "file.h"
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 
-char *read_file(const char *filename)
+#include "trace.h"
+
+#if defined(_WIN32)
+#include <io.h>
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// Reads a whole file in the given fopen mode, size receives the bytes actually read
+static char *read_whole(const char *filename, const char *mode, size_t *size)
 {
-    FILE *file = fopen(filename, "r");
+    long long span = trace_begin();
+    FILE *file = fopen(filename, mode);
     if (file == NULL)
     {
         return NULL; // File could not be opened
@@ -13,6 +36,11 @@ char *read_file(const char *filename)
     fseek(file, 0, SEEK_END);
     long file_size = ftell(file);
     fseek(file, 0, SEEK_SET);
+    if (file_size < 0)
+    {
+        fclose(file);
+        return NULL; // Not a file that can be measured
+    }
 
     char *buffer = (char *)malloc(file_size + 1);
     if (buffer == NULL)
@@ -21,21 +49,313 @@ char *read_file(const char *filename)
         return NULL; // Memory allocation failed
     }
 
-    fread(buffer, 1, file_size, file);
-    buffer[file_size] = '\0'; // Null-terminate the string
+    size_t got = fread(buffer, 1, file_size, file);
+    buffer[got] = '\0'; // Text mode on Windows can read less than the file size
     fclose(file);
+    if (size != NULL)
+    {
+        *size = got;
+    }
+    TRACE_COUNT(TRACE_BYTES_READ, got);
+    trace_end("read_file", span);
     return buffer;
 }
 
+char *read_file(const char *filename)
+{
+    return read_whole(filename, "r", NULL);
+}
+
+char *read_file_binary(const char *filename, size_t *size)
+{
+    if (filename == NULL || size == NULL)
+    {
+        return NULL; // Invalid input
+    }
+    return read_whole(filename, "rb", size);
+}
+
 int write_file(const char *filename, const char *data)
 {
-    FILE *file = fopen(filename, "w");
+    if (filename == NULL || data == NULL)
+    {
+        return -1; // Invalid input
+    }
+
+    // Truncating the file in place would lose it to a crash mid-write
+    size_t name_len = strlen(filename);
+    char *temp_name = (char *)malloc(name_len + 5);
+    if (temp_name == NULL)
+    {
+        return -1; // Memory allocation failed
+    }
+    memcpy(temp_name, filename, name_len);
+    memcpy(temp_name + name_len, ".tmp", 5);
+
+    FILE *file = fopen(temp_name, "wb");
     if (file == NULL)
     {
+        free(temp_name);
         return -1; // File could not be opened for writing
     }
 
-    fwrite(data, sizeof(char), strlen(data), file);
-    fclose(file);
-    return 0; // File written successfully
+    long long span = trace_begin();
+    size_t len = strlen(data);
+    size_t written = fwrite(data, sizeof(char), len, file);
+    int result = written == len && sync_file(file) == 0 ? 0 : -1;
+    if (fclose(file) != 0)
+    {
+        result = -1;
+    }
+    if (result == 0 && replace_file(temp_name, filename) == 0)
+    {
+        sync_dir(filename);
+    }
+    else
+    {
+        remove(temp_name);
+        result = -1;
+    }
+    free(temp_name);
+    TRACE_COUNT(TRACE_BYTES_WRITTEN, written);
+    trace_end("write_file", span);
+    return result;
+}
+
+int map_file(const char *filename, MappedFile *map)
+{
+    if (filename == NULL || map == NULL)
+    {
+        return -1; // Invalid input
+    }
+    map->data = NULL;
+    map->size = 0;
+    map->is_mapped = 0;
+
+#if !defined(_WIN32)
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0)
+    {
+        return -1; // File could not be opened
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+    if (st.st_size == 0)
+    {
+        close(fd);
+        return 0; // Nothing to map
+    }
+
+    void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // The mapping keeps the file alive
+    if (data != MAP_FAILED)
+    {
+        map->data = (const char *)data;
+        map->size = (size_t)st.st_size;
+        map->is_mapped = 1;
+        TRACE_COUNT(TRACE_BYTES_READ, st.st_size); // Counted as a whole, the pages come in as they are touched
+        return 0;
+    }
+#endif
+
+    // No mmap available, read the whole file instead, byte for byte: a binary diary holds '\0's and CR/LF
+    size_t size = 0;
+    char *buffer = read_file_binary(filename, &size);
+    if (buffer == NULL)
+    {
+        return -1;
+    }
+    if (size == 0)
+    {
+        free(buffer);
+        return 0; // Nothing was read
+    }
+    map->data = buffer;
+    map->size = size;
+    return 0;
+}
+
+void unmap_file(MappedFile *map)
+{
+    if (map == NULL || map->data == NULL)
+    {
+        return;
+    }
+
+#if !defined(_WIN32)
+    if (map->is_mapped)
+    {
+        munmap((void *)map->data, map->size);
+    }
+    else
+#endif
+    {
+        free((void *)map->data);
+    }
+    map->data = NULL;
+    map->size = 0;
+    map->is_mapped = 0;
+}
+
+int replace_file(const char *source, const char *target)
+{
+    if (source == NULL || target == NULL)
+    {
+        return -1; // Invalid input
+    }
+
+#if defined(_WIN32)
+    // rename does not overwrite on Windows, and removing the target first would leave no file to a crash in between
+    return MoveFileExA(source, target, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) ? 0 : -1;
+#else
+    return rename(source, target) == 0 ? 0 : -1;
+#endif
+}
+
+int sync_file(FILE *file)
+{
+    if (file == NULL || fflush(file) != 0)
+    {
+        return -1; // Invalid input or the buffered data could not be written
+    }
+
+    long long span = trace_begin();
+#if defined(_WIN32)
+    int result = _commit(_fileno(file)) == 0 ? 0 : -1;
+#else
+    int result = fsync(fileno(file)) == 0 ? 0 : -1;
+#endif
+    TRACE_COUNT(TRACE_SYNCS, 1);
+    trace_end("fsync", span);
+    return result;
+}
+
+int sync_dir(const char *filename)
+{
+    if (filename == NULL)
+    {
+        return -1; // Invalid input
+    }
+
+#if defined(_WIN32)
+    return 0; // Renames are not made durable through the directory on Windows
+#else
+    const char *slash = strrchr(filename, '/');
+    char *dir = NULL;
+    if (slash != NULL)
+    {
+        size_t len = slash > filename ? (size_t)(slash - filename) : 1; // "/name" lives in "/"
+        dir = (char *)malloc(len + 1);
+        if (dir == NULL)
+        {
+            return -1; // Memory allocation failed
+        }
+        memcpy(dir, filename, len);
+        dir[len] = '\0';
+    }
+
+    int fd = open(dir != NULL ? dir : ".", O_RDONLY);
+    free(dir);
+    if (fd < 0)
+    {
+        return -1; // Directory could not be opened
+    }
+    long long span = trace_begin();
+    int result = fsync(fd) == 0 ? 0 : -1;
+    close(fd);
+    TRACE_COUNT(TRACE_SYNCS, 1);
+    trace_end("fsync", span);
+    return result;
+#endif
+}
+
+int sync_policy_parse(const char *value, SyncPolicy *policy)
+{
+    policy->mode = SYNC_ALWAYS;
+    policy->max_ops = 0;
+    policy->max_ms = 0;
+    if (value == NULL || value[0] == '\0' || strcmp(value, "always") == 0)
+    {
+        return 0;
+    }
+    if (strcmp(value, "never") == 0)
+    {
+        policy->mode = SYNC_NEVER;
+        return 0;
+    }
+
+    // A list of limits, whichever is reached first syncs the waiting operations
+    const char *ptr = value;
+    while (1)
+    {
+        char *end = NULL;
+        long limit = strtol(ptr, &end, 10);
+        if (end == ptr || limit <= 0)
+        {
+            break;
+        }
+        if (strncmp(end, "ms", 2) == 0)
+        {
+            policy->max_ms = limit;
+            end += 2;
+        }
+        else if (strncmp(end, "ops", 3) == 0)
+        {
+            policy->max_ops = limit;
+            end += 3;
+        }
+        else
+        {
+            break;
+        }
+
+        if (*end == '\0')
+        {
+            policy->mode = SYNC_GROUP;
+            return 0;
+        }
+        if (*end != ',')
+        {
+            break;
+        }
+        ptr = end + 1;
+    }
+    policy->max_ops = 0;
+    policy->max_ms = 0;
+    return -1; // Not a policy
+}
+
+void file_stamp(const char *filename, long *size, long long *mtime)
+{
+    *size = 0;
+    *mtime = 0;
+    struct stat st;
+    if (filename == NULL || stat(filename, &st) != 0)
+    {
+        return;
+    }
+    *size = (long)st.st_size;
+
+    // Whole seconds would let a snapshot rewritten within the same second at the same size pass for the old one
+#if defined(_WIN32)
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (GetFileAttributesExA(filename, GetFileExInfoStandard, &data))
+    {
+        *mtime = (long long)(((unsigned long long)data.ftLastWriteTime.dwHighDateTime << 32) |
+                             data.ftLastWriteTime.dwLowDateTime); // 100 ns units
+    }
+    else
+    {
+        *mtime = (long long)st.st_mtime;
+    }
+#elif defined(__APPLE__)
+    *mtime = (long long)st.st_mtimespec.tv_sec * 1000000000LL + st.st_mtimespec.tv_nsec;
+#else
+    *mtime = (long long)st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+#endif
 }
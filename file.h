@@ -1,6 +1,33 @@
 #ifndef FILE_H
 #define FILE_H
 
+#include <stdio.h>
+#include <stddef.h>
+
+// A read-only view of a whole file, memory-mapped where the platform supports it
+typedef struct MappedFile
+{
+    const char *data;
+    size_t size;
+    int is_mapped; // 1 if data is a mapping, 0 if it is a heap copy
+} MappedFile;
+
+// When written data is forced to disk
+typedef enum SyncMode
+{
+    SYNC_ALWAYS, // Every journal operation and every snapshot
+    SYNC_GROUP,  // Journal operations in groups, see SyncPolicy, snapshots always
+    SYNC_NEVER   // Left to the OS, a power loss can drop recent changes
+} SyncMode;
+
+// A sync policy, parsed from DIARY_SYNC
+typedef struct SyncPolicy
+{
+    SyncMode mode;
+    long max_ops; // SYNC_GROUP: sync once this many operations are waiting, 0 for no limit
+    long max_ms;  // SYNC_GROUP: sync once the oldest waiting operation is this old, 0 for no limit
+} SyncPolicy;
+
 /**
  * @brief Reads the contents of a file.
  * @param filename The name of the file to read.
@@ -9,11 +36,75 @@
 char *read_file(const char *filename);
 
 /**
- * @brief Writes the contents of a string to a file.
+ * @brief Reads the contents of a file byte for byte, without the text mode translation of read_file.
+ * @param filename The name of the file to read.
+ * @param size Receives the number of bytes read, the data may contain '\0's.
+ * @return buffer containing the file contents followed by a '\0', or NULL on failure.
+ */
+char *read_file_binary(const char *filename, size_t *size);
+
+/**
+ * @brief Writes the contents of a string to a file. The string goes to a temporary file
+ * next to it, which is synced and renamed over the file, so a crash leaves the old or the new contents.
  * @param filename The name of the file to write to.
  * @param data The string to write to the file.
  * @return 0 on success, or -1 on failure.
  */
 int write_file(const char *filename, const char *data);
 
+/**
+ * @brief Maps a file read-only into memory, falling back to reading it into a heap buffer.
+ * Pages are only loaded when they are first touched. The data is not null-terminated.
+ * @param filename The name of the file to map.
+ * @param map The view to fill. An empty file gives data == NULL and size == 0.
+ * @return 0 on success, or -1 on failure.
+ */
+int map_file(const char *filename, MappedFile *map);
+
+/**
+ * @brief Releases a view created by map_file.
+ * @param map The view to release.
+ */
+void unmap_file(MappedFile *map);
+
+/**
+ * @brief Renames a file over another one. Existing mappings of the target stay valid.
+ * @param source The name of the file to rename.
+ * @param target The name it should get.
+ * @return 0 on success, or -1 on failure.
+ */
+int replace_file(const char *source, const char *target);
+
+/**
+ * @brief Flushes a stream and forces its file to disk.
+ * @param file The stream to sync.
+ * @return 0 on success, or -1 on failure.
+ */
+int sync_file(FILE *file);
+
+/**
+ * @brief Forces the directory holding a file to disk, so a rename into it survives a crash.
+ * Does nothing where directories cannot be synced.
+ * @param filename The name of a file in the directory.
+ * @return 0 on success, or -1 on failure.
+ */
+int sync_dir(const char *filename);
+
+/**
+ * @brief Parses a sync policy: "always", "never", or group commit limits such as "100ms", "64ops" or "100ms,64ops".
+ * @param value The text to parse. NULL or empty gives "always".
+ * @param policy Receives the policy.
+ * @return 0 on success, or -1 if the text is not a policy (policy is then "always").
+ */
+int sync_policy_parse(const char *value, SyncPolicy *policy);
+
+/**
+ * @brief Identifies a file version by its size and modification time.
+ * @param filename The name of the file.
+ * @param size Receives the size, 0 if the file is missing.
+ * @param mtime Receives the modification time in the finest unit the platform keeps (ns, 100 ns on Windows),
+ * only meant to be compared. 0 if the file is missing.
+ */
+void file_stamp(const char *filename, long *size, long long *mtime);
+
 #endif // FILE_H
\ No newline at end of file
@@ -0,0 +1,153 @@
+#include "gap_buffer.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define GAP_MIN_SIZE 256
+
+// Makes room for at least extra more bytes at the cursor, growing geometrically
+static int reserve(GapBuffer *buffer, size_t extra)
+{
+    if (buffer->gap_end - buffer->gap_start >= extra)
+    {
+        return 0;
+    }
+    size_t len = gap_length(buffer);
+    size_t capacity = buffer->capacity * 2;
+    if (capacity < len + extra + GAP_MIN_SIZE)
+    {
+        capacity = len + extra + GAP_MIN_SIZE;
+    }
+    char *grown = (char *)realloc(buffer->data, capacity);
+    if (grown == NULL)
+    {
+        return -1; // Memory allocation failed
+    }
+    // The text after the gap moves to the new end
+    size_t after = buffer->capacity - buffer->gap_end;
+    memmove(grown + capacity - after, grown + buffer->gap_end, after);
+    buffer->data = grown;
+    buffer->gap_end = capacity - after;
+    buffer->capacity = capacity;
+    return 0;
+}
+
+int gap_init(GapBuffer *buffer, const char *text, size_t len)
+{
+    if (buffer == NULL || (text == NULL && len > 0))
+    {
+        return -1; // Invalid input
+    }
+    memset(buffer, 0, sizeof(GapBuffer));
+    if (reserve(buffer, len) != 0)
+    {
+        return -1;
+    }
+    buffer->gap_end = buffer->capacity - len;
+    if (len > 0)
+    {
+        memcpy(buffer->data + buffer->gap_end, text, len);
+    }
+    return 0;
+}
+
+size_t gap_length(const GapBuffer *buffer)
+{
+    return buffer->capacity - (buffer->gap_end - buffer->gap_start);
+}
+
+char gap_at(const GapBuffer *buffer, size_t position)
+{
+    return position < buffer->gap_start ? buffer->data[position]
+                                        : buffer->data[position + (buffer->gap_end - buffer->gap_start)];
+}
+
+void gap_move(GapBuffer *buffer, size_t position)
+{
+    size_t len = gap_length(buffer);
+    position = position < len ? position : len;
+    if (position < buffer->gap_start)
+    {
+        size_t count = buffer->gap_start - position;
+        memmove(buffer->data + buffer->gap_end - count, buffer->data + position, count);
+        buffer->gap_start -= count;
+        buffer->gap_end -= count;
+    }
+    else if (position > buffer->gap_start)
+    {
+        size_t count = position - buffer->gap_start;
+        memmove(buffer->data + buffer->gap_start, buffer->data + buffer->gap_end, count);
+        buffer->gap_start += count;
+        buffer->gap_end += count;
+    }
+}
+
+int gap_insert(GapBuffer *buffer, const char *text, size_t len)
+{
+    if (buffer == NULL || (text == NULL && len > 0))
+    {
+        return -1; // Invalid input
+    }
+    if (reserve(buffer, len) != 0)
+    {
+        return -1;
+    }
+    memcpy(buffer->data + buffer->gap_start, text, len);
+    buffer->gap_start += len;
+    return 0;
+}
+
+void gap_delete_before(GapBuffer *buffer, size_t count)
+{
+    buffer->gap_start -= count < buffer->gap_start ? count : buffer->gap_start;
+}
+
+void gap_delete_after(GapBuffer *buffer, size_t count)
+{
+    size_t after = buffer->capacity - buffer->gap_end;
+    buffer->gap_end += count < after ? count : after;
+}
+
+size_t gap_line_start(const GapBuffer *buffer, size_t position)
+{
+    while (position > 0 && gap_at(buffer, position - 1) != '\n')
+    {
+        position--;
+    }
+    return position;
+}
+
+size_t gap_line_end(const GapBuffer *buffer, size_t position)
+{
+    size_t len = gap_length(buffer);
+    while (position < len && gap_at(buffer, position) != '\n')
+    {
+        position++;
+    }
+    return position;
+}
+
+const char *gap_text(GapBuffer *buffer, size_t *len)
+{
+    gap_move(buffer, gap_length(buffer));
+    if (reserve(buffer, 1) != 0)
+    {
+        return NULL; // No room for the terminator
+    }
+    buffer->data[buffer->gap_start] = '\0';
+    if (len != NULL)
+    {
+        *len = buffer->gap_start;
+    }
+    return buffer->data;
+}
+
+void gap_destroy(GapBuffer *buffer)
+{
+    if (buffer == NULL)
+    {
+        return;
+    }
+    free(buffer->data);
+    memset(buffer, 0, sizeof(GapBuffer));
+}
@@ -0,0 +1,101 @@
+#ifndef GAP_BUFFER_H
+#define GAP_BUFFER_H
+
+#include <stddef.h>
+
+// Text being edited, kept in one block with a gap at the cursor. Typing and deleting at the
+// cursor only move the edges of the gap, moving the cursor moves the text between the old
+// and the new position across it, so editing is cheap however long the text is.
+typedef struct GapBuffer
+{
+    char *data;
+    size_t capacity;
+    size_t gap_start; // The cursor, the text before it is data[0..gap_start)
+    size_t gap_end;   // The text after the cursor is data[gap_end..capacity)
+} GapBuffer;
+
+/**
+ * @brief Initializes a buffer holding a copy of a text, with the cursor at its start.
+ * @param buffer The buffer to initialize.
+ * @param text The text.
+ * @param len The length of the text.
+ * @return 0 on success, -1 on failure.
+ */
+int gap_init(GapBuffer *buffer, const char *text, size_t len);
+
+/**
+ * @brief Returns the length of the text.
+ * @param buffer The buffer.
+ * @return The length in bytes, the gap not counted.
+ */
+size_t gap_length(const GapBuffer *buffer);
+
+/**
+ * @brief Returns a byte of the text.
+ * @param buffer The buffer.
+ * @param position The position of the byte, below gap_length.
+ * @return The byte.
+ */
+char gap_at(const GapBuffer *buffer, size_t position);
+
+/**
+ * @brief Moves the cursor.
+ * @param buffer The buffer.
+ * @param position The new position of the cursor, clamped to the length of the text.
+ */
+void gap_move(GapBuffer *buffer, size_t position);
+
+/**
+ * @brief Inserts text at the cursor and moves the cursor after it.
+ * @param buffer The buffer.
+ * @param text The text to insert.
+ * @param len The length of the text.
+ * @return 0 on success, -1 on failure.
+ */
+int gap_insert(GapBuffer *buffer, const char *text, size_t len);
+
+/**
+ * @brief Deletes text before the cursor.
+ * @param buffer The buffer.
+ * @param count The number of bytes to delete, clamped to the text before the cursor.
+ */
+void gap_delete_before(GapBuffer *buffer, size_t count);
+
+/**
+ * @brief Deletes text after the cursor.
+ * @param buffer The buffer.
+ * @param count The number of bytes to delete, clamped to the text after the cursor.
+ */
+void gap_delete_after(GapBuffer *buffer, size_t count);
+
+/**
+ * @brief Finds the start of the line a position is on.
+ * @param buffer The buffer.
+ * @param position The position.
+ * @return The position just after the previous '\n', or 0.
+ */
+size_t gap_line_start(const GapBuffer *buffer, size_t position);
+
+/**
+ * @brief Finds the end of the line a position is on.
+ * @param buffer The buffer.
+ * @param position The position.
+ * @return The position of the next '\n', or the length of the text.
+ */
+size_t gap_line_end(const GapBuffer *buffer, size_t position);
+
+/**
+ * @brief Returns the whole text in one piece, which moves the gap and the cursor to the end.
+ * @param buffer The buffer.
+ * @param len Receives the length of the text.
+ * @return The text, terminated by '\0', valid until the buffer is changed.
+ */
+const char *gap_text(GapBuffer *buffer, size_t *len);
+
+/**
+ * @brief Frees the buffer.
+ * @param buffer The buffer to free.
+ */
+void gap_destroy(GapBuffer *buffer);
+
+#endif // GAP_BUFFER_H
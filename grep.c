@@ -0,0 +1,247 @@
+#include "grep.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "parallel.h"
+
+#if defined(__GNUC__) && defined(__AVX2__)
+#include <immintrin.h>
+#define GREP_AVX2 1
+#elif defined(__GNUC__) && defined(__SSE2__)
+#include <emmintrin.h>
+#define GREP_SSE2 1
+#endif
+
+#define GREP_BLOCK 4096                    // Nodes a worker takes at a time
+#define GREP_MIN_PARALLEL (4 * GREP_BLOCK) // Shorter lists are scanned on the calling thread
+
+// Matches found in one block of nodes, kept apart so they can be joined in list order
+typedef struct GrepBlock
+{
+    GrepMatch *matches;
+    size_t count;
+    size_t capacity;
+} GrepBlock;
+
+// Shared by all workers, which take the blocks from the queue one at a time
+typedef struct GrepJob
+{
+    Node **nodes;
+    size_t num_nodes;
+    GrepBlock *blocks;
+    size_t num_blocks;
+    ParallelQueue queue;
+    const char *pattern;
+    size_t pattern_len;
+    data_view_func view;
+} GrepJob;
+
+long grep_find(const char *haystack, size_t haystack_len, const char *needle, size_t needle_len)
+{
+    if (needle_len == 0)
+    {
+        return 0;
+    }
+    if (needle_len > haystack_len)
+    {
+        return -1;
+    }
+    if (needle_len == 1)
+    {
+        const char *found = (const char *)memchr(haystack, needle[0], haystack_len);
+        return found != NULL ? (long)(found - haystack) : -1;
+    }
+
+    // Positions where both the first and the last byte of the needle line up are
+    // candidates, only those are compared in full
+    size_t last = haystack_len - needle_len; // Last possible start
+    size_t i = 0;
+#if defined(GREP_AVX2)
+    const __m256i first_byte = _mm256_set1_epi8(needle[0]);
+    const __m256i last_byte = _mm256_set1_epi8(needle[needle_len - 1]);
+    for (; i + 32 <= last + 1; i += 32)
+    {
+        __m256i starts = _mm256_loadu_si256((const __m256i *)(haystack + i));
+        __m256i ends = _mm256_loadu_si256((const __m256i *)(haystack + i + needle_len - 1));
+        unsigned int mask = (unsigned int)_mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(starts, first_byte), _mm256_cmpeq_epi8(ends, last_byte)));
+        while (mask != 0)
+        {
+            size_t candidate = i + (size_t)__builtin_ctz(mask);
+            if (memcmp(haystack + candidate + 1, needle + 1, needle_len - 2) == 0)
+            {
+                return (long)candidate;
+            }
+            mask &= mask - 1;
+        }
+    }
+#elif defined(GREP_SSE2)
+    const __m128i first_byte = _mm_set1_epi8(needle[0]);
+    const __m128i last_byte = _mm_set1_epi8(needle[needle_len - 1]);
+    for (; i + 16 <= last + 1; i += 16)
+    {
+        __m128i starts = _mm_loadu_si128((const __m128i *)(haystack + i));
+        __m128i ends = _mm_loadu_si128((const __m128i *)(haystack + i + needle_len - 1));
+        unsigned int mask = (unsigned int)_mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(starts, first_byte), _mm_cmpeq_epi8(ends, last_byte)));
+        while (mask != 0)
+        {
+            size_t candidate = i + (size_t)__builtin_ctz(mask);
+            if (memcmp(haystack + candidate + 1, needle + 1, needle_len - 2) == 0)
+            {
+                return (long)candidate;
+            }
+            mask &= mask - 1;
+        }
+    }
+#endif
+
+    // Scalar fallback and the positions left over after the vector loop
+    while (i <= last)
+    {
+        const char *found = (const char *)memchr(haystack + i, needle[0], last - i + 1);
+        if (found == NULL)
+        {
+            return -1;
+        }
+        i = (size_t)(found - haystack);
+        if (haystack[i + needle_len - 1] == needle[needle_len - 1] &&
+            memcmp(haystack + i + 1, needle + 1, needle_len - 2) == 0)
+        {
+            return (long)i;
+        }
+        i++;
+    }
+    return -1;
+}
+
+static int add_match(GrepBlock *block, Node *node, size_t offset)
+{
+    if (block->count == block->capacity)
+    {
+        size_t capacity = block->capacity ? block->capacity * 2 : 16;
+        GrepMatch *grown = (GrepMatch *)realloc(block->matches, capacity * sizeof(GrepMatch));
+        if (grown == NULL)
+        {
+            return -1; // Memory allocation failed
+        }
+        block->matches = grown;
+        block->capacity = capacity;
+    }
+    block->matches[block->count].node = node;
+    block->matches[block->count].offset = offset;
+    block->count++;
+    return 0;
+}
+
+static void *grep_worker(void *arg)
+{
+    GrepJob *job = (GrepJob *)arg;
+    char *scratch = NULL; // Each worker decodes escaped notes into its own buffer
+    size_t scratch_capacity = 0;
+
+    size_t b = 0;
+    while ((b = parallel_queue_take(&job->queue)) < job->num_blocks)
+    {
+        GrepBlock *block = &job->blocks[b];
+        size_t end = (b + 1) * GREP_BLOCK < job->num_nodes ? (b + 1) * GREP_BLOCK : job->num_nodes;
+        for (size_t i = b * GREP_BLOCK; i < end; i++)
+        {
+            size_t len = 0;
+            const char *text = job->view(job->nodes[i]->data, &scratch, &scratch_capacity, &len);
+            long offset = grep_find(text, len, job->pattern, job->pattern_len);
+            if (offset >= 0 && add_match(block, job->nodes[i], (size_t)offset) != 0)
+            {
+                parallel_queue_fail(&job->queue);
+                break;
+            }
+        }
+    }
+
+    free(scratch);
+    return NULL;
+}
+
+int grep_list(Node *head, const char *pattern, size_t pattern_len, data_view_func view, GrepMatch **matches, size_t *count)
+{
+    if (pattern == NULL || view == NULL || matches == NULL || count == NULL)
+    {
+        return -1; // Invalid input
+    }
+    *matches = NULL;
+    *count = 0;
+
+    GrepJob job;
+    memset(&job, 0, sizeof(job));
+    job.pattern = pattern;
+    job.pattern_len = pattern_len;
+    job.view = view;
+
+    for (Node *node = head; node != NULL; node = node->next)
+    {
+        job.num_nodes++;
+    }
+    if (job.num_nodes == 0)
+    {
+        return 0;
+    }
+
+    job.num_blocks = (job.num_nodes + GREP_BLOCK - 1) / GREP_BLOCK;
+    job.nodes = (Node **)malloc(job.num_nodes * sizeof(Node *));
+    job.blocks = (GrepBlock *)calloc(job.num_blocks, sizeof(GrepBlock));
+    if (job.nodes == NULL || job.blocks == NULL)
+    {
+        free(job.nodes);
+        free(job.blocks);
+        return -1; // Memory allocation failed
+    }
+    size_t i = 0;
+    for (Node *node = head; node != NULL; node = node->next)
+    {
+        job.nodes[i++] = node;
+    }
+
+    parallel_queue_init(&job.queue, job.num_blocks);
+    parallel_run(grep_worker, &job, job.num_nodes < GREP_MIN_PARALLEL ? 1 : (int)job.num_blocks);
+    int error = job.queue.failed;
+    parallel_queue_destroy(&job.queue);
+
+    // Blocks cover the list front to back, so joining them keeps list order
+    size_t total = 0;
+    for (size_t b = 0; b < job.num_blocks; b++)
+    {
+        total += job.blocks[b].count;
+    }
+    GrepMatch *result = NULL;
+    if (!error && total > 0)
+    {
+        result = (GrepMatch *)malloc(total * sizeof(GrepMatch));
+        if (result == NULL)
+        {
+            error = 1;
+        }
+    }
+
+    size_t position = 0;
+    for (size_t b = 0; b < job.num_blocks; b++)
+    {
+        if (result != NULL)
+        {
+            memcpy(result + position, job.blocks[b].matches, job.blocks[b].count * sizeof(GrepMatch));
+            position += job.blocks[b].count;
+        }
+        free(job.blocks[b].matches);
+    }
+    free(job.blocks);
+    free(job.nodes);
+
+    if (error)
+    {
+        free(result);
+        return -1;
+    }
+    *matches = result;
+    *count = total;
+    return 0;
+}
@@ -0,0 +1,48 @@
+#ifndef GREP_H
+#define GREP_H
+
+#include <stddef.h>
+
+#include "linked_list.h"
+
+/**
+ * @brief A function pointer type for a function that returns the text of a node's data.
+ * It is called from several threads at once, so it must not modify shared state.
+ * @param data A pointer to the data.
+ * @param scratch A per-thread buffer the text may be decoded into, grown with realloc.
+ * @param scratch_capacity The size of the scratch buffer.
+ * @param len Receives the text length.
+ * @return The text, never NULL.
+ */
+typedef const char *(*data_view_func)(const void *data, char **scratch, size_t *scratch_capacity, size_t *len);
+
+// A node whose text contains the pattern
+typedef struct GrepMatch
+{
+    Node *node;
+    size_t offset; // Where the first occurrence starts in the node's text
+} GrepMatch;
+
+/**
+ * @brief Finds the first occurrence of a byte string, comparing many positions per instruction where the CPU allows it.
+ * @param haystack The text to search.
+ * @param haystack_len The length of the text.
+ * @param needle The bytes to look for.
+ * @param needle_len The number of bytes to look for.
+ * @return The offset of the first occurrence, or -1 if there is none.
+ */
+long grep_find(const char *haystack, size_t haystack_len, const char *needle, size_t needle_len);
+
+/**
+ * @brief Scans the text of every node for a substring, spreading the list over all CPU cores.
+ * @param head The head of the linked list.
+ * @param pattern The bytes to look for.
+ * @param pattern_len The number of bytes to look for.
+ * @param view The function that returns a node's text.
+ * @param matches Receives an array of the matching nodes in list order (the caller must free it).
+ * @param count Receives the number of matching nodes.
+ * @return 0 on success, -1 on failure.
+ */
+int grep_list(Node *head, const char *pattern, size_t pattern_len, data_view_func view, GrepMatch **matches, size_t *count);
+
+#endif // GREP_H
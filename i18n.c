@@ -1,314 +1,390 @@
-#include "i18n.h"
-#include <stdio.h>
-#include <string.h>
 #include <ctype.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define STRINGS_TABLES // strings.h defines the tables in this file only
+#include "i18n.h"
+#include "file.h"
+
+const char *const *i18n_strings = string_table[0];
 
-// String hash function (djb2)
-static unsigned long hash_string(const char *str)
+// One value of a loaded file, kept until every key is known and the rows can be sized
+typedef struct StoreEntry
 {
-    unsigned long hash = 5381;
-    int c;
-    while ((c = *str++))
-        hash = ((hash << 5) + hash) + c; // hash * 33 + c
-    return hash;
-}
+    int language;
+    int key;
+    const char *value;
+} StoreEntry;
 
-// Helper to duplicate a string
-static char *custom_strdup(const char *s)
+// Every section of a strings file, next to the compiled-in ones
+typedef struct TranslationStore
 {
-    if (!s)
-        return NULL;
-    char *d = malloc(strlen(s) + 1);
-    if (!d)
-        return NULL;
-    strcpy(d, s);
-    return d;
+    char *text;         // The whole file, the names, codes and values are views into it
+    const char **names; // Key names by index, the compiled keys first so a StringKey indexes every row
+    int num_keys;
+    int names_capacity;
+    int *slots; // Open addressing over the names, key index + 1 or 0 for a free slot
+    int num_slots;
+    const char **codes; // Language codes by index, the compiled languages first
+    int num_languages;
+    const char **values; // One row of num_keys values per language, in one block
+} TranslationStore;
+
+static TranslationStore store;
+static int store_loaded = 0;
+static int active_language = 0;
+
+// FNV-1a, must stay the same as string_hash in tools/gen_strings.c
+static uint32_t string_hash(const char *key, uint32_t seed)
+{
+    uint32_t hash = 2166136261u ^ seed;
+    while (*key != '\0')
+    {
+        hash ^= (unsigned char)*key++;
+        hash *= 16777619u;
+    }
+    return hash;
 }
 
-// Helper to trim whitespace from start and end of a string (in-place)
 static char *trim_whitespace(char *str)
 {
-    char *end;
     while (isspace((unsigned char)*str))
+    {
         str++;
-    if (*str == 0)
-        return str;
-    end = str + strlen(str) - 1;
-    while (end > str && isspace((unsigned char)*end))
+    }
+    char *end = str + strlen(str);
+    while (end > str && isspace((unsigned char)end[-1]))
+    {
         end--;
-    end[1] = '\0';
+    }
+    *end = '\0';
     return str;
 }
 
-// Convert simple escape sequences (e.g., \n) into their literal characters in-place.
+// Convert simple escape sequences (e.g., \n) into their literal characters in-place, like tools/gen_strings does.
 static void unescape_in_place(char *str)
 {
     char *read = str;
     char *write = str;
-
-    while (*read)
+    while (*read != '\0')
     {
-        if (*read == '\\')
+        if (*read != '\\' || read[1] == '\0')
         {
-            read++;
-            if (*read == '\0')
-                break;
-
-            switch (*read)
-            {
-            case 'n':
-                *write++ = '\n';
-                break;
-            case 't':
-                *write++ = '\t';
-                break;
-            case 'r':
-                *write++ = '\r';
-                break;
-            case '\\':
-                *write++ = '\\';
-                break;
-            case '"':
-                *write++ = '"';
-                break;
-            default:
-                *write++ = '\\';
-                *write++ = *read;
-                break;
-            }
+            *write++ = *read++;
+            continue;
         }
-        else
+        read++;
+        switch (*read)
         {
+        case 'n':
+            *write++ = '\n';
+            break;
+        case 't':
+            *write++ = '\t';
+            break;
+        case 'r':
+            *write++ = '\r';
+            break;
+        case '\\':
+            *write++ = '\\';
+            break;
+        case '"':
+            *write++ = '"';
+            break;
+        default:
+            *write++ = '\\';
             *write++ = *read;
+            break;
         }
-
         read++;
     }
-
     *write = '\0';
 }
 
-// --- Public Function Implementations ---
-
-TranslationMap *i18n_create_map(int size)
+// Returns the slot holding the name, or the free slot it would go to
+static int find_slot(const TranslationStore *s, const char *name)
 {
-    if (size <= 0)
-        return NULL;
-
-    TranslationMap *map = malloc(sizeof(TranslationMap));
-    if (!map)
-        return NULL;
-
-    map->size = size;
-    // Use calloc to zero-initialize all bucket pointers to NULL
-    map->buckets = calloc(size, sizeof(TranslationEntry *));
-    if (!map->buckets)
+    int mask = s->num_slots - 1;
+    int slot = (int)(string_hash(name, 0) & (uint32_t)mask);
+    while (s->slots[slot] != 0 && strcmp(s->names[s->slots[slot] - 1], name) != 0)
     {
-        free(map);
-        return NULL;
+        slot = (slot + 1) & mask;
     }
-    return map;
+    return slot;
 }
 
-// Internal function to add a key/value pair to the map
-static void map_put(TranslationMap *map, const char *key, const char *value)
+// Doubles the slots so they stay at most half full
+static int grow_slots(TranslationStore *s)
 {
-    if (!map || !key || !value)
-        return;
-
-    unsigned long hash = hash_string(key);
-    int index = hash % map->size;
-
-    // Create the new entry
-    TranslationEntry *new_entry = malloc(sizeof(TranslationEntry));
-    if (!new_entry)
-        return; // Allocation failed
-
-    new_entry->key = custom_strdup(key);
-    new_entry->value = custom_strdup(value);
-    if (!new_entry->key || !new_entry->value)
+    int num_slots = s->num_slots ? s->num_slots * 2 : 64;
+    int *slots = (int *)calloc(num_slots, sizeof(int));
+    if (slots == NULL)
     {
-        free(new_entry->key);
-        free(new_entry->value);
-        free(new_entry);
-        return; // Allocation failed
+        return -1; // Memory allocation failed
     }
-
-    // Insert at the head of the chain (collision)
-    new_entry->next = map->buckets[index];
-    map->buckets[index] = new_entry;
+    free(s->slots);
+    s->slots = slots;
+    s->num_slots = num_slots;
+    for (int key = 0; key < s->num_keys; key++)
+    {
+        s->slots[find_slot(s, s->names[key])] = key + 1;
+    }
+    return 0;
 }
 
-int i18n_load_translations(const char *filepath, TranslationMap *map, const char *language)
+// Returns the index of a key name, adding it if it is new
+static int store_key(TranslationStore *s, const char *name)
 {
-    FILE *file = fopen(filepath, "r");
-    if (!file)
+    if (s->num_slots > 0)
+    {
+        int slot = find_slot(s, name);
+        if (s->slots[slot] != 0)
+        {
+            return s->slots[slot] - 1;
+        }
+    }
+    if ((s->num_keys + 1) * 2 > s->num_slots && grow_slots(s) != 0)
     {
-        perror("Error opening translation file");
         return -1;
     }
+    if (s->num_keys == s->names_capacity)
+    {
+        int capacity = s->names_capacity * 2;
+        const char **names = (const char **)realloc((void *)s->names, capacity * sizeof(char *));
+        if (names == NULL)
+        {
+            return -1; // Memory allocation failed
+        }
+        s->names = names;
+        s->names_capacity = capacity;
+    }
+    s->names[s->num_keys] = name;
+    s->slots[find_slot(s, name)] = s->num_keys + 1;
+    return s->num_keys++;
+}
 
-    char line[512];
-    char target_section[70];
-    snprintf(target_section, sizeof(target_section), "[%s]", language);
+// Returns the index of a language code, adding it if it is new
+static int store_language(TranslationStore *s, const char *code)
+{
+    for (int i = 0; i < s->num_languages; i++)
+    {
+        if (strcmp(s->codes[i], code) == 0)
+        {
+            return i;
+        }
+    }
+    const char **codes = (const char **)realloc((void *)s->codes, (s->num_languages + 1) * sizeof(char *));
+    if (codes == NULL)
+    {
+        return -1; // Memory allocation failed
+    }
+    s->codes = codes;
+    s->codes[s->num_languages] = code;
+    return s->num_languages++;
+}
 
-    int reading_target_lang = 0;
+static void store_free(TranslationStore *s)
+{
+    free(s->text);
+    free((void *)s->names);
+    free(s->slots);
+    free((void *)s->codes);
+    free((void *)s->values);
+    memset(s, 0, sizeof(*s));
+}
 
-    while (fgets(line, sizeof(line), file))
+// Splits the text into lines in place and records every value of every section
+static int parse_store(TranslationStore *s, StoreEntry **entries, size_t *num_entries)
+{
+    size_t capacity = 0;
+    int language = -1;
+    char *line = s->text;
+    while (*line != '\0')
     {
-        char *trimmed_line = trim_whitespace(line);
+        char *line_end = strchr(line, '\n');
+        char *next = line_end != NULL ? line_end + 1 : line + strlen(line);
+        if (line_end != NULL)
+        {
+            *line_end = '\0';
+        }
+        char *trimmed = trim_whitespace(line);
+        line = next;
 
-        // Skip comments and empty lines
-        if (trimmed_line[0] == '#' || trimmed_line[0] == '\0')
+        if (trimmed[0] == '#' || trimmed[0] == '\0')
         {
             continue;
         }
-
-        // Check for a new section
-        if (trimmed_line[0] == '[')
+        if (trimmed[0] == '[')
         {
-            if (strcmp(trimmed_line, target_section) == 0)
+            char *close = strchr(trimmed, ']');
+            if (close == NULL || close == trimmed + 1)
             {
-                reading_target_lang = 1; // Found our language
+                language = -1; // Not a section we can name, its values are skipped
+                continue;
             }
-            else
+            *close = '\0';
+            language = store_language(s, trimmed + 1);
+            if (language < 0)
             {
-                reading_target_lang = 0; // Not our language
+                return -1;
             }
             continue;
         }
 
-        // If we are in the target section, parse the key-value pair
-        if (reading_target_lang)
+        char *equals = strchr(trimmed, '=');
+        if (language < 0 || equals == NULL)
         {
-            char *equals = strchr(trimmed_line, '=');
-            if (equals)
-            {
-                *equals = '\0'; // Split the string at '='
-                char *key = trim_whitespace(trimmed_line);
-                char *value = trim_whitespace(equals + 1);
-                unescape_in_place(value);
+            continue;
+        }
+        *equals = '\0';
+        char *key = trim_whitespace(trimmed);
+        char *value = trim_whitespace(equals + 1);
+        if (key[0] == '\0')
+        {
+            continue;
+        }
+        unescape_in_place(value);
 
-                if (key[0] != '\0')
-                {
-                    map_put(map, key, value);
-                }
+        if (*num_entries == capacity)
+        {
+            capacity = capacity ? capacity * 2 : 64;
+            StoreEntry *grown = (StoreEntry *)realloc(*entries, capacity * sizeof(StoreEntry));
+            if (grown == NULL)
+            {
+                return -1; // Memory allocation failed
             }
+            *entries = grown;
+        }
+        StoreEntry *entry = &(*entries)[(*num_entries)++];
+        entry->language = language;
+        entry->key = store_key(s, key);
+        entry->value = value;
+        if (entry->key < 0)
+        {
+            return -1;
         }
     }
-
-    fclose(file);
     return 0;
 }
 
-const char *i18n_get_string(const TranslationMap *map, const char *key)
+int i18n_load(const char *path)
 {
-    if (!map || !key)
-        return key; // Fallback to key
+    if (path == NULL)
+    {
+        return -1; // Invalid input
+    }
+    TranslationStore loaded;
+    memset(&loaded, 0, sizeof(loaded));
+    loaded.text = read_file(path);
+    loaded.names_capacity = STRING_COUNT * 2;
+    loaded.names = (const char **)malloc(loaded.names_capacity * sizeof(char *));
+    if (loaded.text == NULL || loaded.names == NULL)
+    {
+        store_free(&loaded);
+        return -1; // File could not be read or memory allocation failed
+    }
 
-    unsigned long hash = hash_string(key);
-    int index = hash % map->size;
+    // The compiled keys and languages keep their numbers, so _() indexes the loaded rows too
+    int status = 0;
+    for (int key = 0; key < STRING_COUNT && status == 0; key++)
+    {
+        status = store_key(&loaded, string_keys[key]) == key ? 0 : -1;
+    }
+    for (int language = 0; language < LANGUAGE_COUNT && status == 0; language++)
+    {
+        status = store_language(&loaded, language_codes[language]) == language ? 0 : -1;
+    }
+    StoreEntry *entries = NULL;
+    size_t num_entries = 0;
+    if (status == 0)
+    {
+        status = parse_store(&loaded, &entries, &num_entries);
+    }
+    if (status == 0)
+    {
+        loaded.values = (const char **)malloc((size_t)loaded.num_languages * loaded.num_keys * sizeof(char *));
+        status = loaded.values != NULL ? 0 : -1;
+    }
+    if (status != 0)
+    {
+        free(entries);
+        store_free(&loaded);
+        return -1;
+    }
 
-    TranslationEntry *entry = map->buckets[index];
-    while (entry)
+    // A value the file leaves out is the compiled one, or the key name for a key or language that is not compiled in
+    for (int language = 0; language < loaded.num_languages; language++)
     {
-        if (strcmp(entry->key, key) == 0)
+        const char **row = loaded.values + (size_t)language * loaded.num_keys;
+        for (int key = 0; key < loaded.num_keys; key++)
         {
-            return entry->value;
+            row[key] = language < LANGUAGE_COUNT && key < STRING_COUNT ? string_table[language][key] : loaded.names[key];
         }
-        entry = entry->next;
     }
+    for (size_t i = 0; i < num_entries; i++)
+    {
+        loaded.values[(size_t)entries[i].language * loaded.num_keys + entries[i].key] = entries[i].value;
+    }
+    free(entries);
 
-    return key; // Fallback: key not found
+    i18n_unload();
+    store = loaded;
+    store_loaded = 1;
+    i18n_strings = store.values + (size_t)active_language * store.num_keys;
+    return 0;
 }
 
-void i18n_free_map(TranslationMap *map)
+void i18n_unload(void)
 {
-    if (!map)
+    if (!store_loaded)
+    {
         return;
+    }
+    store_free(&store);
+    store_loaded = 0;
+    active_language = active_language < LANGUAGE_COUNT ? active_language : 0;
+    i18n_strings = string_table[active_language];
+}
 
-    for (int i = 0; i < map->size; i++)
+int i18n_set_language(const char *language)
+{
+    if (language == NULL)
     {
-        TranslationEntry *entry = map->buckets[i];
-        while (entry)
+        return -1; // Invalid input
+    }
+    int count = store_loaded ? store.num_languages : LANGUAGE_COUNT;
+    for (int i = 0; i < count; i++)
+    {
+        if (strcmp(store_loaded ? store.codes[i] : language_codes[i], language) == 0)
         {
-            TranslationEntry *next = entry->next;
-            free(entry->key);
-            free(entry->value);
-            free(entry);
-            entry = next;
+            active_language = i;
+            i18n_strings = store_loaded ? store.values + (size_t)i * store.num_keys : string_table[i];
+            return 0;
         }
     }
-    free(map->buckets);
-    free(map);
+    return -1; // No such section
 }
 
-int i18n_load_translations_from_memory(const char *buffer, TranslationMap *map, const char *language)
+int i18n_key(const char *name)
 {
-    if (!buffer || !map || !language)
-        return -1;
-
-    char line[512];
-    char target_section[70];
-    snprintf(target_section, sizeof(target_section), "[%s]", language);
-
-    int reading_target_lang = 0;
-    const char *line_start = buffer;
-
-    while (*line_start != '\0')
+    if (name == NULL)
     {
-        const char *line_end = strchr(line_start, '\n');
-        size_t line_len;
-
-        if (line_end)
-        {
-            line_len = line_end - line_start;
-        }
-        else
-        {
-            line_len = strlen(line_start);
-            line_end = line_start + line_len;
-        }
-
-        if (line_len < sizeof(line))
-        {
-            strncpy(line, line_start, line_len);
-            line[line_len] = '\0';
-
-            char *trimmed_line = trim_whitespace(line);
-
-            if (trimmed_line[0] != '#' && trimmed_line[0] != '\0')
-            {
-                if (trimmed_line[0] == '[')
-                {
-                    reading_target_lang = (strcmp(trimmed_line, target_section) == 0);
-                }
-                else if (reading_target_lang)
-                {
-                    char *equals = strchr(trimmed_line, '=');
-                    if (equals)
-                    {
-                        *equals = '\0';
-                        char *key = trim_whitespace(trimmed_line);
-                        char *value = trim_whitespace(equals + 1);
-                        unescape_in_place(value);
-                        if (key[0] != '\0')
-                        {
-                            map_put(map, key, value);
-                        }
-                    }
-                }
-            }
-        }
-
-        if (*line_end == '\n')
-        {
-            line_start = line_end + 1;
-        }
-        else
-        {
-            line_start = line_end;
-        }
+        return -1; // Invalid input
     }
-    return 0;
-}
\ No newline at end of file
+    if (store_loaded)
+    {
+        int slot = find_slot(&store, name);
+        return store.slots[slot] - 1;
+    }
+    // The perfect hash sends every key to its own slot, anything else is caught by the one comparison
+    uint32_t seed = string_seeds[string_hash(name, 0) % STRING_COUNT];
+    uint32_t slot = string_hash(name, seed) % STRING_COUNT;
+    return strcmp(string_keys[slot], name) == 0 ? (int)slot : -1;
+}
+
+const char *i18n_get_string(const char *name)
+{
+    int key = i18n_key(name);
+    return key >= 0 ? i18n_strings[key] : name; // Fallback: key not found
+}
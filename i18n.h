@@ -1,60 +1,44 @@
 #ifndef I18N_H
 #define I18N_H
 
-#include <stdlib.h>
-
-// A single entry in the hash map (uses chaining for collisions)
-typedef struct TranslationEntry
-{
-    char *key;
-    char *value;
-    struct TranslationEntry *next;
-} TranslationEntry;
-
-// The hash map structure
-typedef struct
-{
-    int size;
-    TranslationEntry **buckets;
-} TranslationMap;
+#include "strings.h"
+
+// The strings of the active language, indexed by StringKey. Points at the first section of strings.ini until i18n_set_language picks another.
+extern const char *const *i18n_strings;
 
 /**
- * @brief Creates a new, empty translation map.
- * @param size The number of buckets (a prime number is good, e.g., 101).
- * @return A pointer to the new TranslationMap, or NULL on failure.
+ * @brief Loads every section of a strings file (in the format of strings.ini) next to the compiled-in languages.
+ * The file is read into one buffer that the strings point into, every language of it stays loaded.
+ * Sections named like a compiled-in language override its strings, keys the file leaves out keep the compiled ones.
+ * @param path Path to the .ini file.
+ * @return 0 on success, -1 on failure (e.g., file not found). The compiled-in strings stay in use on failure.
  */
-TranslationMap *i18n_create_map(int size);
+int i18n_load(const char *path);
 
 /**
- * @brief Loads translations from a file for a specific language.
- * @param filepath Path to the .ini file.
- * @param map The map to load strings into.
- * @param language The language code to load (e.g., "en", "es").
- * @return 0 on success, -1 on failure (e.g., file not found).
+ * @brief Drops the strings i18n_load loaded and goes back to the compiled-in ones.
  */
-int i18n_load_translations(const char *filepath, TranslationMap *map, const char *language);
+void i18n_unload(void);
 
 /**
- * @brief Gets a translated string from the map.
- * @param map The map containing the translations.
- * @param key The key of the string to find (e.g., "GREETING").
- * @return The translated string. If not found, returns the key itself as a fallback.
+ * @brief Makes a language the active one. Every language stays loaded, so this only moves i18n_strings.
+ * @param language The language code, the name of a section in strings.ini (e.g., "en").
+ * @return 0 on success, -1 if there is no such language.
  */
-const char *i18n_get_string(const TranslationMap *map, const char *key);
+int i18n_set_language(const char *language);
 
 /**
- * @brief Frees all memory associated with the translation map.
- * @param map The map to free.
+ * @brief Finds a key by its name, for keys that are only known at runtime.
+ * @param name The key name (e.g., "cmd_next").
+ * @return The key, or -1 if strings.ini has no such key.
  */
-void i18n_free_map(TranslationMap *map);
+int i18n_key(const char *name);
 
 /**
- * @brief Loads translations from an in-memory string buffer.
- * @param buffer A null-terminated string containing the INI data.
- * @param map The map to load strings into.
- * @param language The language code to load (e.g., "en", "es").
- * @return 0 on success, -1 on failure.
+ * @brief Gets a translated string by key name from the active language.
+ * @param name The key name.
+ * @return The translated string. If not found, returns the name itself as a fallback.
  */
-int i18n_load_translations_from_memory(const char *buffer, TranslationMap *map, const char *language);
+const char *i18n_get_string(const char *name);
 
-#endif // I18N_H
\ No newline at end of file
+#endif // I18N_H
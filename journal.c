@@ -0,0 +1,758 @@
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "journal.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#endif
+
+#include "file.h"
+#include "trace.h"
+
+#define JOURNAL_MAGIC "DIARYLOG 1"
+
+// Parses the header line, returns the offset of the first operation or -1 if it is not a journal
+static long parse_header(const char *log, long *size, long long *mtime)
+{
+    int consumed = 0;
+    if (sscanf(log, JOURNAL_MAGIC " %ld %lld%n", size, mtime, &consumed) != 2 || log[consumed] != '\n')
+    {
+        return -1; // Not a journal
+    }
+    return consumed + 1;
+}
+
+// Parses the header line, returns the offset of the first operation or -1 if it does not match the snapshot
+static long check_header(const char *log, const char *snapshot_path)
+{
+    long size = 0;
+    long long mtime = 0;
+    long offset = parse_header(log, &size, &mtime);
+    if (offset < 0)
+    {
+        return -1; // Not a journal
+    }
+
+    long stamp_size = 0;
+    long long stamp_mtime = 0;
+    // A log written against an older snapshot (crash between snapshot and reset) must not be replayed twice
+    file_stamp(snapshot_path, &stamp_size, &stamp_mtime);
+    if (size != stamp_size || mtime != stamp_mtime)
+    {
+        return -1; // Journal belongs to another snapshot
+    }
+    return offset;
+}
+
+static char *read_log(const char *path, long *size)
+{
+    FILE *file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        return NULL;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long file_size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (file_size < 0)
+    {
+        fclose(file);
+        return NULL;
+    }
+
+    char *buffer = (char *)malloc(file_size + 1);
+    if (buffer == NULL)
+    {
+        fclose(file);
+        return NULL;
+    }
+
+    *size = (long)fread(buffer, 1, file_size, file);
+    buffer[*size] = '\0';
+    fclose(file);
+    TRACE_COUNT(TRACE_BYTES_READ, *size);
+    return buffer;
+}
+
+// One operation read back from the log
+typedef struct JournalOp
+{
+    char type;           // 'I' insert after a node, 'A' append at the tail, 'U' update, 'D' delete, 'S' snapshot taken
+    unsigned long id;    // The node to insert after (0 for the head), to update or to delete, the record count of a snapshot
+    const char *payload; // The serialized record of an insert, append or update
+    unsigned long len;
+} JournalOp;
+
+// Parses the operation at *ptr and moves past it. Returns 0 on success, 1 if the log
+// ends in the middle of the operation (crash mid-append), -1 if it is not an operation.
+static int parse_op(char **ptr, char *end, JournalOp *op)
+{
+    char *line_end = (char *)memchr(*ptr, '\n', end - *ptr);
+    if (line_end == NULL)
+    {
+        return 1;
+    }
+
+    memset(op, 0, sizeof(JournalOp));
+    op->type = **ptr;
+    char *num_end = *ptr + 1;
+    if (op->type == 'I' || op->type == 'U' || op->type == 'D' || op->type == 'S')
+    {
+        op->id = strtoul(num_end, &num_end, 10);
+    }
+
+    if (op->type == 'I' || op->type == 'A' || op->type == 'U')
+    {
+        op->len = strtoul(num_end, &num_end, 10);
+        char *payload = line_end + 1;
+        if (num_end != line_end || op->len >= (unsigned long)(end - payload) || payload[op->len] != '\n')
+        {
+            return 1;
+        }
+        op->payload = payload;
+        *ptr = payload + op->len + 1;
+        return 0;
+    }
+    if (op->type == 'D' || op->type == 'S')
+    {
+        if (num_end != line_end)
+        {
+            return 1;
+        }
+        *ptr = line_end + 1;
+        return 0;
+    }
+    return -1;
+}
+
+// Appends a node to the id -> node table, its index becomes the node's id
+static int push_node(Node ***nodes, size_t *count, size_t *capacity, Node *node)
+{
+    if (*count == *capacity)
+    {
+        Node **grown = (Node **)realloc(*nodes, *capacity * 2 * sizeof(Node *));
+        if (grown == NULL)
+        {
+            return -1; // Memory allocation failed
+        }
+        *nodes = grown;
+        *capacity *= 2;
+    }
+    node->id = (unsigned int)*count;
+    (*nodes)[(*count)++] = node;
+    return 0;
+}
+
+// Numbers the list 1..n in order, the way a snapshot of it is numbered
+static int number_nodes(Node *head, Node ***nodes, size_t *count, size_t *capacity)
+{
+    *count = 1;
+    for (Node *node = head; node != NULL; node = node->next)
+    {
+        if (push_node(nodes, count, capacity, node) != 0)
+        {
+            return -1; // Memory allocation failed
+        }
+    }
+    return 0;
+}
+
+// A log whose header names an older snapshot is normally stale. If its last snapshot
+// marker is for a list as long as the current snapshot, that snapshot was written from the
+// marker and the log was not rebased yet (crash in between), so the operations after
+// the marker still apply. Earlier markers belong to snapshots that failed to write.
+// Returns where the operations start, or NULL. A negative length matches any marker.
+static char *find_marker(char *log, char *end, long snapshot_length)
+{
+    long size = 0;
+    long long mtime = 0;
+    long offset = parse_header(log, &size, &mtime);
+    if (offset < 0)
+    {
+        return NULL; // Not a journal
+    }
+
+    char *ptr = log + offset;
+    char *found = NULL;
+    unsigned long count = 0;
+    while (ptr < end)
+    {
+        JournalOp op;
+        if (parse_op(&ptr, end, &op) != 0)
+        {
+            break; // A torn tail is dropped by the replay
+        }
+        if (op.type == 'S')
+        {
+            found = ptr;
+            count = op.id;
+        }
+    }
+    return found != NULL && (snapshot_length < 0 || count == (unsigned long)snapshot_length) ? found : NULL;
+}
+
+int journal_replay(const char *path,
+                   const char *snapshot_path,
+                   Node **head,
+                   Node **tail,
+                   int *length,
+                   json_deserializer deserializer,
+                   alloc_data_func alloc_data,
+                   free_data_func free_data,
+                   unsigned int *next_id)
+{
+    if (path == NULL || head == NULL || tail == NULL || length == NULL || deserializer == NULL ||
+        free_data == NULL || next_id == NULL || alloc_data == NULL)
+    {
+        return -1; // Invalid input
+    }
+
+    // Id -> node table, slot 0 stands for "before the head"
+    size_t capacity = 64;
+    size_t count = 1;
+    Node **nodes = (Node **)malloc(capacity * sizeof(Node *));
+    if (nodes == NULL)
+    {
+        return -1; // Memory allocation failed
+    }
+    nodes[0] = NULL;
+
+    // Snapshot records are numbered in order
+    if (number_nodes(*head, &nodes, &count, &capacity) != 0)
+    {
+        free(nodes);
+        return -1; // Memory allocation failed
+    }
+    *next_id = (unsigned int)count;
+
+    long log_size = 0;
+    char *log = read_log(path, &log_size);
+    long offset = log != NULL ? check_header(log, snapshot_path) : -1;
+    char *ptr = offset >= 0 ? log + offset : NULL;
+    char *end = log != NULL ? log + log_size : NULL;
+    int result = 0;
+    if (ptr == NULL && log != NULL)
+    {
+        ptr = find_marker(log, end, *length);
+        result = ptr != NULL ? 1 : 0; // Needs compacting, opening the log would reset it
+    }
+    if (ptr == NULL)
+    {
+        free(nodes);
+        free(log);
+        return 0; // No journal to replay
+    }
+
+    while (ptr < end)
+    {
+        JournalOp op;
+        int parsed = parse_op(&ptr, end, &op);
+        if (parsed != 0)
+        {
+            result = parsed; // 1 for a torn operation
+            break;
+        }
+
+        if (op.type == 'S')
+        {
+            // A snapshot was taken here, later operations use its numbering
+            if (op.id != (unsigned long)*length || number_nodes(*head, &nodes, &count, &capacity) != 0)
+            {
+                result = -1;
+                break;
+            }
+            continue;
+        }
+
+        if (op.type == 'D')
+        {
+            if (op.id == 0 || op.id >= count || nodes[op.id] == NULL)
+            {
+                result = -1; // Delete of an unknown record
+                break;
+            }
+
+            Node *deleted = nodes[op.id];
+            ll_delete_node(&deleted, head, tail, free_data);
+            nodes[op.id] = NULL;
+            (*length)--;
+            continue;
+        }
+
+        if (op.type == 'I' && (op.id >= count || (op.id != 0 && nodes[op.id] == NULL)))
+        {
+            result = -1; // Insert after an unknown record
+            break;
+        }
+        if (op.type == 'U' && (op.id == 0 || op.id >= count || nodes[op.id] == NULL))
+        {
+            result = -1; // Update of an unknown record
+            break;
+        }
+
+        void *data = alloc_data();
+        if (data == NULL)
+        {
+            result = -1; // Memory allocation failed
+            break;
+        }
+        JsonCursor cursor;
+        json_cursor_init(&cursor, op.payload, op.len);
+        if (deserializer(data, &cursor) != 0)
+        {
+            free_data(data);
+            result = -1; // Deserialization failed
+            break;
+        }
+
+        if (op.type == 'U')
+        {
+            // The record is replaced whole, the node and its id stay
+            free_data(nodes[op.id]->data);
+            nodes[op.id]->data = data;
+            continue;
+        }
+
+        // Slot 0 of the table is NULL, so an insert after id 0 goes in front of the head
+        Node *after = op.type == 'A' ? *tail : nodes[op.id];
+        Node *inserted = NULL;
+        if (after == NULL)
+        {
+            inserted = ll_create_node(data);
+            if (inserted != NULL)
+            {
+                inserted->next = *head;
+                if (*head != NULL)
+                {
+                    (*head)->prev = inserted;
+                }
+                *head = inserted;
+                if (*tail == NULL)
+                {
+                    *tail = inserted;
+                }
+            }
+        }
+        else
+        {
+            Node *previous_next = after->next;
+            ll_insert_after(after, data, tail);
+            inserted = after->next != previous_next ? after->next : NULL;
+        }
+        if (inserted == NULL || push_node(&nodes, &count, &capacity, inserted) != 0)
+        {
+            if (inserted == NULL)
+            {
+                free_data(data);
+            }
+            result = -1; // Memory allocation failed
+            break;
+        }
+        (*length)++;
+    }
+
+    *next_id = (unsigned int)count;
+    free(nodes);
+    free(log);
+    return result;
+}
+
+int journal_open(Journal *journal, const char *path, const char *snapshot_path, const SyncPolicy *sync)
+{
+    if (journal == NULL || path == NULL)
+    {
+        return -1; // Invalid input
+    }
+
+    memset(journal, 0, sizeof(Journal));
+    if (sync != NULL)
+    {
+        journal->sync = *sync;
+    }
+    size_t path_len = strlen(path);
+    journal->path = (char *)malloc(path_len + 1);
+    if (journal->path == NULL)
+    {
+        return -1; // Memory allocation failed
+    }
+    memcpy(journal->path, path, path_len + 1);
+
+    char header[128] = {0};
+    FILE *file = fopen(path, "rb");
+    if (file != NULL)
+    {
+        if (fgets(header, sizeof(header), file) == NULL)
+        {
+            header[0] = '\0';
+        }
+        fclose(file);
+    }
+
+    if (check_header(header, snapshot_path) < 0)
+    {
+        return journal_reset(journal, snapshot_path); // Start a fresh log
+    }
+
+    journal->file = fopen(path, "ab");
+    if (journal->file == NULL)
+    {
+        return -1; // File could not be opened for appending
+    }
+    fseek(journal->file, 0, SEEK_END);
+    journal->size = ftell(journal->file);
+    return 0;
+}
+
+static long long now_ms(void)
+{
+#if defined(_WIN32)
+    return (long long)GetTickCount64();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+#endif
+}
+
+// Forces the log to disk if the sync policy asks for it after this many waiting operations
+static int sync_if_due(Journal *journal)
+{
+    if (journal->unsynced == 0 || journal->sync.mode == SYNC_NEVER)
+    {
+        return 0;
+    }
+    if (journal->sync.mode == SYNC_GROUP)
+    {
+        // Without a timer, an operation that passes the interval also takes the ones before it along
+        int due = (journal->sync.max_ops > 0 && journal->unsynced >= journal->sync.max_ops) ||
+                  (journal->sync.max_ms > 0 && now_ms() - journal->unsynced_since >= journal->sync.max_ms);
+        if (!due)
+        {
+            return 0;
+        }
+    }
+    return journal_sync(journal);
+}
+
+// Writes one complete operation and pushes it to the OS, or to disk as the sync policy says
+static int journal_write(Journal *journal, const char *header, const char *payload, size_t payload_len)
+{
+    if (journal->file == NULL)
+    {
+        return -1; // Journal is not open
+    }
+
+    size_t header_len = strlen(header);
+    if (fwrite(header, 1, header_len, journal->file) != header_len ||
+        (payload != NULL && (fwrite(payload, 1, payload_len, journal->file) != payload_len ||
+                             fputc('\n', journal->file) == EOF)) ||
+        fflush(journal->file) != 0)
+    {
+        return -1; // Write failed, the torn tail is dropped on replay
+    }
+
+    journal->size += (long)(header_len + (payload != NULL ? payload_len + 1 : 0));
+    TRACE_COUNT(TRACE_BYTES_WRITTEN, header_len + (payload != NULL ? payload_len + 1 : 0));
+    journal->num_ops++;
+    if (journal->unsynced++ == 0 && journal->sync.mode == SYNC_GROUP)
+    {
+        journal->unsynced_since = now_ms();
+    }
+    return sync_if_due(journal);
+}
+
+// Appends an insert ('I'), append ('A') or update ('U') operation carrying a serialized record
+static int journal_write_record(Journal *journal, char type, unsigned int id, void *data, json_serializer serializer)
+{
+    if (journal == NULL || data == NULL || serializer == NULL)
+    {
+        return -1; // Invalid input
+    }
+
+    Writer writer;
+    writer_init_memory(&writer);
+    if (serializer(data, &writer) != 0 || writer.error)
+    {
+        writer_close(&writer);
+        return -1; // Serialization failed
+    }
+
+    char header[64];
+    if (type == 'A')
+    {
+        snprintf(header, sizeof(header), "A %lu\n", (unsigned long)writer.used);
+    }
+    else
+    {
+        snprintf(header, sizeof(header), "%c %u %lu\n", type, id, (unsigned long)writer.used);
+    }
+    int result = journal_write(journal, header, writer.buffer ? writer.buffer : "", writer.used);
+    writer_close(&writer);
+    return result;
+}
+
+int journal_append_insert(Journal *journal, unsigned int after_id, void *data, json_serializer serializer)
+{
+    return journal_write_record(journal, 'I', after_id, data, serializer);
+}
+
+int journal_append_tail(Journal *journal, void *data, json_serializer serializer)
+{
+    return journal_write_record(journal, 'A', 0, data, serializer);
+}
+
+int journal_append_update(Journal *journal, unsigned int id, void *data, json_serializer serializer)
+{
+    if (id == 0)
+    {
+        return -1; // Invalid input
+    }
+    return journal_write_record(journal, 'U', id, data, serializer);
+}
+
+int journal_check(const char *path, const char *snapshot_path)
+{
+    long log_size = 0;
+    char *log = path != NULL ? read_log(path, &log_size) : NULL;
+    long offset = log != NULL ? check_header(log, snapshot_path) : -1;
+    if (offset < 0)
+    {
+        // Operations after a snapshot marker still apply, they must be replayed before a fresh log is started
+        int marked = log != NULL && find_marker(log, log + log_size, -1) != NULL;
+        free(log);
+        return marked;
+    }
+
+    int result = 0;
+    char *ptr = log + offset;
+    char *end = log + log_size;
+    while (ptr < end && result == 0)
+    {
+        JournalOp op;
+        result = parse_op(&ptr, end, &op);
+    }
+    free(log);
+    return result;
+}
+
+int journal_empty(const char *path, const char *snapshot_path)
+{
+    FILE *file = path != NULL ? fopen(path, "rb") : NULL;
+    if (file == NULL)
+    {
+        return 1; // No log
+    }
+
+    char header[128] = {0};
+    long offset = fgets(header, sizeof(header), file) != NULL ? check_header(header, snapshot_path) : -1;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fclose(file);
+    return offset >= 0 && size == offset;
+}
+
+int journal_append_delete(Journal *journal, unsigned int id)
+{
+    if (journal == NULL || id == 0)
+    {
+        return -1; // Invalid input
+    }
+
+    char header[32];
+    snprintf(header, sizeof(header), "D %u\n", id);
+    return journal_write(journal, header, NULL, 0);
+}
+
+int journal_mark(Journal *journal, unsigned int count)
+{
+    if (journal == NULL)
+    {
+        return -1; // Invalid input
+    }
+
+    char header[32];
+    snprintf(header, sizeof(header), "S %u\n", count);
+    if (journal_write(journal, header, NULL, 0) != 0)
+    {
+        // Operations after an older marker do not match the snapshot this one was for
+        journal->mark = 0;
+        journal->mark_ops = 0;
+        return -1;
+    }
+    journal->mark = journal->size;
+    journal->mark_ops = journal->num_ops;
+    return 0;
+}
+
+int journal_rebase(Journal *journal, const char *snapshot_path)
+{
+    if (journal == NULL || journal->path == NULL)
+    {
+        return -1; // Invalid input
+    }
+    if (journal->mark <= 0 || journal->file == NULL)
+    {
+        return journal_reset(journal, snapshot_path);
+    }
+
+    // The operations after the marker are copied into a new log behind a header for the new snapshot
+    long tail_size = journal->size - journal->mark;
+    char *tail = (char *)malloc((size_t)tail_size + 1);
+    FILE *file = tail != NULL ? fopen(journal->path, "rb") : NULL;
+    int result = file != NULL && fseek(file, journal->mark, SEEK_SET) == 0 &&
+                         fread(tail, 1, (size_t)tail_size, file) == (size_t)tail_size
+                     ? 0
+                     : -1;
+    if (file != NULL)
+    {
+        fclose(file);
+    }
+
+    size_t path_len = strlen(journal->path);
+    char *temp_path = result == 0 ? (char *)malloc(path_len + 5) : NULL;
+    if (temp_path == NULL)
+    {
+        free(tail);
+        return journal_reset(journal, snapshot_path); // The operations are in the list, the next snapshot keeps them
+    }
+    memcpy(temp_path, journal->path, path_len);
+    memcpy(temp_path + path_len, ".tmp", 5);
+
+    long size = 0;
+    long long mtime = 0;
+    file_stamp(snapshot_path, &size, &mtime);
+    char header[128];
+    snprintf(header, sizeof(header), JOURNAL_MAGIC " %ld %lld\n", size, mtime);
+    size_t header_len = strlen(header);
+
+    // The old log is replaced, so the new one has to be on disk before the rename
+    file = fopen(temp_path, "wb");
+    if (file == NULL || fwrite(header, 1, header_len, file) != header_len ||
+        fwrite(tail, 1, (size_t)tail_size, file) != (size_t)tail_size ||
+        (journal->sync.mode != SYNC_NEVER && sync_file(file) != 0))
+    {
+        result = -1;
+    }
+    if (file != NULL && fclose(file) != 0)
+    {
+        result = -1;
+    }
+    free(tail);
+
+    // Until the rename the old log still replays the same operations from its marker
+    fclose(journal->file);
+    journal->file = NULL;
+    if (result != 0 || replace_file(temp_path, journal->path) != 0)
+    {
+        remove(temp_path);
+        free(temp_path);
+        return journal_reset(journal, snapshot_path);
+    }
+    free(temp_path);
+    if (journal->sync.mode != SYNC_NEVER)
+    {
+        sync_dir(journal->path);
+    }
+    journal->unsynced = 0;
+
+    journal->file = fopen(journal->path, "ab");
+    if (journal->file == NULL)
+    {
+        return -1; // File could not be opened for appending
+    }
+    journal->size = (long)header_len + tail_size;
+    journal->num_ops -= journal->mark_ops;
+    journal->mark = 0;
+    journal->mark_ops = 0;
+    return 0;
+}
+
+int journal_reset(Journal *journal, const char *snapshot_path)
+{
+    if (journal == NULL || journal->path == NULL)
+    {
+        return -1; // Invalid input
+    }
+
+    if (journal->file != NULL)
+    {
+        fclose(journal->file);
+    }
+    journal->size = 0;
+    journal->num_ops = 0;
+    journal->mark = 0;
+    journal->mark_ops = 0;
+    journal->unsynced = 0;
+
+    journal->file = fopen(journal->path, "wb");
+    if (journal->file == NULL)
+    {
+        return -1; // File could not be opened for writing
+    }
+
+    long size = 0;
+    long long mtime = 0;
+    file_stamp(snapshot_path, &size, &mtime);
+
+    char header[128];
+    snprintf(header, sizeof(header), JOURNAL_MAGIC " %ld %lld\n", size, mtime);
+    int result = journal_write(journal, header, NULL, 0);
+    journal->num_ops = 0;
+    return result;
+}
+
+int journal_sync(Journal *journal)
+{
+    if (journal == NULL || journal->file == NULL)
+    {
+        return -1; // Journal is not open
+    }
+    if (sync_file(journal->file) != 0)
+    {
+        return -1;
+    }
+    journal->unsynced = 0;
+    return 0;
+}
+
+long journal_sync_due(Journal *journal)
+{
+    if (journal == NULL || journal->file == NULL || journal->unsynced == 0 || journal->sync.mode != SYNC_GROUP ||
+        journal->sync.max_ms <= 0)
+    {
+        return -1; // Nothing waits for a time limit
+    }
+    long long left = journal->unsynced_since + journal->sync.max_ms - now_ms();
+    if (left > 0)
+    {
+        return (long)left;
+    }
+    return journal_sync(journal) == 0 ? -1 : journal->sync.max_ms; // A failed sync is tried again later
+}
+
+void journal_close(Journal *journal)
+{
+    if (journal == NULL)
+    {
+        return;
+    }
+
+    if (journal->file != NULL)
+    {
+        if (journal->unsynced > 0 && journal->sync.mode != SYNC_NEVER)
+        {
+            journal_sync(journal);
+        }
+        fclose(journal->file);
+        journal->file = NULL;
+    }
+    free(journal->path);
+    journal->path = NULL;
+}
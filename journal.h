@@ -0,0 +1,168 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <stdio.h>
+
+#include "file.h"
+#include "linked_list.h"
+
+// An append-only log of list operations kept next to a snapshot file.
+// Record ids are implicit: replay numbers the snapshot records 1..n in
+// order and every logged insert or append takes the next free id.
+// A snapshot that is written in the background leaves a marker in the log, after
+// which the list is numbered 1..n again, until the log is rebased onto it.
+typedef struct Journal
+{
+    FILE *file;
+    char *path;
+    long size;     // Bytes currently in the log, header included
+    long num_ops;  // Operations appended since the last snapshot
+    long mark;     // Where the operations after the last snapshot marker start, 0 if there is none
+    long mark_ops; // Operations before the marker
+    SyncPolicy sync;
+    long unsynced;            // Operations written since the log was last forced to disk
+    long long unsynced_since; // When the first of them was written, in ms
+} Journal;
+
+/**
+ * @brief Replays a journal over a list that was just loaded from its snapshot.
+ * Assigns ids to every node. A log that belongs to another snapshot is ignored, unless
+ * the snapshot was written from its marker, and a torn record at the end of the log
+ * (crash mid-append) is dropped.
+ * @param path Path of the journal file.
+ * @param snapshot_path Path of the snapshot the list was loaded from.
+ * @param head A pointer to the head of the list.
+ * @param tail A pointer to the tail of the list.
+ * @param length A pointer to the number of nodes, updated by the replay.
+ * @param deserializer The function to use for deserializing inserted records.
+ * @param alloc_data The function to use for allocating inserted records.
+ * @param free_data The function to use for freeing deleted records.
+ * @param next_id Receives the id the next inserted node should get.
+ * @return 0 on success (including a missing or stale log), 1 if a torn tail was dropped or the log was
+ * replayed from its marker and the journal should be compacted before appending, -1 on failure.
+ */
+int journal_replay(const char *path,
+                   const char *snapshot_path,
+                   Node **head,
+                   Node **tail,
+                   int *length,
+                   json_deserializer deserializer,
+                   alloc_data_func alloc_data,
+                   free_data_func free_data,
+                   unsigned int *next_id);
+
+/**
+ * @brief Opens a journal for appending, starting a new one if the file is missing
+ * or belongs to another snapshot.
+ * @param journal The journal to open.
+ * @param path Path of the journal file.
+ * @param snapshot_path Path of the snapshot the journal belongs to.
+ * @param sync When appended operations are forced to disk, NULL to force every one.
+ * @return 0 on success, -1 on failure.
+ */
+int journal_open(Journal *journal, const char *path, const char *snapshot_path, const SyncPolicy *sync);
+
+/**
+ * @brief Appends an insert operation.
+ * @param journal The journal to append to.
+ * @param after_id Id of the node the new one was inserted after, 0 for the head.
+ * @param data The data of the new node.
+ * @param serializer The function to use for serializing the data.
+ * @return 0 on success, -1 on failure.
+ */
+int journal_append_insert(Journal *journal, unsigned int after_id, void *data, json_serializer serializer);
+
+/**
+ * @brief Appends an operation that adds a record after whatever node is last when it is replayed.
+ * Needs no node ids, so it can be written without loading the list.
+ * @param journal The journal to append to.
+ * @param data The data of the new node.
+ * @param serializer The function to use for serializing the data.
+ * @return 0 on success, -1 on failure.
+ */
+int journal_append_tail(Journal *journal, void *data, json_serializer serializer);
+
+/**
+ * @brief Appends an update operation, which replaces the record of a node and keeps its id.
+ * @param journal The journal to append to.
+ * @param id Id of the updated node.
+ * @param data The new data of the node.
+ * @param serializer The function to use for serializing the data.
+ * @return 0 on success, -1 on failure.
+ */
+int journal_append_update(Journal *journal, unsigned int id, void *data, json_serializer serializer);
+
+/**
+ * @brief Checks that a journal ends on a complete operation, without replaying it.
+ * @param path Path of the journal file.
+ * @param snapshot_path Path of the snapshot the journal belongs to.
+ * @return 0 if it is complete (or missing, or belongs to another snapshot), 1 if it has a torn tail
+ * or belongs to another snapshot but has a marker, -1 if it is damaged.
+ */
+int journal_check(const char *path, const char *snapshot_path);
+
+/**
+ * @brief Tells whether a journal leaves a snapshot as it is, so the snapshot alone can answer for the diary.
+ * Only the header is read.
+ * @param path Path of the journal file.
+ * @param snapshot_path Path of the snapshot.
+ * @return 1 if the log is missing or holds nothing but a header for this snapshot, 0 otherwise.
+ */
+int journal_empty(const char *path, const char *snapshot_path);
+
+/**
+ * @brief Appends a delete operation.
+ * @param journal The journal to append to.
+ * @param id Id of the deleted node.
+ * @return 0 on success, -1 on failure.
+ */
+int journal_append_delete(Journal *journal, unsigned int id);
+
+/**
+ * @brief Appends a snapshot marker: a snapshot of the list is about to be written, and the
+ * operations that follow number its records 1..count in order.
+ * @param journal The journal to append to.
+ * @param count The number of records in the snapshot.
+ * @return 0 on success, -1 on failure (an earlier marker is then forgotten as well).
+ */
+int journal_mark(Journal *journal, unsigned int count);
+
+/**
+ * @brief Starts a new log for the snapshot written from the last marker, keeping the operations after it.
+ * Without a marker the journal is just emptied.
+ * @param journal The journal to rebase.
+ * @param snapshot_path The snapshot file the new log belongs to.
+ * @return 0 on success, -1 on failure.
+ */
+int journal_rebase(Journal *journal, const char *snapshot_path);
+
+/**
+ * @brief Empties the journal after a new snapshot has been written.
+ * @param journal The journal to reset.
+ * @param snapshot_path Path of the freshly written snapshot.
+ * @return 0 on success, -1 on failure.
+ */
+int journal_reset(Journal *journal, const char *snapshot_path);
+
+/**
+ * @brief Forces the operations a group commit is holding back to disk.
+ * @param journal The journal to sync.
+ * @return 0 on success, -1 on failure.
+ */
+int journal_sync(Journal *journal);
+
+/**
+ * @brief Syncs the operations a group commit holds back once their time limit has passed. Appending
+ * only checks the limit when the next operation comes, so this is meant for while nothing is appended.
+ * @param journal The journal.
+ * @return How many ms are left until the waiting operations are due, or -1 if none wait for a time limit.
+ */
+long journal_sync_due(Journal *journal);
+
+/**
+ * @brief Closes the journal and frees its resources. Operations held back by a group commit are synced first.
+ * @param journal The journal to close.
+ */
+void journal_close(Journal *journal);
+
+#endif // JOURNAL_H
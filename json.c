@@ -0,0 +1,444 @@
+#include "json.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+void json_cursor_init(JsonCursor *cursor, const char *data, size_t len)
+{
+    cursor->ptr = data;
+    cursor->end = data + len;
+}
+
+int json_peek(JsonCursor *cursor)
+{
+    const char *ptr = cursor->ptr;
+    while (ptr < cursor->end && (*ptr == ' ' || *ptr == '\n' || *ptr == '\r' || *ptr == '\t'))
+    {
+        ptr++;
+    }
+    cursor->ptr = ptr;
+    return ptr < cursor->end ? (unsigned char)*ptr : -1;
+}
+
+// Consumes an opening bracket and reports whether the container is empty
+static int json_begin(JsonCursor *cursor, char open, char close)
+{
+    if (json_peek(cursor) != open)
+    {
+        return -1;
+    }
+    cursor->ptr++;
+    if (json_peek(cursor) == close)
+    {
+        cursor->ptr++;
+        return 0;
+    }
+    return 1;
+}
+
+// Consumes a ',' or a closing bracket
+static int json_next(JsonCursor *cursor, char close)
+{
+    int c = json_peek(cursor);
+    if (c == ',')
+    {
+        cursor->ptr++;
+        return 1;
+    }
+    if (c == close)
+    {
+        cursor->ptr++;
+        return 0;
+    }
+    return -1;
+}
+
+int json_array_begin(JsonCursor *cursor)
+{
+    return json_begin(cursor, '[', ']');
+}
+
+int json_array_next(JsonCursor *cursor)
+{
+    return json_next(cursor, ']');
+}
+
+int json_object_begin(JsonCursor *cursor)
+{
+    return json_begin(cursor, '{', '}');
+}
+
+int json_object_next(JsonCursor *cursor)
+{
+    return json_next(cursor, '}');
+}
+
+int json_scan_string(JsonCursor *cursor, const char **raw, size_t *raw_len)
+{
+    if (json_peek(cursor) != '"')
+    {
+        return -1;
+    }
+
+    const char *start = cursor->ptr + 1;
+    const char *ptr = start;
+    while (1)
+    {
+        const char *quote = (const char *)memchr(ptr, '"', cursor->end - ptr);
+        if (quote == NULL)
+        {
+            return -1; // Unterminated string
+        }
+
+        // A quote preceded by an odd number of backslashes is escaped
+        const char *backslashes = quote;
+        while (backslashes > start && backslashes[-1] == '\\')
+        {
+            backslashes--;
+        }
+        if ((quote - backslashes) % 2 == 0)
+        {
+            *raw = start;
+            *raw_len = (size_t)(quote - start);
+            cursor->ptr = quote + 1;
+            return 0;
+        }
+        ptr = quote + 1;
+    }
+}
+
+int json_read_key(JsonCursor *cursor, const char **key, size_t *len)
+{
+    if (json_scan_string(cursor, key, len) != 0 || json_peek(cursor) != ':')
+    {
+        return -1;
+    }
+    cursor->ptr++;
+    return 0;
+}
+
+int json_key_equals(const char *key, size_t len, const char *expected)
+{
+    return strlen(expected) == len && memcmp(key, expected, len) == 0;
+}
+
+int json_read_int(JsonCursor *cursor, long *value)
+{
+    json_peek(cursor);
+    const char *ptr = cursor->ptr;
+    int negative = 0;
+    if (ptr < cursor->end && *ptr == '-')
+    {
+        negative = 1;
+        ptr++;
+    }
+
+    const char *digits = ptr;
+    long result = 0;
+    while (ptr < cursor->end && *ptr >= '0' && *ptr <= '9')
+    {
+        if (result > (2147483647L - (*ptr - '0')) / 10)
+        {
+            return -1; // Out of range
+        }
+        result = result * 10 + (*ptr - '0');
+        ptr++;
+    }
+    if (ptr == digits)
+    {
+        return -1; // Not a number
+    }
+
+    *value = negative ? -result : result;
+    cursor->ptr = ptr;
+    return 0;
+}
+
+static int hex_value(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+// Parses the four hex digits of a \u escape, returns -1 if they are malformed
+static long read_hex4(const char *src, const char *end)
+{
+    if (end - src < 4)
+    {
+        return -1;
+    }
+    long value = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        int digit = hex_value(src[i]);
+        if (digit < 0)
+        {
+            return -1;
+        }
+        value = (value << 4) | digit;
+    }
+    return value;
+}
+
+// Encodes a code point as UTF-8, returns the number of bytes written
+static size_t encode_utf8(char *dst, unsigned long cp)
+{
+    if (cp < 0x80)
+    {
+        dst[0] = (char)cp;
+        return 1;
+    }
+    if (cp < 0x800)
+    {
+        dst[0] = (char)(0xC0 | (cp >> 6));
+        dst[1] = (char)(0x80 | (cp & 0x3F));
+        return 2;
+    }
+    if (cp < 0x10000)
+    {
+        dst[0] = (char)(0xE0 | (cp >> 12));
+        dst[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        dst[2] = (char)(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    dst[0] = (char)(0xF0 | (cp >> 18));
+    dst[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+    dst[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+    dst[3] = (char)(0x80 | (cp & 0x3F));
+    return 4;
+}
+
+size_t json_unescape(char *dst, const char *src, size_t len)
+{
+    const char *end = src + len;
+    char *out = dst;
+
+    while (src < end)
+    {
+        // Copy the run up to the next escape in one go
+        const char *backslash = (const char *)memchr(src, '\\', end - src);
+        size_t run = (size_t)((backslash ? backslash : end) - src);
+        memmove(out, src, run);
+        out += run;
+        src += run;
+        if (backslash == NULL || src + 1 >= end)
+        {
+            if (src < end)
+            {
+                *out++ = *src++; // Lone trailing backslash
+            }
+            break;
+        }
+
+        char c = src[1];
+        src += 2;
+        switch (c)
+        {
+        case 'n':
+            *out++ = '\n';
+            break;
+        case 't':
+            *out++ = '\t';
+            break;
+        case 'r':
+            *out++ = '\r';
+            break;
+        case 'b':
+            *out++ = '\b';
+            break;
+        case 'f':
+            *out++ = '\f';
+            break;
+        case 'u':
+        {
+            long cp = read_hex4(src, end);
+            if (cp < 0)
+            {
+                *out++ = 'u'; // Malformed escape, keep it readable
+                break;
+            }
+            src += 4;
+            if (cp >= 0xD800 && cp <= 0xDBFF && end - src >= 6 && src[0] == '\\' && src[1] == 'u')
+            {
+                long low = read_hex4(src + 2, end);
+                if (low >= 0xDC00 && low <= 0xDFFF)
+                {
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                    src += 6;
+                }
+            }
+            // An escape is always longer than the UTF-8 it stands for
+            out += encode_utf8(out, (unsigned long)cp);
+            break;
+        }
+        default: // '"', '\\', '/' and anything unknown stand for themselves
+            *out++ = c;
+            break;
+        }
+    }
+
+    return (size_t)(out - dst);
+}
+
+char *json_read_string(JsonCursor *cursor, size_t *len)
+{
+    const char *raw = NULL;
+    size_t raw_len = 0;
+    if (json_scan_string(cursor, &raw, &raw_len) != 0)
+    {
+        return NULL;
+    }
+
+    // Decoding never grows the string, so the raw length is enough
+    char *str = (char *)malloc(raw_len + 1);
+    if (str == NULL)
+    {
+        return NULL; // Memory allocation failed
+    }
+    size_t decoded = json_unescape(str, raw, raw_len);
+    str[decoded] = '\0';
+    if (len != NULL)
+    {
+        *len = decoded;
+    }
+    return str;
+}
+
+const char *json_find_object(const char *ptr, const char *end)
+{
+    while (ptr < end)
+    {
+        const char *close = (const char *)memchr(ptr, '}', (size_t)(end - ptr));
+        if (close == NULL)
+        {
+            return NULL;
+        }
+        ptr = close + 1;
+
+        JsonCursor cursor;
+        json_cursor_init(&cursor, ptr, (size_t)(end - ptr));
+        if (json_peek(&cursor) != ',')
+        {
+            continue;
+        }
+        cursor.ptr++;
+        if (json_peek(&cursor) != '{')
+        {
+            continue;
+        }
+        const char *object = cursor.ptr++;
+        const char *key = NULL;
+        size_t key_len = 0;
+        if (json_read_key(&cursor, &key, &key_len) == 0)
+        {
+            return object;
+        }
+    }
+    return NULL;
+}
+
+int json_skip_value(JsonCursor *cursor)
+{
+    int c = json_peek(cursor);
+    if (c == '"')
+    {
+        const char *raw = NULL;
+        size_t raw_len = 0;
+        return json_scan_string(cursor, &raw, &raw_len);
+    }
+
+    if (c == '{' || c == '[')
+    {
+        int more = c == '{' ? json_object_begin(cursor) : json_array_begin(cursor);
+        while (more == 1)
+        {
+            if (c == '{')
+            {
+                const char *key = NULL;
+                size_t key_len = 0;
+                if (json_read_key(cursor, &key, &key_len) != 0)
+                {
+                    return -1;
+                }
+            }
+            if (json_skip_value(cursor) != 0)
+            {
+                return -1;
+            }
+            more = c == '{' ? json_object_next(cursor) : json_array_next(cursor);
+        }
+        return more;
+    }
+
+    // Numbers and literals run until the next delimiter
+    const char *start = cursor->ptr;
+    while (cursor->ptr < cursor->end && strchr(",}] \t\r\n", *cursor->ptr) == NULL)
+    {
+        cursor->ptr++;
+    }
+    return cursor->ptr > start ? 0 : -1;
+}
+
+int json_write_string(Writer *writer, const char *str, size_t len)
+{
+    static const char hex[] = "0123456789abcdef";
+
+    writer_putc(writer, '"');
+    size_t run_start = 0;
+    for (size_t i = 0; i < len; i++)
+    {
+        unsigned char c = (unsigned char)str[i];
+        if (c >= 0x20 && c != '"' && c != '\\')
+        {
+            continue;
+        }
+
+        writer_write(writer, str + run_start, i - run_start);
+        run_start = i + 1;
+
+        char escape[7] = {'\\', 0, 0, 0, 0, 0, 0};
+        size_t escape_len = 2;
+        switch (c)
+        {
+        case '"':
+            escape[1] = '"';
+            break;
+        case '\\':
+            escape[1] = '\\';
+            break;
+        case '\n':
+            escape[1] = 'n';
+            break;
+        case '\r':
+            escape[1] = 'r';
+            break;
+        case '\t':
+            escape[1] = 't';
+            break;
+        case '\b':
+            escape[1] = 'b';
+            break;
+        case '\f':
+            escape[1] = 'f';
+            break;
+        default:
+            escape[1] = 'u';
+            escape[2] = '0';
+            escape[3] = '0';
+            escape[4] = hex[c >> 4];
+            escape[5] = hex[c & 0xF];
+            escape_len = 6;
+            break;
+        }
+        writer_write(writer, escape, escape_len);
+    }
+    writer_write(writer, str + run_start, len - run_start);
+    writer_putc(writer, '"');
+
+    return writer->error ? -1 : 0;
+}
@@ -0,0 +1,135 @@
+#ifndef JSON_H
+#define JSON_H
+
+#include <stddef.h>
+
+#include "writer.h"
+
+// A read position inside a JSON buffer. The buffer does not need to be null-terminated.
+typedef struct JsonCursor
+{
+    const char *ptr;
+    const char *end;
+} JsonCursor;
+
+/**
+ * @brief Points a cursor at a buffer.
+ * @param cursor The cursor to initialize.
+ * @param data The JSON text.
+ * @param len The length of the JSON text.
+ */
+void json_cursor_init(JsonCursor *cursor, const char *data, size_t len);
+
+/**
+ * @brief Skips whitespace and returns the next character without consuming it.
+ * @param cursor The cursor to read from.
+ * @return The next character, or -1 at the end of the buffer.
+ */
+int json_peek(JsonCursor *cursor);
+
+/**
+ * @brief Consumes the opening '[' of an array.
+ * @param cursor The cursor to read from.
+ * @return 1 if the array has elements, 0 if it is empty (the closing ']' is consumed too), -1 on error.
+ */
+int json_array_begin(JsonCursor *cursor);
+
+/**
+ * @brief Consumes the separator after an array element.
+ * @param cursor The cursor to read from.
+ * @return 1 if another element follows, 0 at the closing ']', -1 on error.
+ */
+int json_array_next(JsonCursor *cursor);
+
+/**
+ * @brief Consumes the opening '{' of an object.
+ * @param cursor The cursor to read from.
+ * @return 1 if the object has members, 0 if it is empty (the closing '}' is consumed too), -1 on error.
+ */
+int json_object_begin(JsonCursor *cursor);
+
+/**
+ * @brief Consumes the separator after an object member.
+ * @param cursor The cursor to read from.
+ * @return 1 if another member follows, 0 at the closing '}', -1 on error.
+ */
+int json_object_next(JsonCursor *cursor);
+
+/**
+ * @brief Reads a member key and the ':' after it. The key is not copied.
+ * @param cursor The cursor to read from.
+ * @param key Receives a pointer to the raw key inside the buffer.
+ * @param len Receives the raw key length.
+ * @return 0 on success, -1 on error.
+ */
+int json_read_key(JsonCursor *cursor, const char **key, size_t *len);
+
+/**
+ * @brief Compares a raw key returned by json_read_key with a string.
+ * @return 1 if they are equal, 0 otherwise.
+ */
+int json_key_equals(const char *key, size_t len, const char *expected);
+
+/**
+ * @brief Reads an integer value.
+ * @param cursor The cursor to read from.
+ * @param value Receives the value.
+ * @return 0 on success, -1 on error.
+ */
+int json_read_int(JsonCursor *cursor, long *value);
+
+/**
+ * @brief Finds the extent of a string value without decoding it.
+ * @param cursor The cursor to read from.
+ * @param raw Receives a pointer to the escaped contents inside the buffer (without quotes).
+ * @param raw_len Receives the length of the escaped contents.
+ * @return 0 on success, -1 on error.
+ */
+int json_scan_string(JsonCursor *cursor, const char **raw, size_t *raw_len);
+
+/**
+ * @brief Reads a string value, unescaping it straight into a new allocation.
+ * @param cursor The cursor to read from.
+ * @param len Receives the decoded length, may be NULL.
+ * @return The null-terminated string (the caller must free it), or NULL on error.
+ */
+char *json_read_string(JsonCursor *cursor, size_t *len);
+
+/**
+ * @brief Decodes escaped string contents. The output is never longer than the input,
+ * so dst may equal src for in-place decoding.
+ * @param dst The buffer to decode into, at least len bytes.
+ * @param src The escaped contents.
+ * @param len The length of the escaped contents.
+ * @return The decoded length.
+ */
+size_t json_unescape(char *dst, const char *src, size_t len);
+
+/**
+ * @brief Skips over any value (string, number, literal, object or array).
+ * @param cursor The cursor to read from.
+ * @return 0 on success, -1 on error.
+ */
+int json_skip_value(JsonCursor *cursor);
+
+/**
+ * @brief Finds the next element of an array of objects, starting anywhere in the array, even inside a string.
+ * Looks for '}' ',' '{' followed by a member key. The quote opening the key cannot be escaped,
+ * so inside a string this can only match where the string ends and the next string starts with ':'.
+ * Callers that cannot rule that out check that the elements they parse line up.
+ * @param ptr Where to start looking.
+ * @param end The end of the JSON text.
+ * @return The '{' of the next element, or NULL if there is none.
+ */
+const char *json_find_object(const char *ptr, const char *end);
+
+/**
+ * @brief Writes a quoted, escaped JSON string.
+ * @param writer The writer to write to.
+ * @param str The string to write.
+ * @param len The length of the string.
+ * @return 0 on success, -1 on failure.
+ */
+int json_write_string(Writer *writer, const char *str, size_t len);
+
+#endif // JSON_H
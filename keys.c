@@ -0,0 +1,310 @@
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "keys.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(KEYS_RAW)
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+// How long the rest of an escape sequence may take before a lone Escape is assumed
+#define KEYS_ESCAPE_MS 50
+
+void keys_init(KeyReader *reader, int fd)
+{
+    memset(reader, 0, sizeof(KeyReader));
+    reader->fd = fd;
+#if defined(KEYS_RAW)
+    reader->usable = isatty(fd) && tcgetattr(fd, &reader->saved) == 0;
+#endif
+}
+
+int keys_raw_begin(KeyReader *reader)
+{
+    if (reader == NULL || !reader->usable)
+    {
+        return -1; // Not a terminal
+    }
+#if defined(KEYS_RAW)
+    if (reader->raw)
+    {
+        return 0;
+    }
+    struct termios raw;
+    if (tcgetattr(reader->fd, &reader->saved) != 0)
+    {
+        return -1;
+    }
+    raw = reader->saved;
+    raw.c_lflag &= ~(ICANON | ECHO | IEXTEN | ISIG);
+    raw.c_iflag &= ~(ICRNL | IXON);
+    raw.c_cc[VMIN] = 1;
+    raw.c_cc[VTIME] = 0;
+    if (tcsetattr(reader->fd, TCSANOW, &raw) != 0)
+    {
+        return -1;
+    }
+    reader->raw = 1;
+    return 0;
+#else
+    return -1;
+#endif
+}
+
+void keys_raw_end(KeyReader *reader)
+{
+#if defined(KEYS_RAW)
+    if (reader != NULL && reader->raw)
+    {
+        tcsetattr(reader->fd, TCSANOW, &reader->saved);
+        reader->raw = 0;
+    }
+#else
+    (void)reader;
+#endif
+}
+
+#if defined(KEYS_RAW)
+static int wait_input(KeyReader *reader, int timeout_ms)
+{
+    struct pollfd fds;
+    fds.fd = reader->fd;
+    fds.events = POLLIN;
+    fds.revents = 0;
+    return poll(&fds, 1, timeout_ms) > 0;
+}
+
+// Fills the buffer with whatever has arrived, waiting for at least one byte. 0 at the end of input.
+static int fill(KeyReader *reader)
+{
+    while (1)
+    {
+        ssize_t got = read(reader->fd, reader->buffer, sizeof(reader->buffer));
+        if (got > 0)
+        {
+            reader->start = 0;
+            reader->end = (size_t)got;
+            return 1;
+        }
+        if (got == 0 || errno != EINTR)
+        {
+            return 0;
+        }
+        // Interrupted by a signal (a resize, for one), try again
+    }
+}
+
+// Takes one byte, -1 at the end of input
+static int next_byte(KeyReader *reader)
+{
+    if (reader->start == reader->end && !fill(reader))
+    {
+        return -1;
+    }
+    return reader->buffer[reader->start++];
+}
+
+// The byte after the ones read so far, if it arrives in time
+static int sequence_byte(KeyReader *reader)
+{
+    if (reader->start == reader->end && !wait_input(reader, KEYS_ESCAPE_MS))
+    {
+        return -1;
+    }
+    return next_byte(reader);
+}
+
+// Escape was read, recognizes ESC [ X, ESC O X and ESC [ n ~
+static Key escape_sequence(KeyReader *reader)
+{
+    int introducer = sequence_byte(reader);
+    if (introducer == -1)
+    {
+        return KEY_ESCAPE;
+    }
+    if (introducer != '[' && introducer != 'O')
+    {
+        return KEY_NONE; // Alt with a key
+    }
+    int byte = sequence_byte(reader);
+    int number = 0;
+    while (byte >= '0' && byte <= '9')
+    {
+        number = number * 10 + (byte - '0');
+        byte = sequence_byte(reader);
+    }
+    while (byte == ';' || (byte >= '0' && byte <= '9'))
+    {
+        byte = sequence_byte(reader); // Modifiers are ignored
+    }
+    switch (byte)
+    {
+    case 'A':
+        return KEY_UP;
+    case 'B':
+        return KEY_DOWN;
+    case 'C':
+        return KEY_RIGHT;
+    case 'D':
+        return KEY_LEFT;
+    case 'H':
+        return KEY_HOME;
+    case 'F':
+        return KEY_END;
+    case '~':
+        switch (number)
+        {
+        case 1:
+        case 7:
+            return KEY_HOME;
+        case 3:
+            return KEY_DELETE;
+        case 4:
+        case 8:
+            return KEY_END;
+        case 5:
+            return KEY_PAGE_UP;
+        case 6:
+            return KEY_PAGE_DOWN;
+        }
+        return KEY_NONE;
+    }
+    return KEY_NONE;
+}
+#endif
+
+Key keys_read(KeyReader *reader, char *c)
+{
+#if defined(KEYS_RAW)
+    int byte = next_byte(reader);
+    switch (byte)
+    {
+    case -1:
+    case 3: // Ctrl-C, the caller leaves raw mode before closing
+    case 4: // Ctrl-D
+        return KEY_EOF;
+    case '\r':
+    case '\n':
+        return KEY_ENTER;
+    case 8:
+    case 127:
+        return KEY_BACKSPACE;
+    case 27:
+        return escape_sequence(reader);
+    }
+    if (c != NULL)
+    {
+        *c = (char)byte;
+    }
+    return byte < 32 ? KEY_CONTROL : KEY_CHAR;
+#else
+    (void)reader;
+    (void)c;
+    return KEY_EOF;
+#endif
+}
+
+int keys_available(KeyReader *reader)
+{
+#if defined(KEYS_RAW)
+    return reader->start < reader->end || wait_input(reader, 0);
+#else
+    (void)reader;
+    return 0;
+#endif
+}
+
+int keys_wait(KeyReader *reader, int timeout_ms)
+{
+#if defined(KEYS_RAW)
+    return reader->start < reader->end || wait_input(reader, timeout_ms);
+#else
+    (void)reader;
+    (void)timeout_ms;
+    return 1; // Nothing to wait with, the caller reads at once
+#endif
+}
+
+long keys_read_line(KeyReader *reader, char **line, size_t *capacity)
+{
+    if (reader == NULL || line == NULL || capacity == NULL)
+    {
+        return -1; // Invalid input
+    }
+#if defined(KEYS_RAW)
+    size_t len = 0;
+    while (1)
+    {
+        if (reader->start == reader->end && !fill(reader))
+        {
+            break; // End of input, a last line without '\n' still counts
+        }
+        unsigned char *from = reader->buffer + reader->start;
+        size_t available = reader->end - reader->start;
+        unsigned char *newline = (unsigned char *)memchr(from, '\n', available);
+        size_t take = newline != NULL ? (size_t)(newline - from) + 1 : available;
+        if (len + take + 1 > *capacity)
+        {
+            size_t grown_capacity = *capacity ? *capacity : 128;
+            while (len + take + 1 > grown_capacity)
+            {
+                grown_capacity *= 2;
+            }
+            char *grown = (char *)realloc(*line, grown_capacity);
+            if (grown == NULL)
+            {
+                return -1; // Memory allocation failed
+            }
+            *line = grown;
+            *capacity = grown_capacity;
+        }
+        memcpy(*line + len, from, take);
+        len += take;
+        reader->start += take;
+        if (newline != NULL)
+        {
+            break;
+        }
+    }
+    if (len == 0)
+    {
+        return -1;
+    }
+    (*line)[len] = '\0';
+    return (long)len;
+#else
+    return -1;
+#endif
+}
+
+size_t keys_read_paste(KeyReader *reader, const char **block, int *stop)
+{
+    *block = NULL;
+    *stop = -1;
+#if defined(KEYS_RAW)
+    if (reader->start == reader->end && !fill(reader))
+    {
+        return 0;
+    }
+    unsigned char *from = reader->buffer + reader->start;
+    size_t available = reader->end - reader->start;
+    size_t take = 0;
+    while (take < available && from[take] != 3 && from[take] != 4)
+    {
+        take++;
+    }
+    *block = (const char *)from;
+    *stop = take < available ? from[take] : 0;
+    reader->start += take < available ? take + 1 : take;
+    return take;
+#else
+    (void)reader;
+    return 0;
+#endif
+}
@@ -0,0 +1,115 @@
+#ifndef KEYS_H
+#define KEYS_H
+
+#include <stddef.h>
+
+#if !defined(_WIN32)
+#include <termios.h>
+#define KEYS_RAW 1
+#endif
+
+#define KEYS_BUFFER 4096
+
+// The keys the main screen tells apart
+typedef enum Key
+{
+    KEY_NONE,    // An escape sequence that is not one of the keys below
+    KEY_CHAR,    // A byte of text, UTF-8 sequences come one byte at a time
+    KEY_CONTROL, // A control character other than the ones below, Tab or Ctrl-S for one
+    KEY_ESCAPE,  // Escape on its own
+    KEY_ENTER,
+    KEY_BACKSPACE,
+    KEY_DELETE,
+    KEY_UP,
+    KEY_DOWN,
+    KEY_LEFT,
+    KEY_RIGHT,
+    KEY_PAGE_UP,
+    KEY_PAGE_DOWN,
+    KEY_HOME,
+    KEY_END,
+    KEY_EOF // End of input, Ctrl-D or Ctrl-C
+} Key;
+
+// Reads single keystrokes from a terminal in raw mode
+typedef struct KeyReader
+{
+    int fd;
+    int raw; // The terminal is in raw mode
+    int usable; // 0 when the input is not a terminal or the platform has no raw mode
+#if defined(KEYS_RAW)
+    struct termios saved;
+#endif
+    unsigned char buffer[KEYS_BUFFER]; // Read but not yet taken, a paste arrives in one read
+    size_t start;
+    size_t end;
+} KeyReader;
+
+/**
+ * @brief Initializes a reader over a file descriptor. Reading keys needs the descriptor to be a terminal,
+ * check usable before using the reader. The reader buffers what it reads, so while it is used every
+ * line must be read with keys_read_line rather than from stdin.
+ * @param reader The reader to initialize.
+ * @param fd The file descriptor to read from, usually 0.
+ */
+void keys_init(KeyReader *reader, int fd);
+
+/**
+ * @brief Switches the terminal to raw mode: no echo, no line editing, every key is read as it is pressed.
+ * Ctrl-C does not interrupt, it is read as KEY_EOF like Ctrl-D, so the terminal is never left in raw mode.
+ * @param reader The reader.
+ * @return 0 on success, -1 on failure.
+ */
+int keys_raw_begin(KeyReader *reader);
+
+/**
+ * @brief Puts the terminal back the way keys_raw_begin found it.
+ * @param reader The reader.
+ */
+void keys_raw_end(KeyReader *reader);
+
+/**
+ * @brief Waits for the next key.
+ * @param reader The reader, in raw mode.
+ * @param c Receives the byte of a KEY_CHAR or KEY_CONTROL.
+ * @return The key.
+ */
+Key keys_read(KeyReader *reader, char *c);
+
+/**
+ * @brief Tells whether another key has already arrived, without waiting for one.
+ * @param reader The reader.
+ * @return 1 if keys_read would not wait, 0 otherwise.
+ */
+int keys_available(KeyReader *reader);
+
+/**
+ * @brief Waits for input without taking it.
+ * @param reader The reader.
+ * @param timeout_ms How long to wait at most.
+ * @return 1 if input arrived in time, 0 otherwise.
+ */
+int keys_wait(KeyReader *reader, int timeout_ms);
+
+/**
+ * @brief Reads a line with the terminal's own line editing, outside raw mode, like getline does.
+ * Keys read ahead in raw mode come first.
+ * @param reader The reader.
+ * @param line The line buffer, grown as needed. Receives the line with its '\n' and a terminating '\0'.
+ * @param capacity The size of the line buffer.
+ * @return The length of the line, or -1 at the end of input or on failure.
+ */
+long keys_read_line(KeyReader *reader, char **line, size_t *capacity);
+
+/**
+ * @brief Takes raw input in the blocks the terminal delivers it in, up to Ctrl-C or Ctrl-D, for pasting
+ * text: a paste is taken a block at a time instead of key by key. Keys read ahead come first.
+ * @param reader The reader, in raw mode.
+ * @param block Receives the start of the bytes, valid until the reader is used again.
+ * @param stop Receives 3 or 4 if Ctrl-C or Ctrl-D followed the bytes (it is taken but not returned),
+ * -1 if the input ended and 0 otherwise.
+ * @return The number of bytes, 0 only when stop is set.
+ */
+size_t keys_read_paste(KeyReader *reader, const char **block, int *stop);
+
+#endif // KEYS_H
@@ -3,9 +3,76 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "parallel.h"
+
+#define NODES_PER_CHUNK 1024
+#define LOAD_BLOCK_SIZE (1024 * 1024)           // Bytes of JSON a worker takes at a time
+#define LOAD_MIN_PARALLEL (4 * LOAD_BLOCK_SIZE) // Smaller arrays are parsed on the calling thread
+
+// Elements parsed from one block of a JSON array, joined into the list in block order
+typedef struct LoadBlock
+{
+    const char *start; // First element of the block
+    const char *end;   // First element of the next block, or the end of the text
+    char *elements;    // data_size bytes each
+    size_t count;
+    size_t capacity;
+} LoadBlock;
+
+#define SAVE_BLOCK 2048                    // Nodes a worker serializes at a time
+#define SAVE_MIN_PARALLEL (4 * SAVE_BLOCK) // Shorter lists are written on the calling thread
+#define SAVE_WINDOW_PER_THREAD 2           // Blocks per thread that may wait to be written
+
+// One block of nodes serialized into its own buffer
+typedef struct SaveBlock
+{
+    Node *first;
+    size_t count;
+    Writer output;
+    int done;
+} SaveBlock;
+
+// Shared by all workers. Blocks are serialized in any order but written in list order,
+// by whichever worker finds the next block to write finished.
+typedef struct SaveJob
+{
+    SaveBlock *blocks;
+    size_t num_blocks;
+    size_t next_block; // Next block to serialize
+    size_t next_write; // Next block to write
+    size_t window;     // Blocks serialized ahead of next_write at most
+    int writing;       // A worker is writing blocks
+    int failed;
+    Writer *writer;
+    json_serializer serializer;
+#if defined(PARALLEL_THREADS)
+    pthread_mutex_t lock;
+    pthread_cond_t written; // next_write moved or the job failed
+#endif
+} SaveJob;
+
+// Shared by all workers, which take the blocks from the queue one at a time
+typedef struct LoadJob
+{
+    LoadBlock *blocks;
+    size_t num_blocks;
+    const char *json_end;
+    size_t data_size;
+    json_deserializer deserializer;
+    ParallelQueue queue;
+} LoadJob;
+
+// Every node comes from this pool, so a whole list can be released at once
+static Pool node_pool;
+
 Node *ll_create_node(void *data)
 {
-    Node *new_node = (Node *)malloc(sizeof(Node));
+    if (node_pool.object_size == 0)
+    {
+        pool_init(&node_pool, sizeof(Node), NODES_PER_CHUNK);
+    }
+
+    Node *new_node = (Node *)pool_alloc(&node_pool);
     if (!new_node)
     {
         return NULL; // Memory allocation failed
@@ -13,6 +80,7 @@ Node *ll_create_node(void *data)
     new_node->data = data;
     new_node->prev = NULL;
     new_node->next = NULL;
+    new_node->id = 0;
     return new_node;
 }
 
@@ -42,6 +110,32 @@ void ll_insert_after(Node *current, void *data, Node **tail)
     }
 }
 
+void ll_insert_before(Node *current, void *data, Node **head)
+{
+    if (current == NULL)
+    {
+        return; // Invalid current node
+    }
+
+    Node *new_node = ll_create_node(data);
+    if (!new_node)
+    {
+        return; // Memory allocation failed
+    }
+
+    new_node->prev = current->prev;
+    new_node->next = current;
+    if (current->prev != NULL)
+    {
+        current->prev->next = new_node;
+    }
+    current->prev = new_node;
+    if (new_node->prev == NULL && head != NULL)
+    {
+        *head = new_node;
+    }
+}
+
 void ll_delete_node(Node **current, Node **head, Node **tail, free_data_func free_data)
 {
     if (current == NULL || *current == NULL)
@@ -73,27 +167,79 @@ void ll_delete_node(Node **current, Node **head, Node **tail, free_data_func fre
     }
 
     free_data(to_delete->data);
-    free(to_delete);
+    pool_free(&node_pool, to_delete);
     *current = new_current;
 }
 
 void ll_free_list(Node **head, void (*free_data)(void *))
 {
-    if (head == NULL || *head == NULL)
+    if (head == NULL)
     {
         return; // Invalid node
     }
 
-    if ((*head)->next != NULL)
+    // Iterative, so very long lists cannot overflow the stack
+    Node *current = *head;
+    while (current != NULL)
+    {
+        Node *next = current->next;
+        if (current->data != NULL && free_data != NULL)
+        {
+            free_data(current->data);
+        }
+        pool_free(&node_pool, current);
+        current = next;
+    }
+    *head = NULL;
+}
+
+void ll_free_all(Node **head, Node **tail)
+{
+    pool_destroy(&node_pool);
+    if (head != NULL)
     {
-        ll_free_list(&(*head)->next, free_data);
+        *head = NULL;
     }
-    if ((*head)->data != NULL)
+    if (tail != NULL)
     {
-        free_data((*head)->data);
+        *tail = NULL;
     }
-    free(*head);
-    *head = NULL;
+}
+
+Node *ll_snapshot(Node *head, size_t data_size, size_t *count)
+{
+    *count = 0;
+    for (Node *node = head; node != NULL; node = node->next)
+    {
+        (*count)++;
+    }
+    if (*count == 0)
+    {
+        return NULL;
+    }
+
+    // The copies of the data start at an offset that suits any type
+    size_t align = sizeof(long double);
+    size_t data_offset = (*count * sizeof(Node) + align - 1) / align * align;
+    size_t stride = (data_size + align - 1) / align * align;
+    Node *copy = (Node *)malloc(data_offset + *count * stride);
+    if (copy == NULL)
+    {
+        return NULL; // Memory allocation failed
+    }
+
+    char *data = (char *)copy + data_offset;
+    size_t i = 0;
+    for (Node *node = head; node != NULL; node = node->next, i++)
+    {
+        memcpy(data, node->data, data_size);
+        copy[i].data = data;
+        copy[i].prev = i > 0 ? &copy[i - 1] : NULL;
+        copy[i].next = i + 1 < *count ? &copy[i + 1] : NULL;
+        copy[i].id = (unsigned int)(i + 1);
+        data += stride;
+    }
+    return copy;
 }
 
 void ll_prev_node(Node **current)
@@ -122,6 +268,207 @@ void ll_next_node(Node **current)
     }
 }
 
+int ll_write_json(Node *head, Writer *writer, json_serializer serializer)
+{
+    if (writer == NULL || serializer == NULL)
+    {
+        return -1; // Invalid input
+    }
+
+    writer_putc(writer, '['); // Start of JSON array
+    for (Node *current = head; current != NULL; current = current->next)
+    {
+        if (current != head)
+        {
+            writer_putc(writer, ',');
+        }
+        if (serializer(current->data, writer) != 0)
+        {
+            return -1; // Serialization failed, never drop a record silently
+        }
+    }
+    writer_putc(writer, ']'); // End of JSON array
+
+    return writer->error ? -1 : 0;
+}
+
+static void save_lock(SaveJob *job)
+{
+#if defined(PARALLEL_THREADS)
+    pthread_mutex_lock(&job->lock);
+#else
+    (void)job;
+#endif
+}
+
+static void save_unlock(SaveJob *job)
+{
+#if defined(PARALLEL_THREADS)
+    pthread_mutex_unlock(&job->lock);
+#else
+    (void)job;
+#endif
+}
+
+static int save_block(SaveJob *job, size_t b)
+{
+    SaveBlock *block = &job->blocks[b];
+    writer_init_memory(&block->output);
+    Node *node = block->first;
+    for (size_t i = 0; i < block->count; i++, node = node->next)
+    {
+        if (b > 0 || i > 0)
+        {
+            writer_putc(&block->output, ',');
+        }
+        if (job->serializer(node->data, &block->output) != 0)
+        {
+            return -1; // Serialization failed, never drop a record silently
+        }
+    }
+    return block->output.error ? -1 : 0;
+}
+
+// Writes the finished blocks at next_write with one gathered write. Called with the lock held.
+static void write_blocks(SaveJob *job)
+{
+    job->writing = 1;
+    while (!job->failed && job->next_write < job->num_blocks && job->blocks[job->next_write].done)
+    {
+        WriterChunk chunks[64];
+        size_t first = job->next_write;
+        size_t count = 0;
+        while (first + count < job->num_blocks && count < sizeof(chunks) / sizeof(chunks[0]) &&
+               job->blocks[first + count].done)
+        {
+            chunks[count].data = job->blocks[first + count].output.buffer;
+            chunks[count].len = job->blocks[first + count].output.used;
+            count++;
+        }
+
+        save_unlock(job); // Others keep serializing while the blocks are written
+        int result = writer_write_chunks(job->writer, chunks, count);
+        for (size_t b = first; b < first + count; b++)
+        {
+            writer_close(&job->blocks[b].output);
+        }
+        save_lock(job);
+
+        job->next_write = first + count;
+        job->failed |= result != 0;
+#if defined(PARALLEL_THREADS)
+        pthread_cond_broadcast(&job->written);
+#endif
+    }
+    job->writing = 0;
+}
+
+static void *save_worker(void *arg)
+{
+    SaveJob *job = (SaveJob *)arg;
+    save_lock(job);
+    while (1)
+    {
+#if defined(PARALLEL_THREADS)
+        // Running too far ahead of the writes would collect the whole output in memory
+        while (!job->failed && job->next_block < job->num_blocks && job->next_block >= job->next_write + job->window)
+        {
+            pthread_cond_wait(&job->written, &job->lock);
+        }
+#endif
+        if (job->failed || job->next_block >= job->num_blocks)
+        {
+            break;
+        }
+        size_t b = job->next_block++;
+        save_unlock(job);
+        int result = save_block(job, b);
+        save_lock(job);
+
+        if (result != 0)
+        {
+            job->failed = 1;
+#if defined(PARALLEL_THREADS)
+            pthread_cond_broadcast(&job->written);
+#endif
+            break;
+        }
+        job->blocks[b].done = 1;
+        if (!job->writing)
+        {
+            write_blocks(job);
+        }
+    }
+    save_unlock(job);
+    return NULL;
+}
+
+int ll_write_json_parallel(Node *head, Writer *writer, json_serializer serializer)
+{
+    if (writer == NULL || serializer == NULL)
+    {
+        return -1; // Invalid input
+    }
+
+    size_t num_nodes = 0;
+    for (Node *node = head; node != NULL; node = node->next)
+    {
+        num_nodes++;
+    }
+    int threads = parallel_cpu_count();
+    if (num_nodes < SAVE_MIN_PARALLEL || threads < 2)
+    {
+        return ll_write_json(head, writer, serializer);
+    }
+
+    SaveJob job;
+    memset(&job, 0, sizeof(job));
+    job.num_blocks = (num_nodes + SAVE_BLOCK - 1) / SAVE_BLOCK;
+    job.blocks = (SaveBlock *)calloc(job.num_blocks, sizeof(SaveBlock));
+    if (job.blocks == NULL)
+    {
+        return -1; // Memory allocation failed
+    }
+    Node *node = head;
+    for (size_t b = 0; b < job.num_blocks; b++)
+    {
+        job.blocks[b].first = node;
+        job.blocks[b].count = num_nodes - b * SAVE_BLOCK < SAVE_BLOCK ? num_nodes - b * SAVE_BLOCK : SAVE_BLOCK;
+        for (size_t i = 0; i < job.blocks[b].count; i++)
+        {
+            node = node->next;
+        }
+    }
+    job.window = (size_t)threads * SAVE_WINDOW_PER_THREAD;
+    job.writer = writer;
+    job.serializer = serializer;
+
+    writer_putc(writer, '['); // Start of JSON array
+#if defined(PARALLEL_THREADS)
+    pthread_mutex_init(&job.lock, NULL);
+    pthread_cond_init(&job.written, NULL);
+#endif
+    parallel_run(save_worker, &job, (int)job.num_blocks);
+#if defined(PARALLEL_THREADS)
+    pthread_mutex_destroy(&job.lock);
+    pthread_cond_destroy(&job.written);
+#endif
+
+    int failed = job.failed || job.next_write < job.num_blocks;
+    for (size_t b = job.next_write; b < job.num_blocks; b++)
+    {
+        writer_close(&job.blocks[b].output); // Left over after a failure
+    }
+    free(job.blocks);
+    if (failed)
+    {
+        return -1;
+    }
+    writer_putc(writer, ']'); // End of JSON array
+
+    return writer->error ? -1 : 0;
+}
+
 int ll_to_json_string(Node *head, char **json_str, json_serializer serializer)
 {
     if (head == NULL || json_str == NULL || serializer == NULL)
@@ -129,159 +476,388 @@ int ll_to_json_string(Node *head, char **json_str, json_serializer serializer)
         return -1; // Invalid input
     }
 
-    size_t total_size = 2048;
-    size_t used_size = 0;
-    *json_str = (char *)malloc(total_size);
-    if (*json_str == NULL)
+    Writer writer;
+    writer_init_memory(&writer);
+    if (ll_write_json(head, &writer, serializer) != 0)
     {
-        return -1; // Memory allocation failed
+        writer_close(&writer);
+        *json_str = NULL;
+        return -1; // Serialization or memory allocation failed
     }
 
-    strcpy(*json_str, "["); // Start of JSON array
-    used_size = strlen(*json_str);
+    *json_str = writer_detach(&writer, NULL);
+    writer_close(&writer);
+    return *json_str != NULL ? 0 : -1;
+}
 
-    Node *current = head;
-    while (current != NULL)
+int ll_from_json(const char *json,
+                 size_t json_len,
+                 Node **head,
+                 Node **tail,
+                 json_deserializer deserializer,
+                 int *length,
+                 alloc_data_func alloc_data,
+                 free_data_func free_data)
+{
+    if (json == NULL || head == NULL || tail == NULL || deserializer == NULL || length == NULL ||
+        alloc_data == NULL || free_data == NULL)
     {
-        char buffer[512];
-        if (serializer(current->data, buffer, sizeof(buffer)) == 0)
+        return -1; // Invalid input
+    }
+
+    JsonCursor cursor;
+    json_cursor_init(&cursor, json, json_len);
+    if (json_peek(&cursor) == -1)
+    {
+        return 0; // Empty file, empty list
+    }
+
+    int more = json_array_begin(&cursor);
+    while (more == 1)
+    {
+        void *data = alloc_data();
+        if (data == NULL)
         {
-            size_t buffer_len = strlen(buffer);
+            return -1; // Memory allocation failed
+        }
 
-            // Check if we need to resize the buffer
-            if (used_size + buffer_len + 2 > total_size) // +2 for ',' or ']' and null terminator
-            {
-                total_size *= 2;
-                char *new_json_str = (char *)realloc(*json_str, total_size);
-                if (new_json_str == NULL)
-                {
-                    free(*json_str);
-                    *json_str = NULL;
-                    return -1; // Memory allocation failed
-                }
-                *json_str = new_json_str;
-            }
+        if (deserializer(data, &cursor) != 0)
+        {
+            free_data(data);
+            return -1; // Deserialization failed
+        }
 
-            strcat(*json_str, buffer);
-            used_size += buffer_len;
+        Node *new_node = ll_create_node(data);
+        if (new_node == NULL)
+        {
+            free_data(data);
+            return -1; // Memory allocation failed
         }
 
-        current = current->next;
-        if (current != NULL)
+        if (*head == NULL)
+        {
+            *head = new_node;
+            *tail = new_node;
+        }
+        else
         {
-            if (used_size + 1 > total_size) // +1 for ',' and null terminator
+            (*tail)->next = new_node;
+            new_node->prev = *tail;
+            *tail = new_node;
+        }
+        (*length)++;
+
+        more = json_array_next(&cursor);
+    }
+
+    return more == 0 ? 0 : -1; // Malformed array
+}
+
+// Parses the elements of one block, which must end right where the next block starts
+static int load_block(LoadJob *job, LoadBlock *block)
+{
+    JsonCursor cursor;
+    json_cursor_init(&cursor, block->start, (size_t)(job->json_end - block->start)); // A misplaced start shows up as overrunning the end
+    int more = 1;
+    while (more == 1 && cursor.ptr < block->end)
+    {
+        if (block->count == block->capacity)
+        {
+            size_t capacity = block->capacity ? block->capacity * 2 : 256;
+            char *grown = (char *)realloc(block->elements, capacity * job->data_size);
+            if (grown == NULL)
             {
-                total_size *= 2;
-                char *new_json_str = (char *)realloc(*json_str, total_size);
-                if (new_json_str == NULL)
-                {
-                    free(*json_str);
-                    *json_str = NULL;
-                    return -1; // Memory allocation failed
-                }
-                *json_str = new_json_str;
+                return -1; // Memory allocation failed
             }
+            block->elements = grown;
+            block->capacity = capacity;
+        }
 
-            strcat(*json_str, ",");
-            used_size += 1;
+        void *data = block->elements + block->count * job->data_size;
+        memset(data, 0, job->data_size);
+        if (job->deserializer(data, &cursor) != 0)
+        {
+            return -1; // Deserialization failed
         }
+        block->count++;
+
+        more = json_array_next(&cursor);
+        json_peek(&cursor);
+    }
+
+    if (block->end == job->json_end)
+    {
+        return more == 0 ? 0 : -1; // The last block closes the array
     }
+    return more == 1 && cursor.ptr == block->end ? 0 : -1;
+}
 
-    if (used_size + 1 > total_size) // +1 for ']' and null terminator
+static void *load_worker(void *arg)
+{
+    LoadJob *job = (LoadJob *)arg;
+    size_t b = 0;
+    while ((b = parallel_queue_take(&job->queue)) < job->num_blocks)
     {
-        total_size += 1;
-        char *new_json_str = (char *)realloc(*json_str, total_size);
-        if (new_json_str == NULL)
+        if (load_block(job, &job->blocks[b]) != 0)
         {
-            free(*json_str);
-            *json_str = NULL;
-            return -1; // Memory allocation failed
+            parallel_queue_fail(&job->queue);
         }
-        *json_str = new_json_str;
     }
-
-    strcat(*json_str, "]"); // End of JSON array
-
-    return 0; // Success
+    return NULL;
 }
 
-int ll_from_json_string(const char *json_str,
-                        Node **head,
-                        Node **tail,
-                        json_deserializer deserializer,
-                        int *length,
-                        size_t data_size)
+int ll_from_json_parallel(const char *json,
+                          size_t json_len,
+                          Node **head,
+                          Node **tail,
+                          json_deserializer deserializer,
+                          size_t data_size,
+                          int *length,
+                          alloc_data_func alloc_data,
+                          free_data_func free_data)
 {
-    if (json_str == NULL || head == NULL || tail == NULL || deserializer == NULL || length == NULL)
+    if (json == NULL || head == NULL || tail == NULL || deserializer == NULL || data_size == 0 || length == NULL ||
+        alloc_data == NULL || free_data == NULL)
     {
         return -1; // Invalid input
     }
 
-    if (data_size == 0)
+    JsonCursor cursor;
+    json_cursor_init(&cursor, json, json_len);
+    if (json_len < LOAD_MIN_PARALLEL || parallel_cpu_count() < 2 || json_array_begin(&cursor) != 1 ||
+        json_peek(&cursor) != '{')
     {
-        return -1; // Cannot allocate zero-sized records
+        return ll_from_json(json, json_len, head, tail, deserializer, length, alloc_data, free_data);
     }
 
-    const char *ptr = json_str;
-    while (*ptr != '\0')
+    // A block starts at the first element after every LOAD_BLOCK_SIZE bytes
+    size_t max_blocks = json_len / LOAD_BLOCK_SIZE + 1;
+    LoadJob job;
+    memset(&job, 0, sizeof(job));
+    job.blocks = (LoadBlock *)calloc(max_blocks, sizeof(LoadBlock));
+    if (job.blocks == NULL)
+    {
+        return -1; // Memory allocation failed
+    }
+    job.json_end = json + json_len;
+    job.data_size = data_size;
+    job.deserializer = deserializer;
+    job.blocks[0].start = cursor.ptr;
+    job.num_blocks = 1;
+    for (size_t k = 1; k < max_blocks; k++)
     {
-        while (*ptr != '{' && *ptr != '\0')
+        const char *from = json + k * LOAD_BLOCK_SIZE;
+        if (from <= job.blocks[job.num_blocks - 1].start)
         {
-            ptr++;
+            continue; // Still inside a long element
         }
-        if (*ptr == '\0')
+        const char *object = json_find_object(from, job.json_end);
+        if (object == NULL)
         {
-            break; // No more objects
+            break;
         }
+        job.blocks[job.num_blocks++].start = object;
+    }
+    for (size_t b = 0; b < job.num_blocks; b++)
+    {
+        job.blocks[b].end = b + 1 < job.num_blocks ? job.blocks[b + 1].start : job.json_end;
+    }
 
-        const char *start = ptr;
-        int brace_count = 0;
-        do
+    parallel_queue_init(&job.queue, job.num_blocks);
+    parallel_run(load_worker, &job, (int)job.num_blocks);
+    int failed = job.queue.failed;
+    parallel_queue_destroy(&job.queue);
+
+    // The blocks cover the array front to back, so joining them keeps its order
+    int result = 0;
+    for (size_t b = 0; b < job.num_blocks; b++)
+    {
+        LoadBlock *block = &job.blocks[b];
+        for (size_t i = 0; i < block->count && !failed && result == 0; i++)
         {
-            if (*ptr == '{')
+            void *data = alloc_data();
+            Node *new_node = data != NULL ? ll_create_node(data) : NULL;
+            if (new_node == NULL)
+            {
+                free_data(data);
+                result = -1; // Memory allocation failed
+                break;
+            }
+            memcpy(data, block->elements + i * data_size, data_size);
+
+            if (*head == NULL)
             {
-                brace_count++;
+                *head = new_node;
+                *tail = new_node;
             }
-            else if (*ptr == '}')
+            else
             {
-                brace_count--;
+                (*tail)->next = new_node;
+                new_node->prev = *tail;
+                *tail = new_node;
             }
-            ptr++;
-        } while (brace_count > 0 && *ptr != '\0');
+            (*length)++;
+        }
+        free(block->elements);
+    }
+    free(job.blocks);
 
-        if (brace_count != 0)
+    if (failed)
+    {
+        // The blocks did not line up with the elements or one is malformed, the single pass decides which
+        return ll_from_json(json, json_len, head, tail, deserializer, length, alloc_data, free_data);
+    }
+    return result;
+}
+
+int ll_from_json_string(const char *json_str,
+                        Node **head,
+                        Node **tail,
+                        json_deserializer deserializer,
+                        int *length,
+                        alloc_data_func alloc_data,
+                        free_data_func free_data)
+{
+    if (json_str == NULL)
+    {
+        return -1; // Invalid input
+    }
+    return ll_from_json(json_str, strlen(json_str), head, tail, deserializer, length, alloc_data, free_data);
+}
+
+const BinaryIndexEntry *ll_binary_index(const char *buffer, size_t buffer_len, size_t *count, const char **blob)
+{
+    if (buffer == NULL || count == NULL || blob == NULL || buffer_len < sizeof(BinaryHeader))
+    {
+        return NULL; // Invalid input
+    }
+
+    BinaryHeader header;
+    memcpy(&header, buffer, sizeof(header));
+    if (memcmp(header.magic, BINARY_MAGIC, sizeof(header.magic)) != 0 || header.version != BINARY_VERSION ||
+        header.entry_size != sizeof(BinaryIndexEntry))
+    {
+        return NULL; // Not a binary list, or a different version
+    }
+
+    size_t index_end = sizeof(BinaryHeader);
+    if (header.count > (buffer_len - index_end) / sizeof(BinaryIndexEntry))
+    {
+        return NULL; // Truncated index
+    }
+    index_end += (size_t)header.count * sizeof(BinaryIndexEntry);
+    if (header.blob_offset < index_end || header.blob_offset > buffer_len)
+    {
+        return NULL; // Blob outside of the buffer
+    }
+
+    *count = (size_t)header.count;
+    *blob = buffer + header.blob_offset;
+    return (const BinaryIndexEntry *)(buffer + sizeof(BinaryHeader));
+}
+
+int ll_write_binary(Node *head, Writer *writer, binary_serializer serializer)
+{
+    if (writer == NULL || serializer == NULL)
+    {
+        return -1; // Invalid input
+    }
+
+    BinaryHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, BINARY_MAGIC, sizeof(header.magic));
+    header.version = BINARY_VERSION;
+    header.entry_size = sizeof(BinaryIndexEntry);
+    for (Node *current = head; current != NULL; current = current->next)
+    {
+        header.count++;
+    }
+    header.blob_offset = sizeof(BinaryHeader) + header.count * sizeof(BinaryIndexEntry);
+    writer_write(writer, &header, sizeof(header));
+
+    // The index goes first, so offsets are laid out before any data is written
+    uint64_t offset = 0;
+    for (Node *current = head; current != NULL; current = current->next)
+    {
+        BinaryIndexEntry entry;
+        const char *blob = NULL;
+        size_t blob_len = 0;
+        memset(&entry, 0, sizeof(entry));
+        if (serializer(current->data, &entry, &blob, &blob_len) != 0)
         {
-            return -1; // Mismatched braces
+            return -1; // Serialization failed
         }
+        entry.data_offset = offset;
+        entry.data_length = blob_len;
+        writer_write(writer, &entry, sizeof(entry));
+        offset += blob_len + 1;
+    }
 
-        size_t obj_size = ptr - start;
-        char *obj_str = (char *)malloc(obj_size + 1);
-        if (obj_str == NULL)
+    for (Node *current = head; current != NULL; current = current->next)
+    {
+        BinaryIndexEntry entry;
+        const char *blob = NULL;
+        size_t blob_len = 0;
+        if (serializer(current->data, &entry, &blob, &blob_len) != 0)
         {
-            return -1; // Memory allocation failed
+            return -1; // Serialization failed
+        }
+        writer_write(writer, blob, blob_len);
+        writer_putc(writer, '\0');
+    }
+
+    return writer->error ? -1 : 0;
+}
+
+int ll_from_binary(const char *buffer,
+                   size_t buffer_len,
+                   Node **head,
+                   Node **tail,
+                   binary_deserializer deserializer,
+                   int *length,
+                   alloc_data_func alloc_data,
+                   free_data_func free_data)
+{
+    if (head == NULL || tail == NULL || deserializer == NULL || length == NULL || alloc_data == NULL ||
+        free_data == NULL)
+    {
+        return -1; // Invalid input
+    }
+
+    size_t count = 0;
+    const char *blob = NULL;
+    const BinaryIndexEntry *index = ll_binary_index(buffer, buffer_len, &count, &blob);
+    if (index == NULL)
+    {
+        return -1; // Not a valid binary list
+    }
+
+    size_t blob_len = (size_t)(buffer + buffer_len - blob);
+    for (size_t i = 0; i < count; i++)
+    {
+        const BinaryIndexEntry *entry = &index[i];
+        // Only the bounds are checked, so no page of the blob is touched here
+        if (entry->data_offset > blob_len || entry->data_length >= blob_len - entry->data_offset)
+        {
+            return -1; // Entry points outside of the blob
         }
-        strncpy(obj_str, start, obj_size);
-        obj_str[obj_size] = '\0';
 
-        void *data = calloc(1, data_size);
+        void *data = alloc_data();
         if (data == NULL)
         {
-            free(obj_str);
             return -1; // Memory allocation failed
         }
 
-        if (deserializer(data, obj_str, obj_size) != 0)
+        if (deserializer(data, entry, blob + entry->data_offset) != 0)
         {
-            free(obj_str);
-            free(data);
+            free_data(data);
             return -1; // Deserialization failed
         }
 
         Node *new_node = ll_create_node(data);
         if (new_node == NULL)
         {
-            free(obj_str);
-            free(data);
+            free_data(data);
             return -1; // Memory allocation failed
         }
 
@@ -296,10 +872,8 @@ int ll_from_json_string(const char *json_str,
             new_node->prev = *tail;
             *tail = new_node;
         }
-
-        free(obj_str);
         (*length)++;
     }
 
     return 0;
-}
\ No newline at end of file
+}
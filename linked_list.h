@@ -2,6 +2,11 @@
 #define LINKED_LIST_H
 
 #include <stddef.h>
+#include <stdint.h>
+
+#include "json.h"
+#include "pool.h"
+#include "writer.h"
 
 // A node in a doubly linked list
 typedef struct Node
@@ -9,6 +14,7 @@ typedef struct Node
     void *data;
     struct Node *prev;
     struct Node *next;
+    unsigned int id; // Id used by the journal, 0 until assigned
 } Node;
 
 /**
@@ -26,12 +32,26 @@ Node *ll_create_node(void *data);
  */
 void ll_insert_after(Node *current, void *data, Node **tail);
 
+/**
+ * @brief Inserts a new node with the given data before the current node.
+ * @param current A pointer to the current node.
+ * @param data The data to store in the new node.
+ * @param head A pointer to the head pointer of the list, updated if a new head is created.
+ */
+void ll_insert_before(Node *current, void *data, Node **head);
+
 /**
  * @brief A function pointer type for a function that frees a node's data.
  * @param data A pointer to the data to be freed.
  */
 typedef void (*free_data_func)(void *);
 
+/**
+ * @brief A function pointer type for a function that allocates zero-initialized data for a new node.
+ * @return A pointer to the data, or NULL on failure.
+ */
+typedef void *(*alloc_data_func)(void);
+
 /**
  * @brief Deletes a node, frees its memory, updates current pointer and links the neighboring nodes.
  * @param current A pointer to the node to delete.
@@ -39,11 +59,29 @@ typedef void (*free_data_func)(void *);
 void ll_delete_node(Node **current, Node **head, Node **tail, free_data_func free_data);
 
 /**
- * @brief Frees whole Linked list.
+ * @brief Frees whole Linked list, one node at a time.
  * @param head A pointer to the head of the linked list to delete.
  */
 void ll_free_list(Node **head, void (*free_data)(void *));
 
+/**
+ * @brief Releases every node ever created in bulk, without walking the list.
+ * Only valid when no other list is alive and the data is released separately.
+ * @param head A pointer to the head of the list, set to NULL.
+ * @param tail A pointer to the tail of the list, set to NULL.
+ */
+void ll_free_all(Node **head, Node **tail);
+
+/**
+ * @brief Copies a list into a single allocation, the nodes first and a byte copy of each node's data after them.
+ * Pointers inside the data are shared with the original list, so what they point to must not change while the copy is used.
+ * @param head The head of the list to copy.
+ * @param data_size The size of every node's data.
+ * @param count Receives the number of nodes.
+ * @return The head of the copy, released with a single free(). NULL for an empty list or on failure.
+ */
+Node *ll_snapshot(Node *head, size_t data_size, size_t *count);
+
 /**
  * @brief Moves pointer to the previous node.
  * @param current A pointer to the current node.
@@ -57,22 +95,41 @@ void ll_prev_node(Node **current);
 void ll_next_node(Node **current);
 
 /**
- * @brief A function pointer type for a function that serializes a node's data to a JSON string.
+ * @brief A function pointer type for a function that serializes a node's data as JSON.
  * @param data A pointer to the data to be serialized.
- * @param buffer The buffer to write the JSON string into.
- * @param buffer_size The size of the buffer.
+ * @param writer The writer to emit the JSON into, any amount of output is allowed.
  * @return 0 on success, non-zero on failure.
  */
-typedef int (*json_serializer)(void *data, char *buffer, size_t buffer_size);
+typedef int (*json_serializer)(void *data, Writer *writer);
 
 /**
- * @brief A function pointer type for a function that deserializes a JSON string into a node's data.
+ * @brief A function pointer type for a function that deserializes one JSON value into a node's data.
  * @param data A pointer to the data to be deserialized.
- * @param buffer The JSON string to read from.
- * @param buffer_size The size of the buffer.
+ * @param cursor The cursor positioned at the value, left just after it.
  * @return 0 on success, non-zero on failure.
  */
-typedef int (*json_deserializer)(void *data, const char *buffer, size_t buffer_size);
+typedef int (*json_deserializer)(void *data, JsonCursor *cursor);
+
+/**
+ * @brief Streams a linked list as a JSON array. An empty list is written as "[]".
+ * @param head The head of the list.
+ * @param writer The writer to emit the JSON into.
+ * @param serializer The function to use for serializing each node's data.
+ * @return 0 on success, -1 on failure.
+ */
+int ll_write_json(Node *head, Writer *writer, json_serializer serializer);
+
+/**
+ * @brief Streams a linked list as a JSON array like ll_write_json, serializing blocks of nodes on every CPU core.
+ * Finished blocks are handed to the writer in order with writer_write_chunks. Only a few blocks per thread
+ * are held at a time, so the output is never collected in memory as a whole. Short lists are written on the calling thread.
+ * @param head The head of the list.
+ * @param writer The writer to emit the JSON into.
+ * @param serializer The function to use for serializing each node's data. It is called from several threads
+ * at once, so it must not touch shared state.
+ * @return 0 on success, -1 on failure.
+ */
+int ll_write_json_parallel(Node *head, Writer *writer, json_serializer serializer);
 
 /**
  * @brief Converts a linked list to a JSON array string.
@@ -83,6 +140,53 @@ typedef int (*json_deserializer)(void *data, const char *buffer, size_t buffer_s
  */
 int ll_to_json_string(Node *head, char **json_str, json_serializer serializer);
 
+/**
+ * @brief Parses a JSON array in a single pass, directly from the buffer, and appends its elements to a linked list.
+ * @param json The JSON text, which does not need to be null-terminated.
+ * @param json_len The length of the JSON text.
+ * @param head A pointer to the head of the list to populate.
+ * @param tail A pointer to the tail of the list to populate.
+ * @param deserializer The function to use for deserializing each element.
+ * @param length A pointer to the number of nodes, incremented for each element.
+ * @param alloc_data The function to use for allocating each element's data.
+ * @param free_data The function to use for freeing data that failed to deserialize.
+ * @return 0 on success, -1 on failure.
+ */
+int ll_from_json(const char *json,
+                 size_t json_len,
+                 Node **head,
+                 Node **tail,
+                 json_deserializer deserializer,
+                 int *length,
+                 alloc_data_func alloc_data,
+                 free_data_func free_data);
+
+/**
+ * @brief Parses a JSON array of objects like ll_from_json, splitting large arrays into blocks that are parsed on every CPU core.
+ * The blocks start at json_find_object and every block must end exactly where the next one starts,
+ * otherwise (and for small arrays) the array is parsed by ll_from_json on the calling thread.
+ * @param json The JSON text, which does not need to be null-terminated.
+ * @param json_len The length of the JSON text.
+ * @param head A pointer to the head of the list to populate.
+ * @param tail A pointer to the tail of the list to populate.
+ * @param deserializer The function to use for deserializing each element. It is called from several threads
+ * at once on zeroed scratch copies, so it must not touch shared state.
+ * @param data_size The size of each element's data. The scratch copies are copied byte for byte into data from alloc_data.
+ * @param length A pointer to the number of nodes, incremented for each element.
+ * @param alloc_data The function to use for allocating each element's data, called on the calling thread only.
+ * @param free_data The function to use for freeing data that failed to deserialize.
+ * @return 0 on success, -1 on failure.
+ */
+int ll_from_json_parallel(const char *json,
+                          size_t json_len,
+                          Node **head,
+                          Node **tail,
+                          json_deserializer deserializer,
+                          size_t data_size,
+                          int *length,
+                          alloc_data_func alloc_data,
+                          free_data_func free_data);
+
 /**
  * @brief Parses a JSON array string and populates a linked list.
  * @param json_str The JSON string to parse.
@@ -96,6 +200,90 @@ int ll_from_json_string(const char *json_str,
                         Node **tail,
                         json_deserializer deserializer,
                         int *length,
-                        size_t data_size);
+                        alloc_data_func alloc_data,
+                        free_data_func free_data);
+
+#define BINARY_MAGIC "DIARYBIN"
+#define BINARY_VERSION 1
+
+// Header of the binary list format. All fields are stored little-endian as in memory,
+// a file from a big-endian host fails the version check.
+typedef struct BinaryHeader
+{
+    char magic[8];        // BINARY_MAGIC, not null-terminated
+    uint32_t version;     // BINARY_VERSION
+    uint32_t entry_size;  // sizeof(BinaryIndexEntry)
+    uint64_t count;       // Number of index entries
+    uint64_t blob_offset; // Offset of the data blob from the start of the file
+} BinaryHeader;
+
+// A fixed-size index entry, the index directly follows the header
+typedef struct BinaryIndexEntry
+{
+    uint32_t date;        // year << 9 | month << 5 | day
+    uint32_t flags;       // Reserved, written as 0
+    uint64_t data_offset; // Offset of the data inside the blob
+    uint64_t data_length; // Length of the data, a null byte follows it in the blob
+} BinaryIndexEntry;
+
+/**
+ * @brief A function pointer type for a function that describes a node's data for the binary format.
+ * @param data A pointer to the data to be serialized.
+ * @param entry The index entry to fill in (the offset is filled in by the caller).
+ * @param blob Receives a pointer to the bytes stored in the blob, which must stay valid during the save.
+ * @param blob_len Receives the number of bytes stored in the blob.
+ * @return 0 on success, non-zero on failure.
+ */
+typedef int (*binary_serializer)(void *data, BinaryIndexEntry *entry, const char **blob, size_t *blob_len);
+
+/**
+ * @brief A function pointer type for a function that builds a node's data from a binary index entry.
+ * @param data A pointer to the data to be deserialized.
+ * @param entry The index entry.
+ * @param blob The entry's bytes inside the buffer. The writer puts a null byte after them,
+ * but it is not checked at load time.
+ * @return 0 on success, non-zero on failure.
+ */
+typedef int (*binary_deserializer)(void *data, const BinaryIndexEntry *entry, const char *blob);
+
+/**
+ * @brief Validates a binary buffer and returns its index, so entry N can be read in O(1).
+ * @param buffer The binary data, e.g. a mapped file.
+ * @param buffer_len The length of the data.
+ * @param count Receives the number of entries.
+ * @param blob Receives a pointer to the start of the data blob.
+ * @return A pointer to the first index entry, or NULL if the buffer is not a valid binary list.
+ */
+const BinaryIndexEntry *ll_binary_index(const char *buffer, size_t buffer_len, size_t *count, const char **blob);
+
+/**
+ * @brief Writes a linked list in the binary format: header, fixed-size index, then one data blob.
+ * @param head The head of the list.
+ * @param writer The writer to emit the data into.
+ * @param serializer The function to use for describing each node's data.
+ * @return 0 on success, -1 on failure.
+ */
+int ll_write_binary(Node *head, Writer *writer, binary_serializer serializer);
+
+/**
+ * @brief Populates a linked list from a binary buffer. The index is used in place, nothing is parsed.
+ * @param buffer The binary data, which must stay alive as long as the deserializer keeps pointers into it.
+ * @param buffer_len The length of the data.
+ * @param head A pointer to the head of the list to populate.
+ * @param tail A pointer to the tail of the list to populate.
+ * @param deserializer The function to use for deserializing each entry.
+ * @param length A pointer to the number of nodes, incremented for each entry.
+ * @param alloc_data The function to use for allocating each entry's data.
+ * @param free_data The function to use for freeing data that failed to deserialize.
+ * @return 0 on success, -1 on failure.
+ */
+int ll_from_binary(const char *buffer,
+                   size_t buffer_len,
+                   Node **head,
+                   Node **tail,
+                   binary_deserializer deserializer,
+                   int *length,
+                   alloc_data_func alloc_data,
+                 free_data_func free_data);
 
 #endif // LINKED_LIST_H
\ No newline at end of file
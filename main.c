@@ -14,9 +14,21 @@ typedef SSIZE_T ssize_t;
 #endif
 
 #include "i18n.h"
-#include "strings.h"
+#include "command.h"
 #include "file.h"
+#include "gap_buffer.h"
+#include "grep.h"
+#include "keys.h"
 #include "linked_list.h"
+#include "journal.h"
+#include "record.h"
+#include "saver.h"
+#include "screen.h"
+#include "search.h"
+#include "skip_list.h"
+#include "storage.h"
+#include "trace.h"
+#include "writer.h"
 
 #if defined(_WIN32)
 static ssize_t portable_getline(char **lineptr, size_t *n, FILE *stream)
@@ -75,33 +87,113 @@ static ssize_t portable_getline(char **lineptr, size_t *n, FILE *stream)
 #define getline portable_getline
 #endif
 
-#define _(s) i18n_get_string(translations, s)
+#define _(key) (i18n_strings[STR_##key]) // An unknown key does not compile
 
-typedef struct Record
-{
-    char day;
-    char month;
-    short year;
-    char *note;
-} Record;
-
-int serialize_record(void *data, char *buffer, size_t buffer_size);
-int deserialize_record(void *data, const char *json_str, size_t json_size);
 static void rtrim(char *str);
-static int command_matches(char *input, const char *key);
+static int command_matches(char *input, StringKey key);
+static ssize_t read_command(long *steps, int *jump);
+static void wait_for_input(void);
+static int add_move(Key key, long page, long *steps, int *jump);
+static void move_by(long steps);
+static void move_to_end(int end);
+static int run_prev(char *argument);
+static int run_next(char *argument);
+static int run_goto(char *argument);
+static int run_search(char *argument);
+static int run_grep(char *argument);
+static int run_new(char *argument);
+static int run_save(char *argument);
+static int run_edit(char *argument);
+static int run_delete(char *argument);
+static int run_lang(char *argument);
+static int run_overview(char *argument);
+static int run_close(char *argument);
 static int new_entry();
+static int read_note(char **note, size_t *len);
+static int note_line_is(const char *input, size_t len, StringKey key);
+static int paste_note(Writer *text);
+static int put_pasted(Writer *text, const char *block, size_t len, int *after_cr);
+static int read_all(FILE *file, Writer *text);
+static int edit_entry();
+static int edit_text(GapBuffer *text, Record *record);
+static int update_note(Node *node, const char *note, size_t len);
+static Node *insert_record(Record *rec);
+static SkipList *dates();
+static int goto_date(char *date);
+static int search_notes(const char *query);
+static int grep_notes(const char *pattern);
+static void print_snippet(const char *note, size_t offset, size_t pattern_len);
+static void clear_search();
+static int compare_nodes_by_date(const void *a, const void *b);
+static void load_search_index();
 static void print_help();
 static void clear_screen();
 static int get_date(char *date, int *day, int *month, int *year);
-void free_record(Record *rec);
 static int del_entry();
 static void save_data();
-
-static TranslationMap *translations = NULL;
+static void save_data_now(int mark);
+static void finish_save(int wait);
+static void restart_journal(int marked);
+static void number_records();
+static void compact_if_needed();
+static void persist_insert(Node *node);
+static void persist_update(Node *node);
+static void persist_delete(unsigned int id);
+static char *path_with_suffix(const char *path, const char *suffix);
+static int load_diary(const char *path,
+                      const char *log_path,
+                      MappedFile *map,
+                      Node **list_head,
+                      Node **list_tail,
+                      int *length,
+                      DiaryFormat *format,
+                      unsigned int *first_free_id,
+                      unsigned int *snapshot_length);
+static int convert_diary(const char *input, const char *output);
+static int run_batch(int argc, char **argv);
+static const char *option_value(int argc, char **argv, const char *name);
+static int parse_date_option(const char *value, Record *date);
+static int batch_load();
+static void batch_unload();
+static int batch_add(int argc, char **argv);
+static int batch_list(int argc, char **argv);
+static int batch_show(int argc, char **argv);
+static int batch_count();
+static const BinaryIndexEntry *snapshot_index(MappedFile *map, size_t *count, const char **blob);
+static int batch_export();
+
+// The commands of the main loop. An abbreviation of several commands' words picks the one listed first.
+static const Command commands[] = {
+    {STR_cmd_next, "cmd_next", run_next},
+    {STR_cmd_prev, "cmd_prev", run_prev},
+    {STR_cmd_goto, "cmd_goto", run_goto},
+    {STR_cmd_search, "cmd_search", run_search},
+    {STR_cmd_grep, "cmd_grep", run_grep},
+    {STR_cmd_new, "cmd_new", run_new},
+    {STR_cmd_save, "cmd_save", run_save},
+    {STR_cmd_edit, "cmd_edit", run_edit},
+    {STR_cmd_delete, "cmd_delete", run_delete},
+    {STR_cmd_lang, "cmd_lang", run_lang},
+    {STR_cmd_overview, "cmd_overview", run_overview},
+    {STR_cmd_close, "cmd_close", run_close},
+};
 
 // DECLARATIONS
 char *separator_string = "------------------------------------------------------";
-char *data_file = "diary.json";
+char *data_file = "diary.json"; // Overridden by DIARY_FILE
+char *journal_file = NULL;
+char *temp_file = NULL;
+char *index_file = NULL;
+char *index_temp_file = NULL;
+DiaryFormat data_format = DIARY_FORMAT_JSON;
+SyncPolicy sync_policy; // DIARY_SYNC: always (default), never, or group commit limits like 100ms,64ops
+
+// grep lists this many matches before stepping through them
+#define GREP_LISTED 100
+#define SNIPPET_CONTEXT 30
+
+// The journal is compacted into a new snapshot once it outgrows the snapshot
+#define COMPACT_MIN_SIZE (64 * 1024)
 
 char *line = NULL;
 size_t line_capacity = 0;
@@ -111,164 +203,234 @@ Node *tail = NULL;
 Node *current = NULL;
 int num_records = 0;
 
-int main()
+// Notes are decoded from the mapped diary file on demand, so it stays mapped until exit
+MappedFile diary_map;
+
+Journal journal;
+unsigned int next_id = 1;
+long snapshot_size = 0;
+
+// Snapshots are written in the background while the diary is open
+Saver saver;
+int save_requested = 0; // A save was asked for while a snapshot was being written
+int index_stale = 0;    // A snapshot was replaced since the search index file was written
+
+// Date index over the list, built on first use and kept in step with inserts and deletes
+SkipList date_index;
+int date_index_ready = 0;
+int insert_by_date = 0; // DIARY_ORDER=date puts new records in date order instead of after the current one
+
+// Full-text index over the notes, saved next to the diary with every snapshot
+SearchIndex search_index;
+unsigned int snapshot_records = 0; // Records in the snapshot, their ids are 1..snapshot_records
+Node **search_results = NULL;      // Matches of the last search in date order, stepped through by next/previous
+size_t search_count = 0;
+size_t search_position = 0;
+int search_active = 0;
+
+Screen screen; // The main screen, only the lines that changed since the last redraw are sent
+
+// On a terminal the prompt reads single keys, so the arrow keys move without Enter
+KeyReader keys;
+#define PAGE_RECORDS 10 // How far PgUp and PgDn move
+#define OVERVIEW_CHROME 4 // Rows of the overview around the records: the title, two empty lines and the help
+#define OVERVIEW_NOTE_COLUMN 14 // Where the notes start in the overview, after the marker and the date
+#define EDITOR_TITLE_LINES 2 // The title and an empty line above the note
+#define EDITOR_CHROME 4 // Rows of the editor around the note: the title, two empty lines and the help
+#define EDITOR_SAVE_KEY 19 // Ctrl-S
+
+CommandTable command_table; // Sorted by word for the active language on first use and after every language switch
+
+int main(int argc, char **argv)
 {
-    // LANG
-    const char *lang_env = getenv("LANG");
-    const char *lang = (lang_env && strncmp(lang_env, "cs", 2) == 0) ? "cs" : "en";
+    trace_init();
+    if (sync_policy_parse(getenv("DIARY_SYNC"), &sync_policy) != 0)
+    {
+        fprintf(stderr, "Unknown DIARY_SYNC value, syncing every change.\n");
+    }
+    if (argc == 4 && strcmp(argv[1], "convert") == 0)
+    {
+        int status = convert_diary(argv[2], argv[3]);
+        trace_finish();
+        return status;
+    }
 
-    translations = i18n_create_map(21);
-    if (translations == NULL)
+    // FILES
+    const char *file_env = getenv("DIARY_FILE");
+    if (file_env != NULL && file_env[0] != '\0')
+    {
+        data_file = (char *)file_env;
+    }
+    const char *order_env = getenv("DIARY_ORDER");
+    insert_by_date = order_env != NULL && strcmp(order_env, "date") == 0;
+    journal_file = path_with_suffix(data_file, ".log");
+    temp_file = path_with_suffix(data_file, ".tmp");
+    index_file = path_with_suffix(data_file, ".idx");
+    index_temp_file = path_with_suffix(data_file, ".idx.tmp");
+    if (journal_file == NULL || temp_file == NULL || index_file == NULL || index_temp_file == NULL)
     {
-        fprintf(stderr, "Failed to allocate translation map.\n");
+        fprintf(stderr, "Failed to allocate file names.\n");
         return EXIT_FAILURE;
     }
 
-    // if (i18n_load_translations("strings.ini", translations, lang) != 0)
-    if (i18n_load_translations_from_memory((const char *)strings_ini, translations, lang) != 0)
+    // BATCH
+    if (argc >= 2)
+    {
+        int status = run_batch(argc, argv);
+        free(journal_file);
+        free(temp_file);
+        free(index_file);
+        free(index_temp_file);
+        trace_finish();
+        return status;
+    }
+
+    // LANG
+    const char *strings_env = getenv("DIARY_STRINGS"); // More languages or reworded strings, without a rebuild
+    if (strings_env != NULL && strings_env[0] != '\0' && i18n_load(strings_env) != 0)
+    {
+        fprintf(stderr, "Failed to load translations from '%s', using the built-in ones.\n", strings_env);
+    }
+    const char *lang_env = getenv("LANG");
+    char lang[16] = "en";
+    if (lang_env != NULL && strcspn(lang_env, "_.@") < sizeof(lang))
+    {
+        size_t len = strcspn(lang_env, "_.@"); // "cs" of "cs_CZ.UTF-8"
+        memcpy(lang, lang_env, len);
+        lang[len] = '\0';
+    }
+    if (i18n_set_language(lang) != 0)
+    {
+        i18n_set_language("en");
+    }
+    if (command_table_init(&command_table, commands, sizeof(commands) / sizeof(commands[0])) != 0)
     {
-        fprintf(stderr, "Failed to load translations for language '%s'.\n", lang);
-        i18n_free_map(translations);
-        translations = NULL;
+        fprintf(stderr, "Failed to allocate the command table.\n");
+        i18n_unload();
         return EXIT_FAILURE;
     }
 
     // LINKED LIST
-    char *file_content = read_file(data_file);
-    if (file_content != NULL)
+    long long span = trace_begin();
+    int replayed = load_diary(data_file, journal_file, &diary_map, &head, &tail, &num_records, &data_format, &next_id, &snapshot_records);
+    trace_end("load_diary", span);
+    if (replayed < 0)
     {
-        if (ll_from_json_string(file_content,
-                                &head,
-                                &tail,
-                                deserialize_record,
-                                &num_records,
-                                sizeof(Record)) != 0)
-        {
-            fprintf(stderr, "Failed to load diary entries from file.\n");
-            i18n_free_map(translations);
-            translations = NULL;
-            return EXIT_FAILURE;
-        }
-        free(file_content);
-        current = tail;
+        fprintf(stderr, "Failed to load diary entries from file.\n");
+        command_table_destroy(&command_table);
+        i18n_unload();
+        return EXIT_FAILURE;
+    }
+    snapshot_size = (long)diary_map.size;
+    current = tail;
+    span = trace_begin();
+    load_search_index();
+    trace_end("load_search_index", span);
+
+    if (replayed > 0)
+    {
+        // The replayed operations go into a snapshot before the log is started over, if that fails
+        // the log is kept as it is and every change falls back to a full save
+        save_data_now(0);
+    }
+    else if (journal_open(&journal, journal_file, data_file, &sync_policy) != 0)
+    {
+        journal_close(&journal); // Every change falls back to a full save
     }
+    saver_start(&saver); // Without a thread, snapshots are written before save_data returns
+    screen_init(&screen, fileno(stdout));
+    keys_init(&keys, fileno(stdin));
 
     // MAIN LOGIC
     while (1)
     {
-        clear_screen();
-        print_help();
+        finish_save(0);
+        span = trace_begin();
+        screen_begin(&screen);
+        screen_printf(&screen, "%s\n%s\n%s\n\n%s: %d\n", separator_string, _(help), separator_string, _(record_num), num_records);
+
+        if (search_active && search_count > 0)
+        {
+            screen_printf(&screen, "%s: %lu/%lu\n\n", _(search_result), (unsigned long)(search_position + 1), (unsigned long)search_count);
+        }
+        else if (search_active)
+        {
+            screen_printf(&screen, "%s\n\n", _(search_none));
+        }
 
         if (current != NULL)
         {
-            printf("%s: %d.%d.%d\n\n%s\n%s\n\n", _("date"),
-                   ((Record *)current->data)->day,
-                   ((Record *)current->data)->month,
-                   ((Record *)current->data)->year,
-                   ((Record *)current->data)->note ? ((Record *)current->data)->note : "",
-                   separator_string);
+            Record *record = (Record *)current->data;
+            screen_printf(&screen, "%s: %d.%d.%d\n\n", _(date), record->day, record->month, record->year);
+            screen_puts(&screen, record_note(record));
+            screen_printf(&screen, "\n%s\n\n", separator_string);
         }
 
-        printf("%s: ", _("enter_command"));
-        ssize_t read = getline(&line, &line_capacity, stdin);
+        screen_printf(&screen, "%s: ", _(enter_command));
+        screen_flush(&screen);
+        trace_end("draw", span);
+        long steps = 0;
+        int jump = 0;
+        wait_for_input();
+        ssize_t read = read_command(&steps, &jump);
 
+        // Every command is traced under its key until the next redraw, prompts inside a command included
+        span = trace_begin();
         if (read == -1)
         {
             break; // EOF or error
         }
-        else if (command_matches(line, "cmd_prev"))
-        {
-            ll_prev_node(&current);
-        }
-        else if (command_matches(line, "cmd_next"))
-        {
-            ll_next_node(&current);
-        }
-        else if (command_matches(line, "cmd_new"))
-        {
-            new_entry();
-        }
-        else if (command_matches(line, "cmd_save"))
+        // Keys that came in faster than the screen was drawn are added up into one move
+        if (jump != 0)
         {
-            save_data();
+            move_to_end(jump);
         }
-        else if (command_matches(line, "cmd_delete"))
+        move_by(steps);
+        if (read == 0)
         {
-            del_entry();
+            trace_end("keys", span);
+            continue;
         }
-        else if (command_matches(line, "cmd_close"))
+        char *argument = NULL;
+        const Command *command = command_find(&command_table, line, &argument);
+        if (command != NULL && command->run(argument))
         {
             break;
         }
-        else
-        {
-        }
+        trace_end(command != NULL ? command->name : "unknown", span);
     }
 
     // CLEANUP
-    ll_free_list(&head, (free_data_func)free_record);
-    free(line);
-    line = NULL;
-    line_capacity = 0;
-    i18n_free_map(translations);
-    translations = NULL;
-
-    return 0;
-}
-
-// Serializer function for the Record struct
-int serialize_record(void *data, char *buffer, size_t buffer_size)
-{
-    if (data == NULL || buffer == NULL)
-    {
-        return -1;
-    }
-    Record *rec = (Record *)data;
-    // Use snprintf for safe string formatting
-    int result = snprintf(buffer, buffer_size, "{\"day\": %d, \"month\": %d, \"year\": %d, \"note\": \"%s\"}",
-                          rec->day, rec->month, rec->year, rec->note ? rec->note : "");
-
-    if (result < 0 || (size_t)result >= buffer_size)
-    {
-        return -1; // Encoding error or buffer too small
-    }
-    return 0;
-}
-
-int deserialize_record(void *data, const char *json_str, size_t json_size)
-{
-    (void)json_size;
-    if (data == NULL || json_str == NULL)
-    {
-        return -1;
-    }
-    Record *rec = (Record *)data;
-
-    int day = 0;
-    int month = 0;
-    short year = 0;
-    char note_buffer[512] = {0};
-
-    if (sscanf(json_str, "{\"day\": %d, \"month\": %d, \"year\": %hd, \"note\": \"%511[^\"]\"}",
-               &day, &month, &year, note_buffer) != 4)
+    while (saver.busy)
     {
-        return -1;
+        finish_save(1); // A save requested meanwhile starts right after, so this loops at most twice
     }
-
-    rec->day = (char)day;
-    rec->month = (char)month;
-    rec->year = year;
-
-    free(rec->note);
-    rec->note = NULL;
-
-    size_t note_len = strlen(note_buffer);
-    rec->note = (char *)malloc(note_len + 1);
-    if (rec->note == NULL)
+    saver_stop(&saver);
+    if (index_stale && search_index.text != NULL)
     {
-        return -1;
+        span = trace_begin();
+        search_save(&search_index, index_file, index_temp_file, data_file, snapshot_records);
+        trace_end("save_search_index", span);
     }
-    memcpy(rec->note, note_buffer, note_len + 1);
+    journal_close(&journal);
+    clear_search();
+    search_destroy(&search_index);
+    sl_destroy(&date_index);
+    // Nodes, records and notes all live in pools, so the whole diary is released at once
+    ll_free_all(&head, &tail);
+    records_free_all();
+    unmap_file(&diary_map);
+    free(journal_file);
+    free(temp_file);
+    free(index_file);
+    free(index_temp_file);
+    free(line);
+    line = NULL;
+    line_capacity = 0;
+    screen_destroy(&screen);
+    command_table_destroy(&command_table);
+    i18n_unload();
+    trace_finish();
 
     return 0;
 }
@@ -286,223 +448,1876 @@ static void rtrim(char *str)
     }
 }
 
-static int command_matches(char *input, const char *key)
+static int command_matches(char *input, StringKey key)
 {
-    if (!input || !key)
-    {
-        return 0;
-    }
-    const char *localized = _(key);
-    if (!localized)
+    if (!input)
     {
         return 0;
     }
+    const char *localized = i18n_strings[key];
     rtrim(input);
     return strcmp(input, localized) == 0;
 }
 
-static int new_entry()
+// How many records next and previous move, "next 10" moves ten
+static long step_count(const char *argument)
 {
-    clear_screen();
-    print_help();
+    char *end = NULL;
+    long count = strtol(argument, &end, 10);
+    return end != argument && count > 0 ? count : 1;
+}
 
-    printf("\n%s: ", _("enter_date"));
-    ssize_t read = getline(&line, &line_capacity, stdin);
-    if (read == -1)
+// Reads a whole line. On a terminal the key reader owns the input, keys it read ahead come first.
+static ssize_t read_line(void)
+{
+    if (keys.usable)
     {
-        return -1;
+        fflush(stdout); // The reader bypasses stdin, which would have flushed a prompt without a newline
+        return (ssize_t)keys_read_line(&keys, &line, &line_capacity);
     }
+    return getline(&line, &line_capacity, stdin);
+}
 
-    int day = 0;
-    int month = 0;
-    int year = 0;
-    if (!get_date(line, &day, &month, &year))
+// Waits at the prompt until a key comes. Operations a group commit holds back are synced meanwhile once
+// their time limit passes, rather than when the next change is appended, however long that takes.
+static void wait_for_input(void)
+{
+    long wait_ms = journal_sync_due(&journal);
+    while (wait_ms >= 0 && keys.usable && !keys_wait(&keys, (int)wait_ms))
     {
-        return -1;
+        wait_ms = journal_sync_due(&journal);
     }
+}
 
-    char *note_buffer = NULL;
-    size_t note_len = 0;
+// Reads the command line. On a terminal every key is read as it is pressed: text is echoed, and the
+// arrow keys, PgUp/PgDn and Home/End on an empty line move at once. Returns the length of the line,
+// 0 after movement keys (the moves are added up in steps, jump is -1 or 1 for Home or End) or -1 at the end of input.
+static ssize_t read_command(long *steps, int *jump)
+{
+    if (keys_raw_begin(&keys) != 0)
+    {
+        return read_line();
+    }
 
-    printf("%s:\n", _("enter_note"));
+    size_t len = 0;
+    ssize_t result = 0;
+    int moved = 0;
     while (1)
     {
-        read = getline(&line, &line_capacity, stdin);
-        if (read == -1)
+        char c = 0;
+        Key key = keys_read(&keys, &c);
+        if (key == KEY_EOF)
         {
-            free(note_buffer);
-            return -1;
+            // Ctrl-C, Ctrl-D or a hung up terminal, which would report input forever, close the diary
+            result = -1;
+            break;
         }
-
-        size_t line_bytes = (size_t)read;
-        char *line_copy = (char *)malloc(line_bytes + 1);
-        if (line_copy == NULL)
+        if (key == KEY_ENTER)
         {
-            free(note_buffer);
-            return -1;
+            fputs("\n", stdout);
+            result = (ssize_t)len + 1;
+            break;
         }
-        memcpy(line_copy, line, line_bytes + 1);
-
-        int should_save = command_matches(line_copy, "cmd_save");
-        free(line_copy);
-        if (should_save)
+        if (len + 2 >= line_capacity)
         {
-            break;
+            size_t capacity = line_capacity ? line_capacity * 2 : 128;
+            char *grown = (char *)realloc(line, capacity);
+            if (grown == NULL)
+            {
+                result = -1; // Memory allocation failed
+                break;
+            }
+            line = grown;
+            line_capacity = capacity;
         }
 
-        char *temp_ptr = (char *)realloc(note_buffer, note_len + line_bytes + 1);
-        if (temp_ptr == NULL)
+        if (key == KEY_CHAR)
         {
-            free(note_buffer);
-            return -1;
+            line[len++] = c;
+            fputc(c, stdout);
         }
-        note_buffer = temp_ptr;
-
-        memcpy(note_buffer + note_len, line, line_bytes);
-        note_len += line_bytes;
-        note_buffer[note_len] = '\0';
+        else if (key == KEY_BACKSPACE && len > 0)
+        {
+            while (len > 1 && (line[len - 1] & 0xC0) == 0x80)
+            {
+                len--; // A whole UTF-8 character goes at once
+            }
+            len--;
+            fputs("\b \b", stdout);
+        }
+        else if (len == 0 && add_move(key, PAGE_RECORDS, steps, jump))
+        {
+            moved = 1;
+        }
+        if (keys_available(&keys))
+        {
+            continue; // A paste or a held key, echoed in one write once it is all in
+        }
+        fflush(stdout);
+        if (moved && len == 0)
+        {
+            break; // Nothing more came in, time to draw
+        }
+    }
+    keys_raw_end(&keys);
+    fflush(stdout);
+    if (result > 0)
+    {
+        line[len] = '\n';
+        line[len + 1] = '\0';
     }
+    return result;
+}
 
-    Record *new_record = (Record *)malloc(sizeof(Record));
-    if (new_record == NULL)
+// Adds a movement key to the moves read so far, Home and End replace them. Returns 0 for any other key.
+static int add_move(Key key, long page, long *steps, int *jump)
+{
+    if (key < KEY_UP || key > KEY_END)
     {
-        free(note_buffer);
-        return -1;
+        return 0;
     }
-    new_record->day = (char)day;
-    new_record->month = (char)month;
-    new_record->year = (short)year;
-    new_record->note = note_buffer;
+    if (key == KEY_HOME || key == KEY_END)
+    {
+        *jump = key == KEY_HOME ? -1 : 1;
+        *steps = 0;
+        return 1;
+    }
+    long step = key == KEY_PAGE_UP || key == KEY_PAGE_DOWN ? page : 1;
+    *steps += key == KEY_UP || key == KEY_LEFT || key == KEY_PAGE_UP ? -step : step;
+    return 1;
+}
 
-    if (current == NULL)
+// Moves through the records, or through the search results while a search is active
+static void move_by(long steps)
+{
+    if (search_active && search_count > 0)
     {
-        Node *new_node = ll_create_node(new_record);
-        if (new_node == NULL)
+        if (steps < 0)
         {
-            free(note_buffer);
-            free(new_record);
-            return -1;
+            search_position = search_position > (size_t)-steps ? search_position - (size_t)-steps : 0;
         }
-        head = new_node;
-        tail = new_node;
-        current = new_node;
-    }
-    else
-    {
-        Node *previous_next = current->next;
-        ll_insert_after(current, new_record, &tail);
-        if (current->next == previous_next)
+        else
         {
-            free(note_buffer);
-            free(new_record);
-            return -1;
+            search_position = search_count - 1 - search_position > (size_t)steps ? search_position + (size_t)steps : search_count - 1;
         }
+        current = search_results[search_position];
+        return;
+    }
+    for (long i = 0; i < steps && current != NULL && current->next != NULL; i++)
+    {
         ll_next_node(&current);
     }
+    for (long i = 0; i > steps && current != NULL && current->prev != NULL; i--)
+    {
+        ll_prev_node(&current);
+    }
+}
 
-    num_records++;
-
-    save_data();
+// Moves to the first (-1) or the last (1) record or search result
+static void move_to_end(int end)
+{
+    if (search_active && search_count > 0)
+    {
+        search_position = end < 0 ? 0 : search_count - 1;
+        current = search_results[search_position];
+        return;
+    }
+    current = end < 0 ? head : tail;
+}
 
+static int run_prev(char *argument)
+{
+    move_by(-step_count(argument));
     return 0;
 }
 
-static void print_help()
+static int run_next(char *argument)
 {
-    printf("%s\n%s\n%s\n\n%s: %d\n", separator_string, _("help"), separator_string, _("record_num"), num_records);
+    move_by(step_count(argument));
+    return 0;
 }
 
-static void clear_screen()
+static int run_goto(char *argument)
 {
-    printf("\e[1;1H\e[2J");
+    clear_search();
+    goto_date(argument);
+    return 0;
 }
 
-static int get_date(char *date, int *day, int *month, int *year)
+static int run_search(char *argument)
 {
-    rtrim(date);
-    int sday, smonth, syear, chars_read;
-    int result = sscanf(date, "%d.%d.%d%n", &sday, &smonth, &syear, &chars_read);
+    search_notes(argument);
+    return 0;
+}
 
-    if (result != 3 || (size_t)chars_read != strlen(date))
-    {
-        return 0;
-    }
+static int run_grep(char *argument)
+{
+    grep_notes(argument);
+    return 0;
+}
 
-    if (syear < 1)
-    {
-        return 0;
-    }
-    if (smonth < 1 || smonth > 12)
-    {
-        return 0;
-    }
+static int run_new(char *argument)
+{
+    (void)argument;
+    new_entry();
+    return 0;
+}
 
-    int days_in_month[] = {0, 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+static int run_save(char *argument)
+{
+    (void)argument;
+    save_data();
+    return 0;
+}
 
-    if ((syear % 4 == 0 && syear % 100 != 0) || (syear % 400 == 0))
-    {
-        days_in_month[2] = 29; // February has 29 days
-    }
+static int run_edit(char *argument)
+{
+    (void)argument;
+    edit_entry();
+    return 0;
+}
 
-    if (sday < 1 || sday > days_in_month[smonth])
-    {
-        return 0;
-    }
-    *day = sday;
-    *month = smonth;
-    *year = syear;
-    return 1;
+static int run_delete(char *argument)
+{
+    (void)argument;
+    del_entry();
+    return 0;
 }
 
-void free_record(Record *rec)
+static int run_lang(char *argument)
 {
-    if (rec != NULL)
-    {
-        free(rec->note);
-        free(rec);
-    }
+    i18n_set_language(argument); // An unknown code keeps the current language
+    return 0;
 }
 
-static int del_entry()
+// Reads the keys of the overview, every key that already arrived at once. Returns 0 after moves
+// (added up in steps and jump like read_command does), 1 to open the selected record, 2 to go back
+// or -1 at the end of input. Without single keys, an empty line shows the next page and anything else goes back.
+static int read_overview_keys(long page, long *steps, int *jump)
 {
-    if (current == NULL)
+    if (keys_raw_begin(&keys) != 0)
     {
-        return -1;
+        if (read_line() == -1)
+        {
+            return -1;
+        }
+        rtrim(line);
+        if (line[0] != '\0')
+        {
+            return 2;
+        }
+        *steps = page;
+        return 0;
     }
 
-    clear_screen();
-
-    printf("\n%s: %d.%d.%d\n\n%s\n%s\n\n%s: ", _("date"),
-           ((Record *)current->data)->day,
-           ((Record *)current->data)->month,
-           ((Record *)current->data)->year,
-           ((Record *)current->data)->note ? ((Record *)current->data)->note : "",
-           separator_string,
-           _("delete_confirm"));
-
-    ssize_t read = getline(&line, &line_capacity, stdin);
-    if (read == -1)
+    int action = 0;
+    do
     {
-        return -1;
-    }
+        char c = 0;
+        Key key = keys_read(&keys, &c);
+        if (key == KEY_EOF)
+        {
+            action = -1;
+        }
+        else if (key == KEY_ENTER)
+        {
+            action = 1;
+        }
+        else if (key == KEY_ESCAPE || (key == KEY_CHAR && (c == 'q' || c == 'Q')))
+        {
+            action = 2; // Escape, or q
+        }
+        else
+        {
+            add_move(key, page, steps, jump);
+        }
+    } while (action == 0 && keys_available(&keys));
+    keys_raw_end(&keys);
+    return action;
+}
 
-    const char *confirm = _("cmd_confirm");
-    if (command_matches(line, "cmd_confirm") ||
-        (confirm && confirm[0] != '\0' && read > 0 && confirm[0] == line[0]))
+// Draws one page of the overview, a line per record: its date and the start of its note
+static void draw_overview(Node **visible, size_t shown, size_t top, size_t selected, size_t count)
+{
+    long long span = trace_begin();
+    int rows = 0;
+    int cols = 0;
+    screen_size(&screen, &rows, &cols);
+    screen_begin(&screen);
+    screen_printf(&screen, "%s: %lu-%lu/%lu\n\n", _(overview), (unsigned long)(top + 1), (unsigned long)(top + shown), (unsigned long)count);
+    for (size_t i = 0; i < shown; i++)
     {
-        ll_delete_node(&current, &head, &tail, (free_data_func)free_record);
-        num_records--;
+        Record *record = (Record *)visible[i]->data;
+        const char *note = record_note(record);
+        char date[32];
+        snprintf(date, sizeof(date), "%d.%d.%d", record->day, record->month, record->year);
+        size_t first_line = strcspn(note, "\n");
+        size_t fits = screen_fit(note, first_line, OVERVIEW_NOTE_COLUMN, (size_t)cols);
+        screen_printf(&screen, "%c %-*s%.*s\n", top + i == selected ? '>' : ' ', OVERVIEW_NOTE_COLUMN - 2, date, (int)fits, note);
     }
-    save_data();
-    return 0;
+    screen_printf(&screen, "\n%s", _(overview_help));
+    screen_flush(&screen);
+    trace_end("overview_draw", span);
 }
 
-static void save_data()
+// Shows the records in date order, a page at a time. Only the rows on screen are read from the date
+// index, finding where a page starts takes a search down the index, not a walk along the diary.
+static int run_overview(char *argument)
 {
-    char *json = NULL;
-    if (ll_to_json_string(head, &json, serialize_record) == 0)
+    (void)argument;
+    SkipList *index = dates();
+    if (index == NULL || index->count == 0)
     {
-        write_file(data_file, json);
+        return 0;
     }
-    free(json);
-}
\ No newline at end of file
+
+    size_t selected = current != NULL ? sl_rank(index, current) : 0;
+    selected = selected < index->count ? selected : 0;
+    size_t top = 0;
+    int placed = 0;
+    Node **visible = NULL;
+    size_t visible_capacity = 0;
+    int result = 0;
+    while (1)
+    {
+        int rows = 0;
+        int cols = 0;
+        screen_size(&screen, &rows, &cols);
+        size_t page = rows > OVERVIEW_CHROME + 1 ? (size_t)(rows - OVERVIEW_CHROME) : 1;
+        if (page > visible_capacity)
+        {
+            Node **grown = (Node **)realloc(visible, page * sizeof(Node *));
+            if (grown == NULL)
+            {
+                break; // Memory allocation failed
+            }
+            visible = grown;
+            visible_capacity = page;
+        }
+
+        if (!placed)
+        {
+            top = selected > page / 2 ? selected - page / 2 : 0; // The record the overview was opened on starts in the middle
+            placed = 1;
+        }
+        top = selected < top ? selected : top;
+        top = selected >= top + page ? selected - page + 1 : top;
+        top = top + page > index->count ? (index->count > page ? index->count - page : 0) : top; // No empty rows after the last record
+        size_t shown = sl_range(index, top, visible, page);
+        draw_overview(visible, shown, top, selected, index->count);
+
+        long steps = 0;
+        int jump = 0;
+        int action = read_overview_keys((long)page, &steps, &jump);
+        if (action == 1)
+        {
+            current = visible[selected - top];
+            clear_search();
+            break;
+        }
+        if (action != 0)
+        {
+            result = action == -1; // The end of input closes the diary, like at the prompt
+            break;
+        }
+        if (jump != 0)
+        {
+            selected = jump < 0 ? 0 : index->count - 1;
+        }
+        if (steps < 0)
+        {
+            selected = selected > (size_t)-steps ? selected - (size_t)-steps : 0;
+        }
+        else
+        {
+            selected = index->count - 1 - selected > (size_t)steps ? selected + (size_t)steps : index->count - 1;
+        }
+    }
+    free(visible);
+    return result;
+}
+
+static int run_close(char *argument)
+{
+    (void)argument;
+    return 1;
+}
+
+static int new_entry()
+{
+    clear_screen();
+    print_help();
+
+    printf("\n%s: ", _(enter_date));
+    ssize_t read = read_line();
+    if (read == -1)
+    {
+        return -1;
+    }
+
+    int day = 0;
+    int month = 0;
+    int year = 0;
+    if (!get_date(line, &day, &month, &year))
+    {
+        return -1;
+    }
+
+    char *note_buffer = NULL;
+    size_t note_len = 0;
+
+    printf("%s:\n", _(enter_note));
+    if (read_note(&note_buffer, &note_len) != 0)
+    {
+        return -1;
+    }
+
+    Record *new_record = (Record *)record_alloc();
+    if (new_record == NULL || record_set_note(new_record, note_buffer ? note_buffer : "", note_len) != 0)
+    {
+        free_record(new_record);
+        free(note_buffer);
+        return -1;
+    }
+    free(note_buffer); // The note now lives in the note arena
+    new_record->day = (char)day;
+    new_record->month = (char)month;
+    new_record->year = (short)year;
+
+    Node *new_node = insert_record(new_record);
+    if (new_node == NULL)
+    {
+        free_record(new_record);
+        return -1;
+    }
+    current = new_node;
+    num_records++;
+    clear_search();
+    search_add(&search_index, new_node); // On failure the record just cannot be found
+
+    if (date_index_ready && sl_insert(&date_index, new_node) != 0)
+    {
+        sl_destroy(&date_index); // Rebuilt on next use
+        date_index_ready = 0;
+    }
+
+    persist_insert(current);
+
+    return 0;
+}
+
+// Reads the lines of a note until the save command, or until paste brings in the rest of it at once.
+// The note is NULL if nothing came before the end.
+static int read_note(char **note, size_t *len)
+{
+    *note = NULL;
+    *len = 0;
+    Writer text;
+    writer_init_memory(&text); // Grows geometrically, a long paste is copied a bounded number of times
+    int result = 0;
+    while (1)
+    {
+        ssize_t read = read_line();
+        if (read == -1)
+        {
+            result = -1;
+            break;
+        }
+        if (note_line_is(line, (size_t)read, STR_cmd_save))
+        {
+            break;
+        }
+
+        if (note_line_is(line, (size_t)read, STR_cmd_paste))
+        {
+            // The file is asked for on its own line, so no line of a note is ever taken for a path
+            printf("%s: ", _(paste_file));
+            fflush(stdout);
+            if (read_line() == -1)
+            {
+                result = -1;
+                break;
+            }
+            rtrim(line);
+            if (line[0] == '\0')
+            {
+                result = paste_note(&text);
+                break;
+            }
+            MappedFile map;
+            if (map_file(line, &map) != 0)
+            {
+                fprintf(stderr, "Failed to read '%s'.\n", line);
+                continue; // What was typed so far is kept, another line may follow
+            }
+            result = writer_write(&text, map.data, map.size);
+            unmap_file(&map);
+            break;
+        }
+
+        if (writer_write(&text, line, (size_t)read) != 0)
+        {
+            result = -1;
+            break;
+        }
+    }
+
+    if (result == 0 && text.used > 0)
+    {
+        *note = writer_detach(&text, len);
+        result = *note != NULL ? 0 : -1;
+    }
+    writer_close(&text);
+    return result;
+}
+
+// Checks whether a line of a note is a command word alone, trailing whitespace aside, without copying it
+static int note_line_is(const char *input, size_t len, StringKey key)
+{
+    const char *word = i18n_strings[key];
+    while (len > 0 && isspace((unsigned char)input[len - 1]))
+    {
+        len--;
+    }
+    return len == strlen(word) && memcmp(input, word, len) == 0;
+}
+
+// Takes the rest of a note at once. On a terminal the paste is read a block at a time as the terminal
+// delivers it, without echo, until Ctrl-D, Ctrl-C discards the note. Otherwise the rest of the input is read.
+static int paste_note(Writer *text)
+{
+    if (!keys.usable)
+    {
+        return read_all(stdin, text);
+    }
+    printf("%s\n", _(paste_help));
+    fflush(stdout);
+    if (keys_raw_begin(&keys) != 0)
+    {
+        return -1;
+    }
+
+    int result = 0;
+    int after_cr = 0;
+    int stop = 0;
+    while (stop == 0)
+    {
+        const char *block = NULL;
+        size_t len = keys_read_paste(&keys, &block, &stop);
+        if (put_pasted(text, block, len, &after_cr) != 0)
+        {
+            result = -1;
+            break;
+        }
+        if (stop == 0 && !keys_available(&keys))
+        {
+            printf("\r%s: %lu", _(pasted), (unsigned long)text->used); // Only once the paste pauses
+            fflush(stdout);
+        }
+    }
+    keys_raw_end(&keys);
+    printf("\r%s: %lu\n", _(pasted), (unsigned long)text->used);
+    return stop == 3 ? -1 : result;
+}
+
+// Appends a pasted block. Raw mode leaves Enter as '\r', the lines of the note end in '\n' all the same.
+static int put_pasted(Writer *text, const char *block, size_t len, int *after_cr)
+{
+    size_t start = 0;
+    if (*after_cr && len > 0 && block[0] == '\n')
+    {
+        start = 1; // The second half of a "\r\n" split between blocks
+    }
+    *after_cr = 0;
+    while (start < len)
+    {
+        const char *cr = (const char *)memchr(block + start, '\r', len - start);
+        size_t end = cr != NULL ? (size_t)(cr - block) : len;
+        if (writer_write(text, block + start, end - start) != 0)
+        {
+            return -1;
+        }
+        if (cr == NULL)
+        {
+            break;
+        }
+        if (writer_putc(text, '\n') != 0)
+        {
+            return -1;
+        }
+        start = end + 1;
+        if (start == len)
+        {
+            *after_cr = 1;
+        }
+        else if (block[start] == '\n')
+        {
+            start++;
+        }
+    }
+    return 0;
+}
+
+// Reads a stream to its end in large blocks
+static int read_all(FILE *file, Writer *text)
+{
+    static char chunk[WRITER_CHUNK_SIZE];
+    size_t read = 0;
+    while ((read = fread(chunk, 1, sizeof(chunk), file)) > 0)
+    {
+        if (writer_write(text, chunk, read) != 0)
+        {
+            return -1;
+        }
+    }
+    return ferror(file) ? -1 : 0;
+}
+
+// Edits the note of the current record. On a terminal the note is edited in place with the cursor keys,
+// without one it is typed again in full, like a new one. Only the changed record is persisted.
+static int edit_entry()
+{
+    if (current == NULL)
+    {
+        return -1;
+    }
+    Record *record = (Record *)current->data;
+    const char *note = record_note(record);
+
+    if (keys_raw_begin(&keys) != 0)
+    {
+        clear_screen();
+        printf("\n%s: %d.%d.%d\n\n%s\n%s\n\n%s:\n", _(date), record->day, record->month, record->year, note,
+               separator_string, _(enter_note));
+        char *typed = NULL;
+        size_t typed_len = 0;
+        if (read_note(&typed, &typed_len) != 0)
+        {
+            return -1;
+        }
+        int result = update_note(current, typed != NULL ? typed : "", typed_len);
+        free(typed);
+        return result;
+    }
+
+    GapBuffer text;
+    if (gap_init(&text, note, strlen(note)) != 0)
+    {
+        keys_raw_end(&keys);
+        return -1;
+    }
+    int result = edit_text(&text, record);
+    keys_raw_end(&keys);
+    if (result == 1)
+    {
+        size_t len = 0;
+        const char *edited = gap_text(&text, &len);
+        result = edited != NULL ? update_note(current, edited, len) : -1;
+    }
+    gap_destroy(&text);
+    return result;
+}
+
+// The column after a byte, counted the way the screen counts them: a UTF-8 character takes one
+// column, a tab runs to the next multiple of 8 and other control characters take none
+static size_t advance_column(size_t column, char c)
+{
+    unsigned char byte = (unsigned char)c;
+    if (byte == '\t')
+    {
+        return (column / 8 + 1) * 8;
+    }
+    return byte >= 0x20 && (byte & 0xC0) != 0x80 ? column + 1 : column;
+}
+
+// The column a position of a line is shown at
+static size_t text_column(const GapBuffer *text, size_t start, size_t position)
+{
+    size_t column = 0;
+    for (size_t i = start; i < position; i++)
+    {
+        column = advance_column(column, gap_at(text, i));
+    }
+    return column;
+}
+
+// The position after the character at a position, a UTF-8 character is skipped whole
+static size_t next_char(const GapBuffer *text, size_t position)
+{
+    size_t len = gap_length(text);
+    if (position < len)
+    {
+        position++;
+    }
+    while (position < len && (gap_at(text, position) & 0xC0) == 0x80)
+    {
+        position++;
+    }
+    return position;
+}
+
+// The position of the character before a position
+static size_t prev_char(const GapBuffer *text, size_t position)
+{
+    if (position > 0)
+    {
+        position--;
+    }
+    while (position > 0 && (gap_at(text, position) & 0xC0) == 0x80)
+    {
+        position--;
+    }
+    return position;
+}
+
+// The position on the line starting at start that is shown at a column, or the end of a shorter line
+static size_t column_position(const GapBuffer *text, size_t start, size_t column)
+{
+    size_t end = gap_line_end(text, start);
+    size_t at = 0;
+    size_t position = start;
+    while (position < end)
+    {
+        size_t after = advance_column(at, gap_at(text, position));
+        if (after > column)
+        {
+            break;
+        }
+        at = after;
+        position = next_char(text, position);
+    }
+    return position;
+}
+
+// Adds the part of a line shown from column shift on to the screen, as much of it as fits in width
+// columns. Tabs become spaces, so the terminal shows every character where the editor counts it.
+static void put_text_line(const GapBuffer *text, size_t start, size_t end, size_t shift, size_t width)
+{
+    char chunk[256];
+    size_t used = 0;
+    size_t column = 0;
+    int shown = 0; // The last character is on screen, so are the rest of its bytes
+    for (size_t i = start; i < end; i++)
+    {
+        char c = gap_at(text, i);
+        size_t next = advance_column(column, c);
+        if (c == '\t')
+        {
+            size_t from = column > shift ? column : shift;
+            size_t to = next < shift + width ? next : shift + width;
+            for (; from < to; from++)
+            {
+                chunk[used++] = ' ';
+            }
+            shown = 0;
+        }
+        else if ((c & 0xC0) != 0x80)
+        {
+            shown = column >= shift && next <= shift + width && (unsigned char)c >= 0x20;
+        }
+        if (next > shift + width)
+        {
+            break;
+        }
+        if (shown)
+        {
+            chunk[used++] = c;
+        }
+        column = next;
+        if (used + 8 > sizeof(chunk))
+        {
+            screen_printf(&screen, "%.*s", (int)used, chunk);
+            used = 0;
+        }
+    }
+    screen_printf(&screen, "%.*s", (int)used, chunk);
+}
+
+// Draws the note being edited from the line at top, moving top first so the cursor's line is on screen.
+// Only the lines on screen are read. Returns how many lines of the note fit.
+static size_t draw_editor(const GapBuffer *text, size_t *top, const Record *record)
+{
+    long long span = trace_begin();
+    int rows = 0;
+    int cols = 0;
+    screen_size(&screen, &rows, &cols);
+    size_t page = rows > EDITOR_CHROME + 1 ? (size_t)(rows - EDITOR_CHROME) : 1;
+    size_t width = cols > 1 ? (size_t)cols - 1 : 1; // The last column stays free, so no line wraps
+    size_t cursor = text->gap_start;
+    size_t cursor_start = gap_line_start(text, cursor);
+
+    if (cursor_start < *top)
+    {
+        *top = cursor_start;
+    }
+    size_t lines = 0;
+    for (size_t position = *top; position < cursor_start && lines < page; position = gap_line_end(text, position) + 1)
+    {
+        lines++;
+    }
+    if (lines == page)
+    {
+        // The cursor went below the last row, its line becomes the last one
+        *top = cursor_start;
+        for (size_t i = 1; i < page && *top > 0; i++)
+        {
+            *top = gap_line_start(text, *top - 1);
+        }
+    }
+
+    screen_begin(&screen);
+    screen_printf(&screen, "%s: %d.%d.%d\n\n", _(edit_title), record->day, record->month, record->year);
+    size_t len = gap_length(text);
+    size_t position = *top;
+    for (size_t row = 0; row < page; row++)
+    {
+        size_t end = gap_line_end(text, position);
+        size_t shift = 0;
+        if (position == cursor_start)
+        {
+            // A line too long for the screen is shown from a multiple of half the width, so the cursor stays on it
+            size_t column = text_column(text, position, cursor);
+            size_t half = width / 2 > 0 ? width / 2 : 1;
+            shift = column < width ? 0 : (column / half - 1) * half;
+            screen_cursor(&screen, EDITOR_TITLE_LINES + row, column - shift);
+        }
+        put_text_line(text, position, end, shift, width);
+        screen_puts(&screen, "\n");
+        if (end >= len)
+        {
+            break;
+        }
+        position = end + 1;
+    }
+    const char *help = _(edit_help);
+    screen_printf(&screen, "\n%.*s", (int)screen_fit(help, strlen(help), 0, width), help);
+    screen_flush(&screen);
+    trace_end("edit_draw", span);
+    return page;
+}
+
+// Edits a note until it is saved with Ctrl-S (returns 1) or dropped with Escape, Ctrl-C or the end of input (returns 0).
+// Keys that arrived together, a paste for one, all go into the text before the screen is drawn again.
+static int edit_text(GapBuffer *text, Record *record)
+{
+    size_t top = 0;
+    size_t goal = 0; // The column the up and down keys keep to
+    int vertical = 0;
+    while (1)
+    {
+        size_t page = draw_editor(text, &top, record);
+        do
+        {
+            char c = 0;
+            Key key = keys_read(&keys, &c);
+            size_t cursor = text->gap_start;
+            int was_vertical = vertical;
+            vertical = 0;
+            switch (key)
+            {
+            case KEY_EOF:
+            case KEY_ESCAPE:
+                return 0;
+            case KEY_CONTROL:
+                if (c == EDITOR_SAVE_KEY)
+                {
+                    return 1;
+                }
+                if (c == '\t')
+                {
+                    gap_insert(text, &c, 1); // On failure the key is just lost
+                }
+                break;
+            case KEY_CHAR:
+                gap_insert(text, &c, 1);
+                break;
+            case KEY_ENTER:
+                gap_insert(text, "\n", 1);
+                break;
+            case KEY_BACKSPACE:
+                gap_delete_before(text, cursor - prev_char(text, cursor));
+                break;
+            case KEY_DELETE:
+                gap_delete_after(text, next_char(text, cursor) - cursor);
+                break;
+            case KEY_LEFT:
+                gap_move(text, prev_char(text, cursor));
+                break;
+            case KEY_RIGHT:
+                gap_move(text, next_char(text, cursor));
+                break;
+            case KEY_HOME:
+                gap_move(text, gap_line_start(text, cursor));
+                break;
+            case KEY_END:
+                gap_move(text, gap_line_end(text, cursor));
+                break;
+            case KEY_UP:
+            case KEY_DOWN:
+            case KEY_PAGE_UP:
+            case KEY_PAGE_DOWN:
+            {
+                size_t start = gap_line_start(text, cursor);
+                goal = was_vertical ? goal : text_column(text, start, cursor);
+                vertical = 1;
+                int up = key == KEY_UP || key == KEY_PAGE_UP;
+                for (size_t lines = key == KEY_UP || key == KEY_DOWN ? 1 : page; lines > 0; lines--)
+                {
+                    size_t end = gap_line_end(text, start);
+                    if (up ? start == 0 : end == gap_length(text))
+                    {
+                        break;
+                    }
+                    start = up ? gap_line_start(text, start - 1) : end + 1;
+                }
+                gap_move(text, column_position(text, start, goal));
+                break;
+            }
+            default:
+                break;
+            }
+        } while (keys_available(&keys));
+    }
+}
+
+// Replaces the note of a record and persists only that record. A note that did not change is left alone.
+static int update_note(Node *node, const char *note, size_t len)
+{
+    Record *record = (Record *)node->data;
+    const char *old = record_note(record);
+    if (strlen(old) == len && memcmp(old, note, len) == 0)
+    {
+        return 0;
+    }
+
+    search_remove(&search_index, node);
+    // The old note stays in the arena, so a snapshot being written still reads it
+    int result = record_set_note(record, note, len);
+    search_add(&search_index, node); // On failure the record just cannot be found
+    if (result != 0)
+    {
+        return -1;
+    }
+    clear_search(); // The results were found in the old note
+
+    if (!index_stale)
+    {
+        // The index file still has the old note's terms. It is written again at close, until
+        // then there must be none, or a crash would leave them to the next start.
+        remove(index_file);
+        index_stale = 1;
+    }
+    persist_update(node);
+    return 0;
+}
+
+// Links a new record into the list, after the current one or in date order
+static Node *insert_record(Record *rec)
+{
+    Node *anchor = current;
+    int before = 0;
+    if (insert_by_date && dates() != NULL)
+    {
+        // After the last record on or before its date, or in front of the earliest one
+        anchor = sl_floor(&date_index, rec);
+        if (anchor == NULL)
+        {
+            anchor = sl_first(&date_index);
+            before = 1;
+        }
+    }
+
+    if (anchor == NULL)
+    {
+        Node *new_node = ll_create_node(rec);
+        if (new_node != NULL)
+        {
+            head = new_node;
+            tail = new_node;
+        }
+        return new_node;
+    }
+    if (before)
+    {
+        Node *previous_prev = anchor->prev;
+        ll_insert_before(anchor, rec, &head);
+        return anchor->prev != previous_prev ? anchor->prev : NULL;
+    }
+    Node *previous_next = anchor->next;
+    ll_insert_after(anchor, rec, &tail);
+    return anchor->next != previous_next ? anchor->next : NULL;
+}
+
+// Returns the date index, building it the first time it is needed
+static SkipList *dates()
+{
+    if (!date_index_ready)
+    {
+        sl_init(&date_index, compare_record_date);
+        if (sl_build(&date_index, head) != 0)
+        {
+            sl_destroy(&date_index); // The next call starts over, its sl_init must not drop live pools
+            return NULL;
+        }
+        date_index_ready = 1;
+    }
+    return &date_index;
+}
+
+// Moves to the first record on or after a date, or to the latest record if there is none
+static int goto_date(char *date)
+{
+    if (date[0] == '\0')
+    {
+        printf("\n%s: ", _(enter_date));
+        if (read_line() == -1)
+        {
+            return -1;
+        }
+        date = line;
+    }
+
+    Record key = {0};
+    int day = 0;
+    int month = 0;
+    int year = 0;
+    if (!get_date(date, &day, &month, &year) || dates() == NULL)
+    {
+        return -1;
+    }
+    key.day = (char)day;
+    key.month = (char)month;
+    key.year = (short)year;
+
+    Node *found = sl_lower_bound(&date_index, &key);
+    if (found == NULL)
+    {
+        found = sl_floor(&date_index, &key);
+    }
+    if (found != NULL)
+    {
+        current = found;
+    }
+    return 0;
+}
+
+// Runs a full-text search and moves to the earliest match. An empty query ends the search.
+static int search_notes(const char *query)
+{
+    clear_search();
+    if (query[0] == '\0')
+    {
+        return 0;
+    }
+    if (search_query(&search_index, query, &search_results, &search_count) != 0)
+    {
+        return -1;
+    }
+    qsort(search_results, search_count, sizeof(Node *), compare_nodes_by_date);
+    search_active = 1;
+    if (search_count > 0)
+    {
+        current = search_results[0];
+    }
+    return 0;
+}
+
+// Scans every note for a substring, lists the matches in list order and then steps through them
+static int grep_notes(const char *pattern)
+{
+    clear_search();
+    if (pattern[0] == '\0')
+    {
+        return 0;
+    }
+
+    GrepMatch *matches = NULL;
+    size_t count = 0;
+    size_t pattern_len = strlen(pattern);
+    if (grep_list(head, pattern, pattern_len, record_note_view, &matches, &count) != 0)
+    {
+        return -1;
+    }
+
+    clear_screen();
+    for (size_t i = 0; i < count && i < GREP_LISTED; i++)
+    {
+        Record *rec = (Record *)matches[i].node->data;
+        printf("%d.%d.%d: ", rec->day, rec->month, rec->year);
+        print_snippet(record_note(rec), matches[i].offset, pattern_len);
+    }
+    printf("\n%s: %lu\n%s", _(grep_matches), (unsigned long)count, _(press_enter));
+    read_line();
+
+    search_results = (Node **)malloc((count > 0 ? count : 1) * sizeof(Node *));
+    if (search_results == NULL)
+    {
+        free(matches);
+        return -1;
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        search_results[i] = matches[i].node;
+    }
+    free(matches);
+    search_count = count;
+    search_active = 1;
+    if (count > 0)
+    {
+        current = search_results[0];
+    }
+    return 0;
+}
+
+// Prints the text around a match on one line, without cutting a UTF-8 character in half
+static void print_snippet(const char *note, size_t offset, size_t pattern_len)
+{
+    size_t len = strlen(note);
+    size_t start = offset > SNIPPET_CONTEXT ? offset - SNIPPET_CONTEXT : 0;
+    size_t end = offset + pattern_len + SNIPPET_CONTEXT < len ? offset + pattern_len + SNIPPET_CONTEXT : len;
+    while (start > 0 && ((unsigned char)note[start] & 0xC0) == 0x80)
+    {
+        start--;
+    }
+    while (end < len && ((unsigned char)note[end] & 0xC0) == 0x80)
+    {
+        end++;
+    }
+
+    printf("%s", start > 0 ? "..." : "");
+    for (size_t i = start; i < end; i++)
+    {
+        putchar(note[i] == '\n' || note[i] == '\r' || note[i] == '\t' ? ' ' : note[i]);
+    }
+    printf("%s\n", end < len ? "..." : "");
+}
+
+static void clear_search()
+{
+    free(search_results);
+    search_results = NULL;
+    search_count = 0;
+    search_position = 0;
+    search_active = 0;
+}
+
+static int compare_nodes_by_date(const void *a, const void *b)
+{
+    const Node *first = *(Node *const *)a;
+    const Node *second = *(Node *const *)b;
+    int order = compare_record_date(first->data, second->data);
+    return order != 0 ? order : (first > second) - (first < second);
+}
+
+// Loads the saved search index, or builds it from every note and saves it for the next start
+static void load_search_index()
+{
+    search_init(&search_index, (data_text_func)record_note);
+    if (search_load(&search_index, index_file, data_file, head) == 0)
+    {
+        return;
+    }
+    if (search_build(&search_index, head) != 0)
+    {
+        search_destroy(&search_index); // Searching finds nothing rather than keeping the diary closed
+        search_init(&search_index, (data_text_func)record_note);
+        return;
+    }
+    search_save(&search_index, index_file, index_temp_file, data_file, snapshot_records);
+}
+
+static void print_help()
+{
+    printf("%s\n%s\n%s\n\n%s: %d\n", separator_string, _(help), separator_string, _(record_num), num_records);
+}
+
+static void clear_screen()
+{
+    screen_invalidate(&screen); // Whatever is printed next covers the main screen
+    printf("\e[1;1H\e[2J");
+}
+
+static int get_date(char *date, int *day, int *month, int *year)
+{
+    rtrim(date);
+    int sday, smonth, syear, chars_read;
+    int result = sscanf(date, "%d.%d.%d%n", &sday, &smonth, &syear, &chars_read);
+
+    if (result != 3 || (size_t)chars_read != strlen(date))
+    {
+        return 0;
+    }
+
+    if (syear < 1)
+    {
+        return 0;
+    }
+    if (smonth < 1 || smonth > 12)
+    {
+        return 0;
+    }
+
+    int days_in_month[] = {0, 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+
+    if ((syear % 4 == 0 && syear % 100 != 0) || (syear % 400 == 0))
+    {
+        days_in_month[2] = 29; // February has 29 days
+    }
+
+    if (sday < 1 || sday > days_in_month[smonth])
+    {
+        return 0;
+    }
+    *day = sday;
+    *month = smonth;
+    *year = syear;
+    return 1;
+}
+
+static int del_entry()
+{
+    if (current == NULL)
+    {
+        return -1;
+    }
+
+    clear_screen();
+
+    printf("\n%s: %d.%d.%d\n\n%s\n%s\n\n%s: ", _(date),
+           ((Record *)current->data)->day,
+           ((Record *)current->data)->month,
+           ((Record *)current->data)->year,
+           record_note((Record *)current->data),
+           separator_string,
+           _(delete_confirm));
+
+    ssize_t read = read_line();
+    if (read == -1)
+    {
+        return -1;
+    }
+
+    const char *confirm = _(cmd_confirm);
+    if (command_matches(line, STR_cmd_confirm) ||
+        (confirm && confirm[0] != '\0' && read > 0 && confirm[0] == line[0]))
+    {
+        unsigned int id = current->id;
+        if (date_index_ready)
+        {
+            sl_remove(&date_index, current);
+        }
+        search_remove(&search_index, current);
+        clear_search();
+        ll_delete_node(&current, &head, &tail, (free_data_func)free_record);
+        num_records--;
+        persist_delete(id);
+    }
+    return 0;
+}
+
+// Hands a copy of the list to the saver, which writes it to the temporary file while the diary stays usable.
+// Saves asked for while a snapshot is being written are folded into one that starts once it is in place.
+static void save_data()
+{
+    if (saver.busy)
+    {
+        save_requested = 1;
+        return;
+    }
+    save_requested = 0;
+
+    // The copy shares the notes with the list. They are never changed in place and live
+    // in the arena or the mapped diary file until exit, so the saver can read them freely.
+    long long span = trace_begin();
+    size_t count = 0;
+    Node *snapshot = ll_snapshot(head, sizeof(Record), &count);
+    if ((snapshot == NULL && count > 0) || journal_mark(&journal, (unsigned int)count) != 0)
+    {
+        free(snapshot);
+        trace_end("snapshot", span);
+        save_data_now(1); // Without a marker the journal cannot be carried over to the new snapshot
+        return;
+    }
+    number_records(); // Operations after the marker use the snapshot's ids
+    if (saver_submit(&saver, snapshot, temp_file, data_format, sync_policy.mode != SYNC_NEVER) != 0)
+    {
+        free(snapshot);
+    }
+    trace_end("snapshot", span);
+    if (!saver.busy)
+    {
+        save_data_now(1); // The saver was not started
+    }
+}
+
+// Puts the snapshot the saver wrote in place of the diary and carries the journal over to it
+static void finish_save(int wait)
+{
+    int result = -1;
+    size_t written = 0;
+    if (!saver_collect(&saver, wait, &result, &written))
+    {
+        return;
+    }
+
+    // Notes that were never decoded still point into the mapped diary file,
+    // so the new snapshot was written next to it and is renamed over it
+    long long span = trace_begin();
+    if (result == 0 && replace_file(temp_file, data_file) == 0)
+    {
+        if (sync_policy.mode != SYNC_NEVER)
+        {
+            sync_dir(data_file);
+        }
+        snapshot_size = (long)written;
+        restart_journal(1);
+        index_stale = 1; // The index is written at close, off the path of every save
+    }
+    else
+    {
+        remove(temp_file); // The old diary and the journal up to its marker still hold everything
+    }
+    trace_end("finish_save", span);
+
+    if (save_requested)
+    {
+        save_data();
+    }
+}
+
+// Writes a full snapshot on this thread and empties the journal. With mark set, a marker goes
+// into the journal first, so a crash before it is emptied cannot replay an older marker onto
+// the new snapshot. A journal with a torn tail cannot take one.
+static void save_data_now(int mark)
+{
+    int marked = mark && journal_mark(&journal, (unsigned int)num_records) == 0;
+    if (marked)
+    {
+        number_records();
+    }
+
+    size_t written = 0;
+    long long span = trace_begin();
+    int saved = storage_save(head, data_file, temp_file, data_format, sync_policy.mode != SYNC_NEVER, &written);
+    trace_end("save", span);
+    if (saved == 0)
+    {
+        snapshot_size = (long)written;
+        restart_journal(marked);
+        number_records();
+        if (search_index.text != NULL)
+        {
+            span = trace_begin();
+            search_save(&search_index, index_file, index_temp_file, data_file, snapshot_records);
+            trace_end("save_search_index", span);
+            index_stale = 0;
+        }
+    }
+}
+
+// Carries the journal over to the snapshot that was just written. A journal that is not open, because
+// its log held operations no snapshot had yet or could not be opened, starts a fresh log now.
+static void restart_journal(int marked)
+{
+    if (journal.path == NULL)
+    {
+        if (journal_open(&journal, journal_file, data_file, &sync_policy) != 0 || journal_reset(&journal, data_file) != 0)
+        {
+            journal_close(&journal);
+        }
+    }
+    else if (marked)
+    {
+        journal_rebase(&journal, data_file);
+    }
+    else
+    {
+        journal_reset(&journal, data_file);
+    }
+}
+
+// Ids restart from the snapshot order, the same way the next replay numbers them
+static void number_records()
+{
+    next_id = 1;
+    for (Node *node = head; node != NULL; node = node->next)
+    {
+        node->id = next_id++;
+    }
+    snapshot_records = next_id - 1;
+}
+
+static void compact_if_needed()
+{
+    if (journal.size > COMPACT_MIN_SIZE && journal.size > snapshot_size)
+    {
+        save_data();
+    }
+}
+
+static void persist_insert(Node *node)
+{
+    unsigned int after_id = node->prev != NULL ? node->prev->id : 0;
+    node->id = next_id++;
+    if (journal_append_insert(&journal, after_id, node->data, serialize_record) != 0)
+    {
+        save_data();
+        return;
+    }
+    compact_if_needed();
+}
+
+static void persist_update(Node *node)
+{
+    if (node->id == 0 || journal_append_update(&journal, node->id, node->data, serialize_record) != 0)
+    {
+        save_data();
+        return;
+    }
+    compact_if_needed();
+}
+
+static void persist_delete(unsigned int id)
+{
+    if (journal_append_delete(&journal, id) != 0)
+    {
+        save_data();
+        return;
+    }
+    compact_if_needed();
+}
+
+static char *path_with_suffix(const char *path, const char *suffix)
+{
+    size_t path_len = strlen(path);
+    size_t suffix_len = strlen(suffix);
+    char *result = (char *)malloc(path_len + suffix_len + 1);
+    if (result == NULL)
+    {
+        return NULL;
+    }
+    memcpy(result, path, path_len);
+    memcpy(result + path_len, suffix, suffix_len + 1);
+    return result;
+}
+
+// Loads a diary snapshot in any format and replays its journal over it.
+// Returns the journal_replay result: -1 on failure, 1 if the journal had a torn tail.
+static int load_diary(const char *path,
+                      const char *log_path,
+                      MappedFile *map,
+                      Node **list_head,
+                      Node **list_tail,
+                      int *length,
+                      DiaryFormat *format,
+                      unsigned int *first_free_id,
+                      unsigned int *snapshot_length)
+{
+    long long span = trace_begin();
+    int mapped = map_file(path, map);
+    trace_end("map_file", span);
+    if (mapped == 0 && map->size > 0)
+    {
+        span = trace_begin();
+        int parsed = storage_load(map->data, map->size, list_head, list_tail, length, format);
+        trace_end("parse", span);
+        if (parsed != 0)
+        {
+            return -1;
+        }
+    }
+    *snapshot_length = (unsigned int)*length;
+
+    span = trace_begin();
+    int replayed = journal_replay(log_path,
+                                  path,
+                                  list_head,
+                                  list_tail,
+                                  length,
+                                  deserialize_record,
+                                  record_alloc,
+                                  (free_data_func)free_record,
+                                  first_free_id);
+    trace_end("replay", span);
+    return replayed;
+}
+
+// Writes a diary (with its journal applied) in the other format
+static int convert_diary(const char *input, const char *output)
+{
+    MappedFile map = {0};
+    Node *list_head = NULL;
+    Node *list_tail = NULL;
+    int length = 0;
+    DiaryFormat format = DIARY_FORMAT_JSON;
+    unsigned int first_free_id = 1;
+    unsigned int snapshot_length = 0;
+    int result = EXIT_FAILURE;
+
+    char *log_path = path_with_suffix(input, ".log");
+    char *temp_path = path_with_suffix(output, ".tmp");
+    if (log_path == NULL || temp_path == NULL)
+    {
+        fprintf(stderr, "Failed to allocate file names.\n");
+    }
+    else if (load_diary(input, log_path, &map, &list_head, &list_tail, &length, &format, &first_free_id, &snapshot_length) < 0)
+    {
+        fprintf(stderr, "Failed to load diary entries from '%s'.\n", input);
+    }
+    else
+    {
+        DiaryFormat target = format == DIARY_FORMAT_JSON ? DIARY_FORMAT_BINARY : DIARY_FORMAT_JSON;
+        if (storage_save(list_head, output, temp_path, target, sync_policy.mode != SYNC_NEVER, NULL) != 0)
+        {
+            fprintf(stderr, "Failed to write '%s'.\n", output);
+        }
+        else
+        {
+            printf("%d records converted to %s.\n", length, target == DIARY_FORMAT_BINARY ? "binary" : "JSON");
+            result = EXIT_SUCCESS;
+        }
+    }
+
+    ll_free_all(&list_head, &list_tail);
+    records_free_all();
+    unmap_file(&map);
+    free(log_path);
+    free(temp_path);
+    return result;
+}
+
+// Non-interactive subcommands for scripts. They print plain text and never draw the UI.
+static int run_batch(int argc, char **argv)
+{
+    if (strcmp(argv[1], "add") == 0)
+    {
+        return batch_add(argc, argv);
+    }
+    if (strcmp(argv[1], "list") == 0)
+    {
+        return batch_list(argc, argv);
+    }
+    if (strcmp(argv[1], "show") == 0)
+    {
+        return batch_show(argc, argv);
+    }
+    if (strcmp(argv[1], "count") == 0)
+    {
+        return batch_count();
+    }
+    if (strcmp(argv[1], "export") == 0)
+    {
+        return batch_export();
+    }
+
+    fprintf(stderr,
+            "Usage: %s [command]\n"
+            "Without a command the diary opens interactively.\n"
+            "  add --date D.M.YYYY     Add a record, the note is read from stdin\n"
+            "  list [--from D.M.YYYY] [--to D.M.YYYY]\n"
+            "                          List records as number, date and first line\n"
+            "  show N                  Print record number N\n"
+            "  count                   Print the number of records\n"
+            "  export                  Print the diary as JSON\n"
+            "  convert IN OUT          Write a diary in the other format\n",
+            argv[0]);
+    return EXIT_FAILURE;
+}
+
+// Returns the argument that follows an option, or NULL if the option is missing
+static const char *option_value(int argc, char **argv, const char *name)
+{
+    for (int i = 2; i + 1 < argc; i++)
+    {
+        if (strcmp(argv[i], name) == 0)
+        {
+            return argv[i + 1];
+        }
+    }
+    return NULL;
+}
+
+static int parse_date_option(const char *value, Record *date)
+{
+    char buffer[32];
+    int day = 0;
+    int month = 0;
+    int year = 0;
+    if (value == NULL || strlen(value) >= sizeof(buffer))
+    {
+        return 0;
+    }
+    strcpy(buffer, value); // get_date trims its input
+    if (!get_date(buffer, &day, &month, &year))
+    {
+        return 0;
+    }
+    date->day = (char)day;
+    date->month = (char)month;
+    date->year = (short)year;
+    return 1;
+}
+
+static int batch_load()
+{
+    if (load_diary(data_file, journal_file, &diary_map, &head, &tail, &num_records, &data_format, &next_id, &snapshot_records) < 0)
+    {
+        fprintf(stderr, "Failed to load diary entries from file.\n");
+        return -1;
+    }
+    snapshot_size = (long)diary_map.size;
+    return 0;
+}
+
+static void batch_unload()
+{
+    ll_free_all(&head, &tail);
+    records_free_all();
+    unmap_file(&diary_map);
+}
+
+// Appends to the journal without loading the diary, so it takes the same time however large the diary is
+static int batch_add(int argc, char **argv)
+{
+    Record date = {0};
+    if (!parse_date_option(option_value(argc, argv, "--date"), &date))
+    {
+        fprintf(stderr, "Usage: %s add --date D.M.YYYY < note\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    Writer text;
+    writer_init_memory(&text);
+    size_t note_len = 0;
+    char *note = read_all(stdin, &text) == 0 ? writer_detach(&text, &note_len) : NULL;
+    writer_close(&text);
+    if (note == NULL)
+    {
+        fprintf(stderr, "Failed to read the note.\n");
+        return EXIT_FAILURE;
+    }
+
+    // A torn tail would swallow anything appended after it, so such a journal is compacted first.
+    // The log is only started over once the snapshot holding its operations is written.
+    int status = EXIT_SUCCESS;
+    if (journal_check(journal_file, data_file) != 0)
+    {
+        if (batch_load() != 0)
+        {
+            status = EXIT_FAILURE;
+        }
+        else
+        {
+            save_data_now(0);
+            status = journal.path != NULL ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+        journal_close(&journal);
+        batch_unload();
+        if (status == EXIT_SUCCESS && journal_check(journal_file, data_file) != 0)
+        {
+            status = EXIT_FAILURE;
+        }
+    }
+
+    // Compacting releases every record, so the new one is only created afterwards
+    Record *rec = status == EXIT_SUCCESS ? (Record *)record_alloc() : NULL;
+    if (rec == NULL || record_set_note(rec, note, note_len) != 0)
+    {
+        status = EXIT_FAILURE;
+    }
+    else
+    {
+        rec->day = date.day;
+        rec->month = date.month;
+        rec->year = date.year;
+    }
+    free(note);
+
+    if (status == EXIT_SUCCESS &&
+        (journal_open(&journal, journal_file, data_file, &sync_policy) != 0 ||
+         journal_append_tail(&journal, rec, serialize_record) != 0))
+    {
+        status = EXIT_FAILURE;
+    }
+    if (status != EXIT_SUCCESS)
+    {
+        fprintf(stderr, "Failed to add the record.\n");
+    }
+    journal_close(&journal);
+    records_free_all();
+    return status;
+}
+
+static int batch_list(int argc, char **argv)
+{
+    Record from = {0};
+    Record to = {0};
+    const char *from_value = option_value(argc, argv, "--from");
+    const char *to_value = option_value(argc, argv, "--to");
+    if ((from_value != NULL && !parse_date_option(from_value, &from)) ||
+        (to_value != NULL && !parse_date_option(to_value, &to)))
+    {
+        fprintf(stderr, "Usage: %s list [--from D.M.YYYY] [--to D.M.YYYY]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (batch_load() != 0)
+    {
+        return EXIT_FAILURE;
+    }
+
+    Writer out;
+    writer_init_fd(&out, 1);
+    int number = 1;
+    for (Node *node = head; node != NULL; node = node->next, number++)
+    {
+        Record *rec = (Record *)node->data;
+        if ((from_value != NULL && compare_record_date(rec, &from) < 0) ||
+            (to_value != NULL && compare_record_date(rec, &to) > 0))
+        {
+            continue; // Notes outside the range are never decoded
+        }
+
+        const char *note = record_note(rec);
+        const char *line_end = strchr(note, '\n');
+        writer_put_int(&out, number);
+        writer_putc(&out, '\t');
+        writer_put_int(&out, rec->day);
+        writer_putc(&out, '.');
+        writer_put_int(&out, rec->month);
+        writer_putc(&out, '.');
+        writer_put_int(&out, rec->year);
+        writer_putc(&out, '\t');
+        writer_write(&out, note, line_end != NULL ? (size_t)(line_end - note) : strlen(note));
+        writer_putc(&out, '\n');
+    }
+    int status = writer_close(&out) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    batch_unload();
+    return status;
+}
+
+static int batch_show(int argc, char **argv)
+{
+    char *number_end = NULL;
+    long number = argc >= 3 ? strtol(argv[2], &number_end, 10) : 0;
+    if (argc < 3 || *number_end != '\0' || number < 1)
+    {
+        fprintf(stderr, "Usage: %s show N\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    // A binary diary no journal changes has record N at a known place in its index
+    MappedFile map;
+    size_t count = 0;
+    const char *blob = NULL;
+    const BinaryIndexEntry *index = snapshot_index(&map, &count, &blob);
+    if (index != NULL)
+    {
+        const BinaryIndexEntry *entry = (size_t)number <= count ? &index[number - 1] : NULL;
+        size_t blob_len = (size_t)(map.data + map.size - blob);
+        Record rec;
+        memset(&rec, 0, sizeof(rec));
+        int status = EXIT_FAILURE;
+        if (entry == NULL)
+        {
+            fprintf(stderr, "There is no record number %ld.\n", number);
+        }
+        else if (entry->data_offset > blob_len || entry->data_length >= blob_len - entry->data_offset ||
+                 deserialize_record_binary(&rec, entry, blob + entry->data_offset) != 0)
+        {
+            fprintf(stderr, "Failed to load diary entries from file.\n");
+        }
+        else
+        {
+            printf("%d.%d.%d\n\n%s", rec.day, rec.month, rec.year, record_note(&rec));
+            status = EXIT_SUCCESS;
+        }
+        unmap_file(&map);
+        return status;
+    }
+
+    if (batch_load() != 0)
+    {
+        return EXIT_FAILURE;
+    }
+
+    Node *node = head;
+    for (long i = 1; i < number && node != NULL; i++)
+    {
+        node = node->next;
+    }
+
+    int status = EXIT_SUCCESS;
+    if (node == NULL)
+    {
+        fprintf(stderr, "There is no record number %ld.\n", number);
+        status = EXIT_FAILURE;
+    }
+    else
+    {
+        Record *rec = (Record *)node->data;
+        printf("%d.%d.%d\n\n%s", rec->day, rec->month, rec->year, record_note(rec));
+    }
+
+    batch_unload();
+    return status;
+}
+
+static int batch_count()
+{
+    MappedFile map;
+    size_t count = 0;
+    const char *blob = NULL;
+    if (snapshot_index(&map, &count, &blob) != NULL)
+    {
+        printf("%lu\n", (unsigned long)count); // Read from the header, no record is touched
+        unmap_file(&map);
+        return EXIT_SUCCESS;
+    }
+
+    if (batch_load() != 0)
+    {
+        return EXIT_FAILURE;
+    }
+    printf("%d\n", num_records);
+    batch_unload();
+    return EXIT_SUCCESS;
+}
+
+// Maps a binary diary that no journal changes and returns its index, so a batch command can answer
+// without loading the diary. NULL when the diary has to be loaded: it is JSON, has operations in its
+// journal or is not there.
+static const BinaryIndexEntry *snapshot_index(MappedFile *map, size_t *count, const char **blob)
+{
+    if (!journal_empty(journal_file, data_file) || map_file(data_file, map) != 0)
+    {
+        return NULL;
+    }
+    const BinaryIndexEntry *index = storage_detect(map->data, map->size) == DIARY_FORMAT_BINARY
+                                        ? ll_binary_index(map->data, map->size, count, blob)
+                                        : NULL;
+    if (index == NULL)
+    {
+        unmap_file(map);
+    }
+    return index;
+}
+
+static int batch_export()
+{
+    if (batch_load() != 0)
+    {
+        return EXIT_FAILURE;
+    }
+
+    Writer out;
+    writer_init_fd(&out, 1);
+    int written = storage_write(head, &out, DIARY_FORMAT_JSON);
+    int status = writer_close(&out) == 0 && written == 0 ? EXIT_SUCCESS : EXIT_FAILURE; // Closed once, flushed either way
+    if (status != EXIT_SUCCESS)
+    {
+        fprintf(stderr, "Failed to export the diary.\n");
+    }
+
+    batch_unload();
+    return status;
+}
@@ -0,0 +1,114 @@
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+#ifndef _DARWIN_C_SOURCE
+#define _DARWIN_C_SOURCE // sysconf(_SC_NPROCESSORS_ONLN) on macOS
+#endif
+
+#include "parallel.h"
+
+#include <stdlib.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#endif
+
+#if defined(PARALLEL_THREADS)
+#include <unistd.h>
+#endif
+
+#define PARALLEL_MAX_THREADS 64
+
+int parallel_cpu_count(void)
+{
+    const char *threads_env = getenv("DIARY_THREADS");
+    if (threads_env != NULL && atoi(threads_env) > 0)
+    {
+        return atoi(threads_env);
+    }
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
+#elif defined(_SC_NPROCESSORS_ONLN)
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (int)count : 1;
+#else
+    return 1;
+#endif
+}
+
+void parallel_run(void *(*worker)(void *), void *job, int max_threads)
+{
+    int threads = parallel_cpu_count();
+    if (threads > max_threads)
+    {
+        threads = max_threads;
+    }
+    if (threads > PARALLEL_MAX_THREADS)
+    {
+        threads = PARALLEL_MAX_THREADS;
+    }
+
+#if defined(PARALLEL_THREADS)
+    pthread_t workers[PARALLEL_MAX_THREADS];
+    int started = 0;
+    for (int i = 1; i < threads; i++)
+    {
+        if (pthread_create(&workers[started], NULL, worker, job) == 0)
+        {
+            started++;
+        }
+    }
+    worker(job);
+    for (int i = 0; i < started; i++)
+    {
+        pthread_join(workers[i], NULL);
+    }
+#else
+    (void)threads;
+    worker(job);
+#endif
+}
+
+void parallel_queue_init(ParallelQueue *queue, size_t count)
+{
+    queue->next = 0;
+    queue->count = count;
+    queue->failed = 0;
+#if defined(PARALLEL_THREADS)
+    pthread_mutex_init(&queue->lock, NULL);
+#endif
+}
+
+size_t parallel_queue_take(ParallelQueue *queue)
+{
+#if defined(PARALLEL_THREADS)
+    pthread_mutex_lock(&queue->lock);
+#endif
+    size_t item = queue->failed || queue->next >= queue->count ? queue->count : queue->next++;
+#if defined(PARALLEL_THREADS)
+    pthread_mutex_unlock(&queue->lock);
+#endif
+    return item;
+}
+
+void parallel_queue_fail(ParallelQueue *queue)
+{
+#if defined(PARALLEL_THREADS)
+    pthread_mutex_lock(&queue->lock);
+#endif
+    queue->failed = 1;
+#if defined(PARALLEL_THREADS)
+    pthread_mutex_unlock(&queue->lock);
+#endif
+}
+
+void parallel_queue_destroy(ParallelQueue *queue)
+{
+#if defined(PARALLEL_THREADS)
+    pthread_mutex_destroy(&queue->lock);
+#else
+    (void)queue;
+#endif
+}
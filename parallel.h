@@ -0,0 +1,64 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <stddef.h>
+
+#if !defined(_WIN32) || defined(__MINGW32__)
+#include <pthread.h>
+#define PARALLEL_THREADS 1
+#endif
+
+// Hands out work items 0..count-1 one at a time to whichever thread asks next,
+// so a thread that runs into slow items does not hold the others up
+typedef struct ParallelQueue
+{
+    size_t next;
+    size_t count;
+    int failed; // Set by a worker that gave up, the remaining items are not handed out
+#if defined(PARALLEL_THREADS)
+    pthread_mutex_t lock;
+#endif
+} ParallelQueue;
+
+/**
+ * @brief Counts the CPU cores that are online, or takes the count from DIARY_THREADS if it is set.
+ * @return The number of cores, at least 1.
+ */
+int parallel_cpu_count(void);
+
+/**
+ * @brief Runs a worker on up to one thread per core, the calling thread included, and waits for all of them.
+ * A thread that fails to start (or a platform without threads) just leaves more work to the others.
+ * @param worker The function every thread runs. It takes its work from a ParallelQueue inside the job.
+ * @param job The argument every thread gets.
+ * @param max_threads The most threads to use, the calling thread included.
+ */
+void parallel_run(void *(*worker)(void *), void *job, int max_threads);
+
+/**
+ * @brief Initializes a queue of work items.
+ * @param queue The queue to initialize.
+ * @param count The number of work items.
+ */
+void parallel_queue_init(ParallelQueue *queue, size_t count);
+
+/**
+ * @brief Takes the next work item.
+ * @param queue The queue to take from.
+ * @return The item, or the item count once every item is taken or a worker failed.
+ */
+size_t parallel_queue_take(ParallelQueue *queue);
+
+/**
+ * @brief Marks the job as failed, so no more items are handed out.
+ * @param queue The queue of the job.
+ */
+void parallel_queue_fail(ParallelQueue *queue);
+
+/**
+ * @brief Releases a queue once every worker has finished.
+ * @param queue The queue to release.
+ */
+void parallel_queue_destroy(ParallelQueue *queue);
+
+#endif // PARALLEL_H
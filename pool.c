@@ -0,0 +1,158 @@
+#include "pool.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "trace.h"
+
+// Chunk header, padded so the objects after it are suitably aligned
+typedef struct PoolChunk
+{
+    union
+    {
+        struct PoolChunk *next;
+        long double align;
+    } header;
+} PoolChunk;
+
+typedef struct ArenaBlock
+{
+    struct ArenaBlock *next;
+} ArenaBlock;
+
+void pool_init(Pool *pool, size_t object_size, size_t objects_per_chunk)
+{
+    // Every object must be able to hold the freelist link
+    size_t align = sizeof(void *);
+    if (object_size < sizeof(void *))
+    {
+        object_size = sizeof(void *);
+    }
+    pool->object_size = (object_size + align - 1) / align * align;
+    pool->objects_per_chunk = objects_per_chunk > 0 ? objects_per_chunk : 1;
+    pool->chunks = NULL;
+    pool->chunk_used = 0;
+    pool->free_list = NULL;
+}
+
+void *pool_alloc(Pool *pool)
+{
+    void *object = NULL;
+    if (pool->free_list != NULL)
+    {
+        object = pool->free_list;
+        pool->free_list = *(void **)object;
+    }
+    else
+    {
+        if (pool->chunks == NULL || pool->chunk_used == pool->objects_per_chunk)
+        {
+            PoolChunk *chunk = (PoolChunk *)malloc(sizeof(PoolChunk) + pool->object_size * pool->objects_per_chunk);
+            if (chunk == NULL)
+            {
+                return NULL; // Memory allocation failed
+            }
+            chunk->header.next = pool->chunks;
+            pool->chunks = chunk;
+            pool->chunk_used = 0;
+            TRACE_COUNT(TRACE_ALLOCATION_CHUNKS, 1);
+        }
+        object = (char *)(pool->chunks + 1) + pool->object_size * pool->chunk_used++;
+    }
+
+    memset(object, 0, pool->object_size);
+    TRACE_COUNT(TRACE_ALLOCATIONS, 1);
+    return object;
+}
+
+void pool_free(Pool *pool, void *object)
+{
+    if (object == NULL)
+    {
+        return;
+    }
+    *(void **)object = pool->free_list;
+    pool->free_list = object;
+}
+
+void pool_destroy(Pool *pool)
+{
+    PoolChunk *chunk = pool->chunks;
+    while (chunk != NULL)
+    {
+        PoolChunk *next = chunk->header.next;
+        free(chunk);
+        chunk = next;
+    }
+    pool->chunks = NULL;
+    pool->chunk_used = 0;
+    pool->free_list = NULL;
+}
+
+void arena_init(Arena *arena, size_t block_size)
+{
+    arena->block_size = block_size > 0 ? block_size : 4096;
+    arena->blocks = NULL;
+    arena->ptr = NULL;
+    arena->remaining = 0;
+}
+
+char *arena_alloc(Arena *arena, size_t size)
+{
+    TRACE_COUNT(TRACE_ALLOCATIONS, 1);
+    if (size > arena->remaining)
+    {
+        // Oversized strings get a block of their own and leave the current one open
+        int dedicated = size > arena->block_size / 4;
+        size_t payload = dedicated ? size : arena->block_size;
+        ArenaBlock *block = (ArenaBlock *)malloc(sizeof(ArenaBlock) + payload);
+        if (block == NULL)
+        {
+            return NULL; // Memory allocation failed
+        }
+        TRACE_COUNT(TRACE_ALLOCATION_CHUNKS, 1);
+
+        if (dedicated && arena->blocks != NULL)
+        {
+            block->next = arena->blocks->next;
+            arena->blocks->next = block;
+            return (char *)(block + 1);
+        }
+
+        block->next = arena->blocks;
+        arena->blocks = block;
+        arena->ptr = (char *)(block + 1);
+        arena->remaining = payload;
+    }
+
+    char *result = arena->ptr;
+    arena->ptr += size;
+    arena->remaining -= size;
+    return result;
+}
+
+char *arena_strndup(Arena *arena, const char *str, size_t len)
+{
+    char *copy = arena_alloc(arena, len + 1);
+    if (copy == NULL)
+    {
+        return NULL;
+    }
+    memcpy(copy, str, len);
+    copy[len] = '\0';
+    return copy;
+}
+
+void arena_destroy(Arena *arena)
+{
+    ArenaBlock *block = arena->blocks;
+    while (block != NULL)
+    {
+        ArenaBlock *next = block->next;
+        free(block);
+        block = next;
+    }
+    arena->blocks = NULL;
+    arena->ptr = NULL;
+    arena->remaining = 0;
+}
@@ -0,0 +1,84 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <stddef.h>
+
+// A pool of fixed-size objects carved out of large chunks.
+// Freed objects go to a freelist for reuse, pool_destroy releases every chunk at once.
+typedef struct Pool
+{
+    size_t object_size;
+    size_t objects_per_chunk;
+    struct PoolChunk *chunks;
+    size_t chunk_used; // Objects handed out from the newest chunk
+    void *free_list;
+} Pool;
+
+// A bump allocator for strings. Nothing is freed individually, arena_destroy releases everything.
+typedef struct Arena
+{
+    size_t block_size;
+    struct ArenaBlock *blocks;
+    char *ptr;
+    size_t remaining;
+} Arena;
+
+/**
+ * @brief Initializes an empty pool. No memory is allocated until the first object is requested.
+ * @param pool The pool to initialize.
+ * @param object_size The size of every object.
+ * @param objects_per_chunk How many objects each chunk holds.
+ */
+void pool_init(Pool *pool, size_t object_size, size_t objects_per_chunk);
+
+/**
+ * @brief Takes a zero-initialized object from the pool.
+ * @param pool The pool to allocate from.
+ * @return A pointer to the object, or NULL on failure.
+ */
+void *pool_alloc(Pool *pool);
+
+/**
+ * @brief Returns an object to the pool's freelist.
+ * @param pool The pool the object came from.
+ * @param object The object to return, may be NULL.
+ */
+void pool_free(Pool *pool, void *object);
+
+/**
+ * @brief Releases every chunk of the pool, and with them every object. The pool can be reused afterwards.
+ * @param pool The pool to destroy.
+ */
+void pool_destroy(Pool *pool);
+
+/**
+ * @brief Initializes an empty arena.
+ * @param arena The arena to initialize.
+ * @param block_size The size of the blocks strings are carved from. Larger strings get a block of their own.
+ */
+void arena_init(Arena *arena, size_t block_size);
+
+/**
+ * @brief Allocates bytes from the arena. The memory is not aligned, it is meant for strings.
+ * @param arena The arena to allocate from.
+ * @param size The number of bytes.
+ * @return A pointer to the bytes, or NULL on failure.
+ */
+char *arena_alloc(Arena *arena, size_t size);
+
+/**
+ * @brief Copies a string into the arena and null-terminates it.
+ * @param arena The arena to allocate from.
+ * @param str The string to copy.
+ * @param len The number of bytes to copy.
+ * @return The copy, or NULL on failure.
+ */
+char *arena_strndup(Arena *arena, const char *str, size_t len);
+
+/**
+ * @brief Releases every block of the arena. The arena can be reused afterwards.
+ * @param arena The arena to destroy.
+ */
+void arena_destroy(Arena *arena);
+
+#endif // POOL_H
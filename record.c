@@ -0,0 +1,309 @@
+#include "record.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "pool.h"
+#include "trace.h"
+
+#define RECORDS_PER_CHUNK 1024
+#define NOTE_BLOCK_SIZE (256 * 1024)
+
+// Records come from a pool and notes from a bump arena, so a whole diary is released at once.
+// Notes of deleted records stay in the arena until then.
+static Pool record_pool;
+static Arena note_arena;
+
+// Decodes escaped note text into the arena
+static char *decode_note(const char *raw, size_t raw_len)
+{
+    if (note_arena.block_size == 0)
+    {
+        arena_init(&note_arena, NOTE_BLOCK_SIZE);
+    }
+
+    // Decoding never grows the text, so the raw length is enough
+    char *note = arena_alloc(&note_arena, raw_len + 1);
+    if (note == NULL)
+    {
+        return NULL; // Memory allocation failed
+    }
+    note[json_unescape(note, raw, raw_len)] = '\0';
+    return note;
+}
+
+// Length of a note returned by record_note, without scanning notes used in place
+static size_t note_length(const Record *rec, const char *note)
+{
+    return note == rec->raw_note ? rec->raw_note_len : strlen(note);
+}
+
+// Serializer function for the Record struct
+int serialize_record(void *data, Writer *writer)
+{
+    if (data == NULL || writer == NULL)
+    {
+        return -1;
+    }
+    Record *rec = (Record *)data;
+
+    writer_puts(writer, "{\"day\": ");
+    writer_put_int(writer, rec->day);
+    writer_puts(writer, ", \"month\": ");
+    writer_put_int(writer, rec->month);
+    writer_puts(writer, ", \"year\": ");
+    writer_put_int(writer, rec->year);
+    writer_puts(writer, ", \"note\": ");
+    if (rec->note == NULL && rec->raw_note != NULL && rec->raw_note_escaped)
+    {
+        // Never decoded, so it can go back out exactly as it came in
+        writer_putc(writer, '"');
+        writer_write(writer, rec->raw_note, rec->raw_note_len);
+        writer_putc(writer, '"');
+    }
+    else
+    {
+        const char *note = record_note(rec);
+        json_write_string(writer, note, note_length(rec, note));
+    }
+    writer_putc(writer, '}');
+
+    TRACE_COUNT(TRACE_RECORDS_SERIALIZED, 1);
+    return writer->error ? -1 : 0;
+}
+
+static int deserialize_members(Record *rec, JsonCursor *cursor, int lazy)
+{
+    // Members may come in any order, unknown ones are skipped
+    int seen = 0;
+    int more = json_object_begin(cursor);
+    while (more == 1)
+    {
+        const char *key = NULL;
+        size_t key_len = 0;
+        long value = 0;
+        if (json_read_key(cursor, &key, &key_len) != 0)
+        {
+            return -1;
+        }
+
+        if (json_key_equals(key, key_len, "day") && json_read_int(cursor, &value) == 0)
+        {
+            rec->day = (char)value;
+            seen |= 1;
+        }
+        else if (json_key_equals(key, key_len, "month") && json_read_int(cursor, &value) == 0)
+        {
+            rec->month = (char)value;
+            seen |= 2;
+        }
+        else if (json_key_equals(key, key_len, "year") && json_read_int(cursor, &value) == 0)
+        {
+            rec->year = (short)value;
+            seen |= 4;
+        }
+        else if (json_key_equals(key, key_len, "note") && lazy)
+        {
+            if (json_scan_string(cursor, &rec->raw_note, &rec->raw_note_len) != 0)
+            {
+                return -1;
+            }
+            rec->raw_note_escaped = 1;
+        }
+        else if (json_key_equals(key, key_len, "note"))
+        {
+            const char *raw = NULL;
+            size_t raw_len = 0;
+            if (json_scan_string(cursor, &raw, &raw_len) != 0)
+            {
+                return -1;
+            }
+            rec->note = decode_note(raw, raw_len);
+            if (rec->note == NULL)
+            {
+                return -1;
+            }
+        }
+        else if (json_skip_value(cursor) != 0)
+        {
+            return -1;
+        }
+
+        more = json_object_next(cursor);
+    }
+
+    if (more != 0 || seen != 7)
+    {
+        return -1;
+    }
+    TRACE_COUNT(TRACE_RECORDS_PARSED, 1);
+    return 0;
+}
+
+int deserialize_record(void *data, JsonCursor *cursor)
+{
+    if (data == NULL || cursor == NULL)
+    {
+        return -1;
+    }
+    return deserialize_members((Record *)data, cursor, 0);
+}
+
+int deserialize_record_lazy(void *data, JsonCursor *cursor)
+{
+    if (data == NULL || cursor == NULL)
+    {
+        return -1;
+    }
+    return deserialize_members((Record *)data, cursor, 1);
+}
+
+int serialize_record_binary(void *data, BinaryIndexEntry *entry, const char **blob, size_t *blob_len)
+{
+    if (data == NULL || entry == NULL || blob == NULL || blob_len == NULL)
+    {
+        return -1;
+    }
+    Record *rec = (Record *)data;
+
+    entry->date = ((uint32_t)(unsigned short)rec->year << 9) | ((uint32_t)(rec->month & 0xF) << 5) |
+                  (uint32_t)(rec->day & 0x1F);
+    entry->flags = 0;
+    *blob = record_note(rec);
+    *blob_len = note_length(rec, *blob);
+    TRACE_COUNT(TRACE_RECORDS_SERIALIZED, 1);
+    return 0;
+}
+
+int deserialize_record_binary(void *data, const BinaryIndexEntry *entry, const char *blob)
+{
+    if (data == NULL || entry == NULL || blob == NULL)
+    {
+        return -1;
+    }
+    Record *rec = (Record *)data;
+
+    rec->day = (char)(entry->date & 0x1F);
+    rec->month = (char)((entry->date >> 5) & 0xF);
+    rec->year = (short)(entry->date >> 9);
+    rec->raw_note = blob;
+    rec->raw_note_len = (size_t)entry->data_length;
+    rec->raw_note_escaped = 0;
+    TRACE_COUNT(TRACE_RECORDS_PARSED, 1);
+    return 0;
+}
+
+const char *record_note(Record *rec)
+{
+    if (rec == NULL)
+    {
+        return "";
+    }
+
+    if (rec->note == NULL && rec->raw_note != NULL && !rec->raw_note_escaped)
+    {
+        // Binary notes are stored decoded and null-terminated, so they are used in place
+        return rec->raw_note[rec->raw_note_len] == '\0' ? rec->raw_note : "";
+    }
+
+    if (rec->note == NULL && rec->raw_note != NULL)
+    {
+        rec->note = decode_note(rec->raw_note, rec->raw_note_len); // NULL means try again next time
+    }
+    return rec->note ? rec->note : "";
+}
+
+const char *record_note_view(const void *data, char **scratch, size_t *scratch_capacity, size_t *len)
+{
+    const Record *rec = (const Record *)data;
+    *len = 0;
+    if (rec == NULL)
+    {
+        return "";
+    }
+
+    if (rec->note != NULL)
+    {
+        *len = strlen(rec->note);
+        return rec->note;
+    }
+    if (rec->raw_note != NULL && !rec->raw_note_escaped)
+    {
+        if (rec->raw_note[rec->raw_note_len] != '\0')
+        {
+            return "";
+        }
+        *len = rec->raw_note_len;
+        return rec->raw_note;
+    }
+    if (rec->raw_note == NULL)
+    {
+        return "";
+    }
+
+    if (*scratch_capacity < rec->raw_note_len + 1)
+    {
+        char *grown = (char *)realloc(*scratch, rec->raw_note_len + 1);
+        if (grown == NULL)
+        {
+            return ""; // Memory allocation failed
+        }
+        *scratch = grown;
+        *scratch_capacity = rec->raw_note_len + 1;
+    }
+    *len = json_unescape(*scratch, rec->raw_note, rec->raw_note_len);
+    (*scratch)[*len] = '\0';
+    return *scratch;
+}
+
+int compare_record_date(const void *a, const void *b)
+{
+    const Record *first = (const Record *)a;
+    const Record *second = (const Record *)b;
+    long first_date = ((long)first->year << 9) | (first->month << 5) | first->day;
+    long second_date = ((long)second->year << 9) | (second->month << 5) | second->day;
+    return (first_date > second_date) - (first_date < second_date);
+}
+
+void *record_alloc(void)
+{
+    if (record_pool.object_size == 0)
+    {
+        pool_init(&record_pool, sizeof(Record), RECORDS_PER_CHUNK);
+    }
+    return pool_alloc(&record_pool);
+}
+
+int record_set_note(Record *rec, const char *note, size_t len)
+{
+    if (rec == NULL || note == NULL)
+    {
+        return -1;
+    }
+    if (note_arena.block_size == 0)
+    {
+        arena_init(&note_arena, NOTE_BLOCK_SIZE);
+    }
+
+    char *copy = arena_strndup(&note_arena, note, len);
+    if (copy == NULL)
+    {
+        return -1; // Memory allocation failed
+    }
+    rec->note = copy;
+    rec->raw_note = NULL;
+    rec->raw_note_len = 0;
+    rec->raw_note_escaped = 0;
+    return 0;
+}
+
+void free_record(Record *rec)
+{
+    pool_free(&record_pool, rec); // The note stays in the arena until records_free_all
+}
+
+void records_free_all(void)
+{
+    pool_destroy(&record_pool);
+    arena_destroy(&note_arena);
+}
@@ -0,0 +1,119 @@
+#ifndef RECORD_H
+#define RECORD_H
+
+#include <stddef.h>
+
+#include "json.h"
+#include "linked_list.h"
+#include "writer.h"
+
+// A single diary entry
+typedef struct Record
+{
+    char day;
+    char month;
+    short year;
+    char *note;           // Decoded note, NULL until it is materialized
+    const char *raw_note; // Note inside the loaded diary file, NULL if none
+    size_t raw_note_len;
+    char raw_note_escaped; // 1 if raw_note still holds JSON escapes
+} Record;
+
+/**
+ * @brief Serializer function for the Record struct.
+ * Notes that were never decoded are copied through still escaped.
+ * @param data A pointer to the Record.
+ * @param writer The writer to emit the JSON object into.
+ * @return 0 on success, -1 on failure.
+ */
+int serialize_record(void *data, Writer *writer);
+
+/**
+ * @brief Deserializer function for the Record struct, decodes the note right away.
+ * @param data A pointer to the zero-initialized Record.
+ * @param cursor The cursor positioned at the JSON object.
+ * @return 0 on success, -1 on failure.
+ */
+int deserialize_record(void *data, JsonCursor *cursor);
+
+/**
+ * @brief Deserializer function that only remembers where the note is in the buffer.
+ * The buffer must stay alive (e.g. mapped) for as long as the Record does.
+ * @param data A pointer to the zero-initialized Record.
+ * @param cursor The cursor positioned at the JSON object.
+ * @return 0 on success, -1 on failure.
+ */
+int deserialize_record_lazy(void *data, JsonCursor *cursor);
+
+/**
+ * @brief Binary serializer function for the Record struct.
+ * @param data A pointer to the Record.
+ * @param entry The index entry to fill in.
+ * @param blob Receives the note bytes.
+ * @param blob_len Receives the note length.
+ * @return 0 on success, -1 on failure.
+ */
+int serialize_record_binary(void *data, BinaryIndexEntry *entry, const char **blob, size_t *blob_len);
+
+/**
+ * @brief Binary deserializer function for the Record struct. The note is used in place.
+ * @param data A pointer to the zero-initialized Record.
+ * @param entry The index entry.
+ * @param blob The note bytes inside the loaded file.
+ * @return 0 on success, -1 on failure.
+ */
+int deserialize_record_binary(void *data, const BinaryIndexEntry *entry, const char *blob);
+
+/**
+ * @brief Returns the note of a record, decoding it on first use.
+ * @param rec The record.
+ * @return The note, or an empty string if it has none or decoding failed.
+ */
+const char *record_note(Record *rec);
+
+/**
+ * @brief Returns the note of a record without touching the record or the note arena,
+ * so several threads may call it at once. Escaped notes are decoded into a caller-owned buffer.
+ * @param data A pointer to the Record.
+ * @param scratch A buffer the note may be decoded into, grown with realloc as needed (the caller must free it).
+ * @param scratch_capacity The size of the scratch buffer.
+ * @param len Receives the note length.
+ * @return The note, or an empty string if it has none or decoding failed.
+ */
+const char *record_note_view(const void *data, char **scratch, size_t *scratch_capacity, size_t *len);
+
+/**
+ * @brief Orders two records by date, for the date index.
+ * @param a A pointer to the first Record.
+ * @param b A pointer to the second Record.
+ * @return A negative number, zero or a positive number as a is earlier than, on the same day as or later than b.
+ */
+int compare_record_date(const void *a, const void *b);
+
+/**
+ * @brief Allocates a zero-initialized record from the record pool.
+ * @return The record, or NULL on failure.
+ */
+void *record_alloc(void);
+
+/**
+ * @brief Copies a note into the note arena and makes it the record's note.
+ * @param rec The record.
+ * @param note The note text.
+ * @param len The length of the note text.
+ * @return 0 on success, -1 on failure.
+ */
+int record_set_note(Record *rec, const char *note, size_t len);
+
+/**
+ * @brief Returns a record to the record pool. Its note is only released by records_free_all.
+ * @param rec The record to free.
+ */
+void free_record(Record *rec);
+
+/**
+ * @brief Releases every record and note in bulk.
+ */
+void records_free_all(void);
+
+#endif // RECORD_H
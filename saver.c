@@ -0,0 +1,198 @@
+#include "saver.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if !defined(_WIN32) || defined(__MINGW32__)
+#include <pthread.h>
+#define SAVER_THREADS 1
+#endif
+
+// The job handed from the UI thread to the worker and its result
+typedef struct SaverState
+{
+    Node *snapshot;
+    const char *path;
+    DiaryFormat format;
+    int sync;
+    int pending; // A snapshot waits for the worker
+    int done;    // The worker wrote it, the result is ready
+    int result;
+    size_t written;
+    int stop;
+    int threaded; // 0 if the worker could not be started
+#if defined(SAVER_THREADS)
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;     // Work arrived or the worker should stop
+    pthread_cond_t finished; // A result is ready
+#endif
+} SaverState;
+
+static void write_snapshot(SaverState *state)
+{
+    size_t written = 0;
+    int result = storage_write_file(state->snapshot, state->path, state->format, state->sync, &written);
+    free(state->snapshot); // ll_snapshot makes the copy in one block
+    state->snapshot = NULL;
+    state->result = result;
+    state->written = written;
+}
+
+#if defined(SAVER_THREADS)
+static void *saver_worker(void *arg)
+{
+    SaverState *state = (SaverState *)arg;
+    pthread_mutex_lock(&state->lock);
+    while (1)
+    {
+        while (!state->pending && !state->stop)
+        {
+            pthread_cond_wait(&state->wake, &state->lock);
+        }
+        if (state->pending)
+        {
+            // The UI thread does not touch the job until done is set, so it is written unlocked
+            pthread_mutex_unlock(&state->lock);
+            write_snapshot(state);
+            pthread_mutex_lock(&state->lock);
+            state->pending = 0;
+            state->done = 1;
+            pthread_cond_signal(&state->finished);
+            continue;
+        }
+        break; // Stopped with nothing left to write
+    }
+    pthread_mutex_unlock(&state->lock);
+    return NULL;
+}
+#endif
+
+int saver_start(Saver *saver)
+{
+    if (saver == NULL)
+    {
+        return -1; // Invalid input
+    }
+    saver->busy = 0;
+    saver->state = (SaverState *)calloc(1, sizeof(SaverState));
+    if (saver->state == NULL)
+    {
+        return -1; // Memory allocation failed
+    }
+
+#if defined(SAVER_THREADS)
+    SaverState *state = saver->state;
+    pthread_mutex_init(&state->lock, NULL);
+    pthread_cond_init(&state->wake, NULL);
+    pthread_cond_init(&state->finished, NULL);
+    state->threaded = pthread_create(&state->thread, NULL, saver_worker, state) == 0;
+    if (!state->threaded)
+    {
+        return -1; // Snapshots are written on the calling thread instead
+    }
+#endif
+    return 0;
+}
+
+int saver_submit(Saver *saver, Node *snapshot, const char *path, DiaryFormat format, int sync)
+{
+    if (saver == NULL || saver->state == NULL || saver->busy || path == NULL)
+    {
+        return -1; // Invalid input, or the last snapshot was not collected yet
+    }
+    SaverState *state = saver->state;
+    saver->busy = 1;
+
+    if (!state->threaded)
+    {
+        state->snapshot = snapshot;
+        state->path = path;
+        state->format = format;
+        state->sync = sync;
+        write_snapshot(state);
+        state->done = 1;
+        return 0;
+    }
+
+#if defined(SAVER_THREADS)
+    pthread_mutex_lock(&state->lock);
+    state->snapshot = snapshot;
+    state->path = path;
+    state->format = format;
+    state->sync = sync;
+    state->pending = 1;
+    state->done = 0;
+    pthread_cond_signal(&state->wake);
+    pthread_mutex_unlock(&state->lock);
+#endif
+    return 0;
+}
+
+int saver_collect(Saver *saver, int wait, int *result, size_t *written)
+{
+    if (saver == NULL || saver->state == NULL || !saver->busy)
+    {
+        return 0; // Nothing was handed over
+    }
+    SaverState *state = saver->state;
+
+#if defined(SAVER_THREADS)
+    if (state->threaded)
+    {
+        pthread_mutex_lock(&state->lock);
+        while (wait && !state->done)
+        {
+            pthread_cond_wait(&state->finished, &state->lock);
+        }
+        int done = state->done;
+        pthread_mutex_unlock(&state->lock);
+        if (!done)
+        {
+            return 0;
+        }
+    }
+#else
+    (void)wait;
+#endif
+
+    state->done = 0;
+    saver->busy = 0;
+    if (result != NULL)
+    {
+        *result = state->result;
+    }
+    if (written != NULL)
+    {
+        *written = state->written;
+    }
+    return 1;
+}
+
+void saver_stop(Saver *saver)
+{
+    if (saver == NULL || saver->state == NULL)
+    {
+        return;
+    }
+    SaverState *state = saver->state;
+
+#if defined(SAVER_THREADS)
+    if (state->threaded)
+    {
+        pthread_mutex_lock(&state->lock);
+        state->stop = 1;
+        pthread_cond_signal(&state->wake);
+        pthread_mutex_unlock(&state->lock);
+        pthread_join(state->thread, NULL); // Finishes the snapshot it is writing first
+    }
+    pthread_mutex_destroy(&state->lock);
+    pthread_cond_destroy(&state->wake);
+    pthread_cond_destroy(&state->finished);
+#endif
+
+    free(state->snapshot);
+    free(state);
+    saver->state = NULL;
+    saver->busy = 0;
+}
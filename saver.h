@@ -0,0 +1,52 @@
+#ifndef SAVER_H
+#define SAVER_H
+
+#include <stddef.h>
+
+#include "linked_list.h"
+#include "storage.h"
+
+// Writes snapshots of the diary to a file on a background thread, one at a time.
+// Where threads are not available, snapshots are written on the calling thread.
+typedef struct Saver
+{
+    struct SaverState *state; // Shared with the worker thread, NULL until started
+    int busy;                 // A snapshot was handed over and not collected yet
+} Saver;
+
+/**
+ * @brief Starts the worker thread. If it cannot be started, snapshots are written by saver_submit itself.
+ * @param saver The saver to start.
+ * @return 0 on success, -1 on failure.
+ */
+int saver_start(Saver *saver);
+
+/**
+ * @brief Hands a snapshot over to be written. Returns at once, the result is picked up with saver_collect.
+ * @param saver The saver to use.
+ * @param snapshot A copy of the list made by ll_snapshot. The saver frees it once it is written.
+ * @param path The file to write, usually a temporary file renamed over the diary afterwards.
+ * @param format The format to write.
+ * @param sync 1 to force the file to disk before it is reported as written.
+ * @return 0 on success, -1 if a snapshot is still being written or on invalid input (the snapshot is not taken over).
+ */
+int saver_submit(Saver *saver, Node *snapshot, const char *path, DiaryFormat format, int sync);
+
+/**
+ * @brief Picks up the result of the snapshot that was handed over.
+ * @param saver The saver to use.
+ * @param wait 1 to wait until the snapshot is written, 0 to return at once.
+ * @param result Receives 0 if the file was written, -1 if writing failed.
+ * @param written Receives the number of bytes written.
+ * @return 1 if a result was picked up, 0 if no snapshot is being written or it is not finished yet.
+ */
+int saver_collect(Saver *saver, int wait, int *result, size_t *written);
+
+/**
+ * @brief Waits for the snapshot being written, if any, and stops the worker thread.
+ * A result that was not collected is dropped.
+ * @param saver The saver to stop.
+ */
+void saver_stop(Saver *saver);
+
+#endif // SAVER_H
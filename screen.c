@@ -0,0 +1,411 @@
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+#ifndef _DARWIN_C_SOURCE
+#define _DARWIN_C_SOURCE // TIOCGWINSZ on macOS
+#endif
+
+#include "screen.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#include <io.h>
+#include <windows.h>
+#define write _write
+#define isatty _isatty
+#else
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+
+#include "trace.h"
+
+// What a terminal that does not tell its size is taken to be
+#define SCREEN_DEFAULT_ROWS 24
+#define SCREEN_DEFAULT_COLS 80
+
+// Makes room for len more bytes and a terminating null
+static int buffer_reserve(ScreenBuffer *buffer, size_t len)
+{
+    if (buffer->len + len + 1 <= buffer->capacity)
+    {
+        return 0;
+    }
+    // Grows geometrically, after the first few frames it is never reallocated
+    size_t capacity = buffer->capacity ? buffer->capacity : 4096;
+    while (capacity < buffer->len + len + 1)
+    {
+        capacity *= 2;
+    }
+    char *grown = (char *)realloc(buffer->data, capacity);
+    if (grown == NULL)
+    {
+        return -1; // Memory allocation failed
+    }
+    buffer->data = grown;
+    buffer->capacity = capacity;
+    return 0;
+}
+
+static int buffer_append(ScreenBuffer *buffer, const char *data, size_t len)
+{
+    if (buffer_reserve(buffer, len) != 0)
+    {
+        return -1;
+    }
+    memcpy(buffer->data + buffer->len, data, len);
+    buffer->len += len;
+    buffer->data[buffer->len] = '\0';
+    return 0;
+}
+
+static void terminal_size(Screen *screen, int *rows, int *cols)
+{
+    *rows = SCREEN_DEFAULT_ROWS;
+    *cols = SCREEN_DEFAULT_COLS;
+#if defined(_WIN32)
+    (void)screen;
+    CONSOLE_SCREEN_BUFFER_INFO info;
+    if (GetConsoleScreenBufferInfo(GetStdHandle(STD_OUTPUT_HANDLE), &info))
+    {
+        *rows = info.srWindow.Bottom - info.srWindow.Top + 1;
+        *cols = info.srWindow.Right - info.srWindow.Left + 1;
+    }
+#else
+    struct winsize size;
+    if (ioctl(screen->fd, TIOCGWINSZ, &size) == 0 && size.ws_row > 0 && size.ws_col > 0)
+    {
+        *rows = size.ws_row;
+        *cols = size.ws_col;
+    }
+#endif
+}
+
+void screen_size(Screen *screen, int *rows, int *cols)
+{
+    terminal_size(screen, rows, cols);
+}
+
+// The columns a line takes, UTF-8 sequences count as one and tabs run to the next multiple of 8
+static size_t line_width(const char *text, size_t len)
+{
+    size_t width = 0;
+    for (size_t i = 0; i < len; i++)
+    {
+        unsigned char c = (unsigned char)text[i];
+        if (c == '\t')
+        {
+            width = (width / 8 + 1) * 8;
+        }
+        else if (c >= 0x20 && (c & 0xC0) != 0x80)
+        {
+            width++;
+        }
+    }
+    return width;
+}
+
+size_t screen_fit(const char *text, size_t len, size_t column, size_t cols)
+{
+    size_t width = column;
+    for (size_t i = 0; i < len; i++)
+    {
+        unsigned char c = (unsigned char)text[i];
+        if ((c & 0xC0) == 0x80)
+        {
+            continue; // The rest of a character that already fit
+        }
+        size_t next = c == '\t' ? (width / 8 + 1) * 8 : c >= 0x20 ? width + 1 : width;
+        if (next > cols)
+        {
+            return i;
+        }
+        width = next;
+    }
+    return len;
+}
+
+// Splits the frame into lines and lays them out on the terminal, returns the rows it takes
+static int layout(Screen *screen)
+{
+    screen->num_lines = 0;
+    int row = 1;
+    size_t start = 0;
+    while (1)
+    {
+        const char *end = (const char *)memchr(screen->frame.data + start, '\n', screen->frame.len - start);
+        size_t len = end != NULL ? (size_t)(end - (screen->frame.data + start)) : screen->frame.len - start;
+        if (screen->num_lines == screen->lines_capacity)
+        {
+            size_t capacity = screen->lines_capacity ? screen->lines_capacity * 2 : 64;
+            ScreenLine *grown = (ScreenLine *)realloc(screen->lines, capacity * sizeof(ScreenLine));
+            if (grown == NULL)
+            {
+                return -1; // Memory allocation failed
+            }
+            screen->lines = grown;
+            screen->lines_capacity = capacity;
+        }
+        ScreenLine *line = &screen->lines[screen->num_lines++];
+        line->start = start;
+        line->len = len;
+        line->row = row;
+
+        size_t width = line_width(screen->frame.data + start, len);
+        row += width == 0 ? 1 : (int)((width + screen->cols - 1) / screen->cols);
+        if (end == NULL)
+        {
+            return row - 1;
+        }
+        start += len + 1;
+    }
+}
+
+// Drops the lines of a frame taller than the terminal that would scroll off its top, so that the rest
+// takes at most rows rows and starts on the first. Returns how many lines were dropped, shift receives
+// how many rows they took.
+static size_t clip(Screen *screen, int rows, int *frame_rows, int *shift)
+{
+    size_t first = 0;
+    while (first + 1 < screen->num_lines && *frame_rows - screen->lines[first].row + 1 > rows)
+    {
+        first++;
+    }
+    *shift = screen->lines[first].row - 1;
+    screen->num_lines -= first;
+    memmove(screen->lines, screen->lines + first, screen->num_lines * sizeof(ScreenLine));
+    for (size_t i = 0; i < screen->num_lines; i++)
+    {
+        screen->lines[i].row -= *shift;
+    }
+    *frame_rows -= *shift;
+    return first;
+}
+
+// Compares a line with the one the terminal shows for the same line of the whole frame
+static int unchanged(const Screen *screen, size_t i, size_t dropped)
+{
+    if (i + dropped < screen->shown_dropped || i + dropped - screen->shown_dropped >= screen->num_shown_lines)
+    {
+        return 0;
+    }
+    const ScreenLine *line = &screen->lines[i];
+    const ScreenLine *shown = &screen->shown_lines[i + dropped - screen->shown_dropped];
+    return line->row == shown->row && line->len == shown->len &&
+           memcmp(screen->frame.data + line->start, screen->shown.data + shown->start, line->len) == 0;
+}
+
+// Moves to the line's row and sends it, between before and after
+static int put_line(Screen *screen, const ScreenLine *line, const char *before, const char *after)
+{
+    char move[32];
+    snprintf(move, sizeof(move), "\033[%d;1H%s", line->row, before);
+    if (buffer_append(&screen->out, move, strlen(move)) != 0 ||
+        buffer_append(&screen->out, screen->frame.data + line->start, line->len) != 0)
+    {
+        return -1;
+    }
+    return buffer_append(&screen->out, after, strlen(after));
+}
+
+static int write_all(int fd, const char *data, size_t len)
+{
+    while (len > 0)
+    {
+        int written = (int)write(fd, data, (unsigned int)len);
+        if (written <= 0)
+        {
+            return -1;
+        }
+        data += written;
+        len -= (size_t)written;
+    }
+    return 0;
+}
+
+void screen_init(Screen *screen, int fd)
+{
+    memset(screen, 0, sizeof(Screen));
+    screen->fd = fd;
+    screen->terminal = isatty(fd);
+}
+
+void screen_begin(Screen *screen)
+{
+    screen->frame.len = 0;
+    screen->error = 0;
+    screen->cursor_set = 0;
+}
+
+void screen_cursor(Screen *screen, size_t line, size_t column)
+{
+    screen->cursor_set = 1;
+    screen->cursor_line = line;
+    screen->cursor_column = column;
+}
+
+void screen_puts(Screen *screen, const char *str)
+{
+    if (str != NULL && buffer_append(&screen->frame, str, strlen(str)) != 0)
+    {
+        screen->error = 1;
+    }
+}
+
+void screen_printf(Screen *screen, const char *format, ...)
+{
+    char text[512];
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+    if (len < 0)
+    {
+        screen->error = 1;
+        return;
+    }
+    if ((size_t)len < sizeof(text))
+    {
+        if (buffer_append(&screen->frame, text, (size_t)len) != 0)
+        {
+            screen->error = 1;
+        }
+        return;
+    }
+
+    // Too long for the stack, formatted straight into the frame
+    if (buffer_reserve(&screen->frame, (size_t)len) != 0)
+    {
+        screen->error = 1;
+        return;
+    }
+    va_start(args, format);
+    vsnprintf(screen->frame.data + screen->frame.len, (size_t)len + 1, format, args);
+    va_end(args);
+    screen->frame.len += (size_t)len;
+}
+
+int screen_flush(Screen *screen)
+{
+    screen->out.len = 0;
+    int rows = 0;
+    int cols = 0;
+    terminal_size(screen, &rows, &cols);
+    int resized = rows != screen->rows || cols != screen->cols;
+    screen->rows = rows;
+    screen->cols = cols;
+    int frame_rows = layout(screen);
+    if (screen->error || frame_rows < 0)
+    {
+        screen->shown_valid = 0;
+        return -1;
+    }
+
+    // Typing after the prompt and pressing Enter takes a row more, a frame that leaves none would scroll.
+    // Only its bottom could be seen then, so only that is kept, compared and sent.
+    size_t dropped = 0;
+    int shift = 0;
+    if (screen->terminal && frame_rows >= rows)
+    {
+        dropped = clip(screen, rows - 1, &frame_rows, &shift);
+    }
+    int whole = !screen->terminal || !screen->shown_valid || resized || frame_rows >= rows;
+    int status = 0;
+    if (whole)
+    {
+        size_t start = screen->lines[0].start;
+        status = buffer_append(&screen->out, "\033[1;1H\033[2J", 10) != 0 ||
+                         buffer_append(&screen->out, screen->frame.data + start, screen->frame.len - start) != 0
+                     ? -1
+                     : 0;
+    }
+    else
+    {
+        // A note of another length moves the lines above it by as many rows, scrolling moves them on the
+        // terminal too, so they need not be sent again
+        int scroll = shift - screen->shown_shift;
+        if (scroll != 0 && scroll > -rows && scroll < rows)
+        {
+            char move[32];
+            snprintf(move, sizeof(move), "\033[%d%c", scroll > 0 ? scroll : -scroll, scroll > 0 ? 'S' : 'T');
+            status = buffer_append(&screen->out, move, strlen(move));
+            for (size_t i = 0; i < screen->num_shown_lines; i++)
+            {
+                screen->shown_lines[i].row -= scroll;
+            }
+        }
+
+        size_t last = screen->num_lines - 1;
+        for (size_t i = 0; i < last && status == 0; i++)
+        {
+            if (!unchanged(screen, i, dropped))
+            {
+                // Clears what is left of its last row, unless it fills that row and the cursor is still on its last character
+                size_t width = line_width(screen->frame.data + screen->lines[i].start, screen->lines[i].len);
+                status = put_line(screen, &screen->lines[i], "", width > 0 && width % (size_t)cols == 0 ? "" : "\033[K");
+            }
+        }
+        if (status == 0)
+        {
+            status = put_line(screen, &screen->lines[last], "\033[J", ""); // Also clears what the last frame had below it
+        }
+    }
+    if (status == 0 && screen->terminal && screen->cursor_set && screen->cursor_line >= dropped &&
+        screen->cursor_line - dropped < screen->num_lines && frame_rows < rows)
+    {
+        char move[32];
+        const ScreenLine *line = &screen->lines[screen->cursor_line - dropped];
+        snprintf(move, sizeof(move), "\033[%d;%dH", line->row + (int)(screen->cursor_column / (size_t)cols),
+                 (int)(screen->cursor_column % (size_t)cols) + 1);
+        status = buffer_append(&screen->out, move, strlen(move));
+    }
+
+    fflush(stdout); // Anything printed before goes out first
+    if (status == 0)
+    {
+        TRACE_COUNT(TRACE_SCREEN_BYTES, screen->out.len);
+        status = write_all(screen->fd, screen->out.data, screen->out.len);
+    }
+    if (status != 0)
+    {
+        screen->shown_valid = 0;
+        return -1;
+    }
+
+    // The frame is what the terminal shows now, its buffers take the next frame
+    ScreenBuffer buffer = screen->shown;
+    screen->shown = screen->frame;
+    screen->frame = buffer;
+    ScreenLine *lines = screen->shown_lines;
+    size_t capacity = screen->shown_lines_capacity;
+    screen->shown_lines = screen->lines;
+    screen->shown_lines_capacity = screen->lines_capacity;
+    screen->num_shown_lines = screen->num_lines;
+    screen->lines = lines;
+    screen->lines_capacity = capacity;
+    screen->num_lines = 0;
+    screen->shown_shift = shift;
+    screen->shown_dropped = dropped;
+    screen->shown_valid = frame_rows < rows; // A line taller than the terminal scrolled, its rows are not where the layout put them
+    return 0;
+}
+
+void screen_invalidate(Screen *screen)
+{
+    screen->shown_valid = 0;
+}
+
+void screen_destroy(Screen *screen)
+{
+    free(screen->frame.data);
+    free(screen->shown.data);
+    free(screen->out.data);
+    free(screen->lines);
+    free(screen->shown_lines);
+    memset(screen, 0, sizeof(Screen));
+    screen->fd = -1;
+}
@@ -0,0 +1,123 @@
+#ifndef SCREEN_H
+#define SCREEN_H
+
+#include <stddef.h>
+
+// A growable byte buffer that keeps its memory between frames
+typedef struct ScreenBuffer
+{
+    char *data;
+    size_t len;
+    size_t capacity;
+} ScreenBuffer;
+
+// Where a line of a frame starts in the frame and on the terminal
+typedef struct ScreenLine
+{
+    size_t start;
+    size_t len;
+    int row; // 1-based, long lines take several rows
+} ScreenLine;
+
+// The main screen. Every frame is built in one buffer, compared line by line with the
+// frame the terminal shows and only the lines that changed are sent, in one write.
+typedef struct Screen
+{
+    int fd;
+    int terminal; // 0 when the output is not a terminal, every frame is then sent whole
+    ScreenBuffer frame;
+    ScreenBuffer shown; // The frame the terminal shows
+    ScreenBuffer out;   // Cursor moves and changed lines
+    ScreenLine *lines;  // Of frame while it is flushed, then of shown
+    ScreenLine *shown_lines;
+    size_t num_lines;
+    size_t num_shown_lines;
+    size_t lines_capacity;
+    size_t shown_lines_capacity;
+    int shown_valid; // 0 when something else was printed since, the next frame is sent whole
+    size_t shown_dropped; // Lines of the shown frame left out above the top of the terminal
+    int shown_shift;      // And the rows they take
+    int rows;
+    int cols;
+    int error;
+    int cursor_set; // The cursor is left at cursor_line and cursor_column rather than at the end of the frame
+    size_t cursor_line;
+    size_t cursor_column;
+} Screen;
+
+/**
+ * @brief Initializes a screen that draws to a file descriptor.
+ * @param screen The screen to initialize.
+ * @param fd The file descriptor of the terminal, usually 1.
+ */
+void screen_init(Screen *screen, int fd);
+
+/**
+ * @brief Starts a new frame.
+ * @param screen The screen.
+ */
+void screen_begin(Screen *screen);
+
+/**
+ * @brief Adds text to the frame.
+ * @param screen The screen.
+ * @param str The text. Lines end with '\n', the last line of the frame is where the cursor is left.
+ */
+void screen_puts(Screen *screen, const char *str);
+
+/**
+ * @brief Adds formatted text to the frame.
+ * @param screen The screen.
+ * @param format The printf format.
+ */
+void screen_printf(Screen *screen, const char *format, ...);
+
+/**
+ * @brief Leaves the cursor somewhere in the frame after it is sent, instead of at its end.
+ * @param screen The screen.
+ * @param line The line of the frame, 0 for the first.
+ * @param column The column in the line, 0 for the first. Columns past the width of the terminal are on the rows the line wraps to.
+ */
+void screen_cursor(Screen *screen, size_t line, size_t column);
+
+/**
+ * @brief Sends the frame. Lines that did not change and did not move are skipped, the last line
+ * (the prompt) is always sent, so whatever was typed after the previous one is cleared.
+ * Of a frame taller than the terminal only the lines that fit at its bottom are kept and compared.
+ * A resized terminal or an invalidated screen gets the frame whole.
+ * @param screen The screen.
+ * @return 0 on success, -1 on failure.
+ */
+int screen_flush(Screen *screen);
+
+/**
+ * @brief Measures the terminal, 24 by 80 when it cannot be asked.
+ * @param screen The screen.
+ * @param rows Receives the number of rows.
+ * @param cols Receives the number of columns.
+ */
+void screen_size(Screen *screen, int *rows, int *cols);
+
+/**
+ * @brief Counts how much of a text fits on one row, cut between characters.
+ * @param text The text, a single line.
+ * @param len The length of the text in bytes.
+ * @param column The column the text starts at, tabs are aligned to it.
+ * @param cols The column the text must end before.
+ * @return The number of bytes that fit.
+ */
+size_t screen_fit(const char *text, size_t len, size_t column, size_t cols);
+
+/**
+ * @brief Forgets what the terminal shows, for when something else was printed over the frame.
+ * @param screen The screen.
+ */
+void screen_invalidate(Screen *screen);
+
+/**
+ * @brief Releases the buffers of a screen.
+ * @param screen The screen to destroy.
+ */
+void screen_destroy(Screen *screen);
+
+#endif // SCREEN_H
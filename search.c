@@ -0,0 +1,550 @@
+#include "search.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "file.h"
+#include "writer.h"
+
+// Index file: a text header line stamped with the snapshot it belongs to, then one
+// record per term in native byte order: u32 length, term bytes, u32 count, u32 ids[count]
+#define SEARCH_MAGIC "DIARYIDX 1"
+
+#define MAX_TERM_LENGTH 64 // Longer words are indexed by their first bytes
+#define MAX_QUERY_TERMS 16
+#define INITIAL_CAPACITY 1024
+#define TERM_BLOCK_SIZE (64 * 1024)
+
+// A term and its posting list. Each node appears at most once.
+typedef struct SearchTerm
+{
+    const char *text; // NULL for an empty slot
+    uint32_t length;
+    uint32_t hash;
+    Node **nodes;
+    size_t count;
+    size_t capacity;
+} SearchTerm;
+
+static uint32_t hash_term(const char *term, size_t len)
+{
+    uint32_t hash = 2166136261u; // FNV-1a
+    for (size_t i = 0; i < len; i++)
+    {
+        hash ^= (unsigned char)term[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Letters, digits and every byte of a multi-byte UTF-8 character
+static int is_term_byte(unsigned char c)
+{
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c >= 0x80;
+}
+
+// Copies the next term of a text into buffer, folded to lower case.
+// Returns its length, 0 once the text is exhausted.
+static size_t next_term(const char **text, char *buffer)
+{
+    const unsigned char *ptr = (const unsigned char *)*text;
+    while (*ptr != '\0' && !is_term_byte(*ptr))
+    {
+        ptr++;
+    }
+
+    size_t len = 0;
+    while (is_term_byte(*ptr))
+    {
+        if (len < MAX_TERM_LENGTH)
+        {
+            buffer[len++] = (char)(*ptr >= 'A' && *ptr <= 'Z' ? *ptr + ('a' - 'A') : *ptr);
+        }
+        ptr++;
+    }
+    *text = (const char *)ptr;
+    return len;
+}
+
+static SearchTerm *find_slot(SearchTerm *terms, size_t capacity, const char *term, size_t len, uint32_t hash)
+{
+    size_t mask = capacity - 1;
+    for (size_t i = hash & mask;; i = (i + 1) & mask)
+    {
+        SearchTerm *slot = &terms[i];
+        if (slot->text == NULL ||
+            (slot->hash == hash && slot->length == len && memcmp(slot->text, term, len) == 0))
+        {
+            return slot;
+        }
+    }
+}
+
+static int grow_table(SearchIndex *index)
+{
+    size_t capacity = index->capacity ? index->capacity * 2 : INITIAL_CAPACITY;
+    SearchTerm *terms = (SearchTerm *)calloc(capacity, sizeof(SearchTerm));
+    if (terms == NULL)
+    {
+        return -1; // Memory allocation failed
+    }
+
+    for (size_t i = 0; i < index->capacity; i++)
+    {
+        SearchTerm *old = &index->terms[i];
+        if (old->text != NULL)
+        {
+            *find_slot(terms, capacity, old->text, old->length, old->hash) = *old;
+        }
+    }
+    free(index->terms);
+    index->terms = terms;
+    index->capacity = capacity;
+    return 0;
+}
+
+// Looks a term up, adding it when create is set. Returns NULL if it is missing or cannot be added.
+static SearchTerm *get_term(SearchIndex *index, const char *term, size_t len, int create)
+{
+    if (create && (index->count + 1) * 10 > index->capacity * 7 && grow_table(index) != 0)
+    {
+        return NULL;
+    }
+    if (index->capacity == 0)
+    {
+        return NULL;
+    }
+
+    uint32_t hash = hash_term(term, len);
+    SearchTerm *slot = find_slot(index->terms, index->capacity, term, len, hash);
+    if (slot->text == NULL)
+    {
+        if (!create)
+        {
+            return NULL;
+        }
+        char *text = arena_strndup(&index->strings, term, len);
+        if (text == NULL)
+        {
+            return NULL; // Memory allocation failed
+        }
+        slot->text = text;
+        slot->length = (uint32_t)len;
+        slot->hash = hash;
+        index->count++;
+    }
+    return slot;
+}
+
+static int reserve_postings(SearchTerm *term, size_t capacity)
+{
+    if (capacity <= term->capacity)
+    {
+        return 0;
+    }
+    Node **grown = (Node **)realloc(term->nodes, capacity * sizeof(Node *));
+    if (grown == NULL)
+    {
+        return -1; // Memory allocation failed
+    }
+    term->nodes = grown;
+    term->capacity = capacity;
+    return 0;
+}
+
+static int add_posting(SearchTerm *term, Node *node)
+{
+    // A node's terms are added together, so a repeated word shows up as the last posting
+    if (term->count > 0 && term->nodes[term->count - 1] == node)
+    {
+        return 0;
+    }
+    if (term->count == term->capacity && reserve_postings(term, term->capacity ? term->capacity * 2 : 4) != 0)
+    {
+        return -1;
+    }
+    term->nodes[term->count++] = node;
+    return 0;
+}
+
+void search_init(SearchIndex *index, data_text_func text)
+{
+    index->terms = NULL;
+    index->capacity = 0;
+    index->count = 0;
+    arena_init(&index->strings, TERM_BLOCK_SIZE);
+    index->text = text;
+}
+
+int search_add(SearchIndex *index, Node *node)
+{
+    if (index == NULL || node == NULL || index->text == NULL)
+    {
+        return -1; // Invalid input
+    }
+
+    char buffer[MAX_TERM_LENGTH];
+    const char *text = index->text(node->data);
+    size_t len = 0;
+    while ((len = next_term(&text, buffer)) > 0)
+    {
+        SearchTerm *term = get_term(index, buffer, len, 1);
+        if (term == NULL || add_posting(term, node) != 0)
+        {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+void search_remove(SearchIndex *index, Node *node)
+{
+    if (index == NULL || node == NULL || index->text == NULL)
+    {
+        return; // Invalid input
+    }
+
+    char buffer[MAX_TERM_LENGTH];
+    const char *text = index->text(node->data);
+    size_t len = 0;
+    while ((len = next_term(&text, buffer)) > 0)
+    {
+        SearchTerm *term = get_term(index, buffer, len, 0);
+        if (term == NULL)
+        {
+            continue;
+        }
+        for (size_t i = 0; i < term->count; i++)
+        {
+            if (term->nodes[i] == node)
+            {
+                term->nodes[i] = term->nodes[--term->count]; // Posting lists are unordered
+                break;
+            }
+        }
+    }
+}
+
+int search_build(SearchIndex *index, Node *head)
+{
+    for (Node *node = head; node != NULL; node = node->next)
+    {
+        if (search_add(index, node) != 0)
+        {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int compare_addresses(const void *a, const void *b)
+{
+    uintptr_t first = (uintptr_t)(*(Node *const *)a);
+    uintptr_t second = (uintptr_t)(*(Node *const *)b);
+    return (first > second) - (first < second);
+}
+
+// Binary search in an array sorted by address
+static long find_node(Node **nodes, size_t count, const Node *node)
+{
+    size_t low = 0;
+    size_t high = count;
+    while (low < high)
+    {
+        size_t mid = low + (high - low) / 2;
+        if ((uintptr_t)nodes[mid] < (uintptr_t)node)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+    return low < count && nodes[low] == node ? (long)low : -1;
+}
+
+int search_query(const SearchIndex *index, const char *query, Node ***results, size_t *count)
+{
+    if (index == NULL || query == NULL || results == NULL || count == NULL)
+    {
+        return -1; // Invalid input
+    }
+    *results = NULL;
+    *count = 0;
+
+    const SearchTerm *terms[MAX_QUERY_TERMS];
+    size_t num_terms = 0;
+    size_t shortest = 0;
+    char buffer[MAX_TERM_LENGTH];
+    size_t len = 0;
+    while ((len = next_term(&query, buffer)) > 0 && num_terms < MAX_QUERY_TERMS)
+    {
+        const SearchTerm *term = get_term((SearchIndex *)index, buffer, len, 0);
+        if (term == NULL || term->count == 0)
+        {
+            return 0; // A word that occurs nowhere matches nothing
+        }
+
+        size_t i = 0;
+        while (i < num_terms && terms[i] != term)
+        {
+            i++;
+        }
+        if (i == num_terms)
+        {
+            if (num_terms == 0 || term->count < terms[shortest]->count)
+            {
+                shortest = num_terms;
+            }
+            terms[num_terms++] = term;
+        }
+    }
+    if (num_terms == 0)
+    {
+        return 0;
+    }
+
+    // Start from the rarest word and keep the nodes every other word also points at
+    size_t matched = terms[shortest]->count;
+    Node **matches = (Node **)malloc(matched * sizeof(Node *));
+    if (matches == NULL)
+    {
+        return -1; // Memory allocation failed
+    }
+    memcpy(matches, terms[shortest]->nodes, matched * sizeof(Node *));
+
+    if (num_terms > 1)
+    {
+        unsigned int *hits = (unsigned int *)calloc(matched, sizeof(unsigned int));
+        if (hits == NULL)
+        {
+            free(matches);
+            return -1; // Memory allocation failed
+        }
+        qsort(matches, matched, sizeof(Node *), compare_addresses);
+        for (size_t t = 0; t < num_terms; t++)
+        {
+            if (t == shortest)
+            {
+                continue;
+            }
+            for (size_t i = 0; i < terms[t]->count; i++)
+            {
+                long position = find_node(matches, matched, terms[t]->nodes[i]);
+                if (position >= 0)
+                {
+                    hits[position]++;
+                }
+            }
+        }
+
+        size_t kept = 0;
+        for (size_t i = 0; i < matched; i++)
+        {
+            if (hits[i] == num_terms - 1)
+            {
+                matches[kept++] = matches[i];
+            }
+        }
+        matched = kept;
+        free(hits);
+    }
+
+    *results = matches;
+    *count = matched;
+    return 0;
+}
+
+static void write_u32(Writer *writer, uint32_t value)
+{
+    writer_write(writer, &value, sizeof(value));
+}
+
+int search_save(const SearchIndex *index, const char *path, const char *temp_path, const char *snapshot_path, unsigned int snapshot_count)
+{
+    if (index == NULL || path == NULL || temp_path == NULL)
+    {
+        return -1; // Invalid input
+    }
+
+    Writer writer;
+    if (writer_open(&writer, temp_path) != 0)
+    {
+        return -1; // File could not be opened for writing
+    }
+
+    long size = 0;
+    long long mtime = 0;
+    file_stamp(snapshot_path, &size, &mtime);
+    char header[128];
+    snprintf(header, sizeof(header), SEARCH_MAGIC " %ld %lld %u\n", size, mtime, snapshot_count);
+    writer_puts(&writer, header);
+
+    for (size_t i = 0; i < index->capacity; i++)
+    {
+        const SearchTerm *term = &index->terms[i];
+        uint32_t saved = 0;
+        for (size_t j = 0; j < term->count; j++)
+        {
+            saved += term->nodes[j]->id >= 1 && term->nodes[j]->id <= snapshot_count;
+        }
+        if (saved == 0)
+        {
+            continue; // Empty slot, or only nodes the snapshot does not have
+        }
+
+        write_u32(&writer, term->length);
+        writer_write(&writer, term->text, term->length);
+        write_u32(&writer, saved);
+        for (size_t j = 0; j < term->count; j++)
+        {
+            unsigned int id = term->nodes[j]->id;
+            if (id >= 1 && id <= snapshot_count)
+            {
+                write_u32(&writer, id);
+            }
+        }
+    }
+
+    if (writer_close(&writer) != 0 || replace_file(temp_path, path) != 0)
+    {
+        remove(temp_path);
+        return -1;
+    }
+    return 0;
+}
+
+// Reads the postings that follow the header, resolving ids through by_id
+static int load_terms(SearchIndex *index, const char *data, size_t size, Node **by_id, unsigned int snapshot_count)
+{
+    size_t pos = 0;
+    while (pos < size)
+    {
+        uint32_t len = 0;
+        uint32_t count = 0;
+        if (size - pos < sizeof(len))
+        {
+            return -1; // Truncated
+        }
+        memcpy(&len, data + pos, sizeof(len));
+        pos += sizeof(len);
+        if (len == 0 || len > MAX_TERM_LENGTH || size - pos < len + sizeof(count))
+        {
+            return -1; // Corrupt or truncated
+        }
+        const char *text = data + pos;
+        pos += len;
+        memcpy(&count, data + pos, sizeof(count));
+        pos += sizeof(count);
+        if ((size - pos) / sizeof(uint32_t) < count)
+        {
+            return -1; // Truncated
+        }
+
+        SearchTerm *term = get_term(index, text, len, 1);
+        if (term == NULL || reserve_postings(term, term->count + count) != 0)
+        {
+            return -1;
+        }
+        for (uint32_t i = 0; i < count; i++, pos += sizeof(uint32_t))
+        {
+            uint32_t id = 0;
+            memcpy(&id, data + pos, sizeof(id));
+            Node *node = id >= 1 && id <= snapshot_count ? by_id[id] : NULL;
+            if (node != NULL) // NULL if the journal deleted it
+            {
+                term->nodes[term->count++] = node;
+            }
+        }
+    }
+    return 0;
+}
+
+int search_load(SearchIndex *index, const char *path, const char *snapshot_path, Node *head)
+{
+    if (index == NULL || path == NULL)
+    {
+        return -1; // Invalid input
+    }
+
+    MappedFile map = {0};
+    if (map_file(path, &map) != 0 || map.size == 0)
+    {
+        unmap_file(&map);
+        return -1; // No index yet
+    }
+
+    // The mapping is not null-terminated, so the header is parsed from a copy
+    char header[128];
+    size_t header_len = map.size < sizeof(header) - 1 ? map.size : sizeof(header) - 1;
+    memcpy(header, map.data, header_len);
+    header[header_len] = '\0';
+
+    long size = 0;
+    long long mtime = 0;
+    unsigned int snapshot_count = 0;
+    int consumed = 0;
+    long stamp_size = 0;
+    long long stamp_mtime = 0;
+    file_stamp(snapshot_path, &stamp_size, &stamp_mtime);
+    if (sscanf(header, SEARCH_MAGIC " %ld %lld %u%n", &size, &mtime, &snapshot_count, &consumed) != 3 ||
+        header[consumed] != '\n' || size != stamp_size || mtime != stamp_mtime)
+    {
+        unmap_file(&map);
+        return -1; // Not an index, or one that belongs to another snapshot
+    }
+
+    Node **by_id = (Node **)calloc((size_t)snapshot_count + 1, sizeof(Node *));
+    if (by_id == NULL)
+    {
+        unmap_file(&map);
+        return -1; // Memory allocation failed
+    }
+    for (Node *node = head; node != NULL; node = node->next)
+    {
+        if (node->id >= 1 && node->id <= snapshot_count)
+        {
+            by_id[node->id] = node;
+        }
+    }
+
+    int result = load_terms(index, map.data + consumed + 1, map.size - (size_t)consumed - 1, by_id, snapshot_count);
+    free(by_id);
+    unmap_file(&map);
+
+    // Records the journal inserted after the snapshot are not in the file
+    for (Node *node = head; node != NULL && result == 0; node = node->next)
+    {
+        if (node->id == 0 || node->id > snapshot_count)
+        {
+            result = search_add(index, node);
+        }
+    }
+
+    if (result != 0)
+    {
+        search_destroy(index);
+        search_init(index, index->text);
+    }
+    return result;
+}
+
+void search_destroy(SearchIndex *index)
+{
+    if (index == NULL)
+    {
+        return;
+    }
+    for (size_t i = 0; i < index->capacity; i++)
+    {
+        free(index->terms[i].nodes);
+    }
+    free(index->terms);
+    index->terms = NULL;
+    index->capacity = 0;
+    index->count = 0;
+    arena_destroy(&index->strings);
+}
@@ -0,0 +1,95 @@
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include <stddef.h>
+
+#include "linked_list.h"
+#include "pool.h"
+
+/**
+ * @brief A function pointer type for a function that returns the searchable text of a node's data.
+ * @param data A pointer to the data.
+ * @return The null-terminated text, never NULL.
+ */
+typedef const char *(*data_text_func)(void *data);
+
+// An inverted index from normalized terms to the nodes whose text contains them.
+// Terms are runs of letters and digits, ASCII letters are folded to lower case.
+typedef struct SearchIndex
+{
+    struct SearchTerm *terms; // Open-addressing table of terms and their posting lists
+    size_t capacity;
+    size_t count;
+    Arena strings; // Term text
+    data_text_func text;
+} SearchIndex;
+
+/**
+ * @brief Initializes an empty index.
+ * @param index The index to initialize.
+ * @param text The function that returns a node's text.
+ */
+void search_init(SearchIndex *index, data_text_func text);
+
+/**
+ * @brief Indexes every node of a linked list.
+ * @param index The index to fill.
+ * @param head The head of the linked list.
+ * @return 0 on success, -1 on failure.
+ */
+int search_build(SearchIndex *index, Node *head);
+
+/**
+ * @brief Adds a node's terms to the index. Each node must only be added once.
+ * @param index The index.
+ * @param node The node to add.
+ * @return 0 on success, -1 on failure.
+ */
+int search_add(SearchIndex *index, Node *node);
+
+/**
+ * @brief Removes a node from the index. Must be called before the node is deleted.
+ * @param index The index.
+ * @param node The node to remove.
+ */
+void search_remove(SearchIndex *index, Node *node);
+
+/**
+ * @brief Finds the nodes that contain every term of a query.
+ * @param index The index.
+ * @param query The words to look for.
+ * @param results Receives an array of the matching nodes in no particular order (the caller must free it).
+ * @param count Receives the number of matching nodes.
+ * @return 0 on success, -1 on failure.
+ */
+int search_query(const SearchIndex *index, const char *query, Node ***results, size_t *count);
+
+/**
+ * @brief Writes the index next to the snapshot it was built from. Postings are stored
+ * by node id, so only nodes with ids 1..snapshot_count (the snapshot order) are written.
+ * @param index The index.
+ * @param path Path of the index file.
+ * @param temp_path Path the index is written to before it replaces the old one.
+ * @param snapshot_path Path of the snapshot the ids refer to.
+ * @param snapshot_count Number of records in the snapshot.
+ * @return 0 on success, -1 on failure.
+ */
+int search_save(const SearchIndex *index, const char *path, const char *temp_path, const char *snapshot_path, unsigned int snapshot_count);
+
+/**
+ * @brief Loads an index written by search_save and indexes the nodes the journal added since.
+ * @param index The empty index to fill.
+ * @param path Path of the index file.
+ * @param snapshot_path Path of the snapshot the list was loaded from.
+ * @param head The head of the list, with journal ids assigned.
+ * @return 0 on success, -1 if the file is missing, belongs to another snapshot or cannot be read.
+ */
+int search_load(SearchIndex *index, const char *path, const char *snapshot_path, Node *head);
+
+/**
+ * @brief Frees the index. The nodes themselves are left alone.
+ * @param index The index to free.
+ */
+void search_destroy(SearchIndex *index);
+
+#endif // SEARCH_H
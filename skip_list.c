@@ -0,0 +1,385 @@
+#include "skip_list.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#define ENTRIES_PER_CHUNK 256
+
+// A tower of forward links, as tall as its height
+typedef struct SkipEntry
+{
+    Node *node;
+    int height;
+    SkipLink next[];
+} SkipEntry;
+
+// qsort has no context argument, so sl_build hands it the comparator here
+static compare_data_func sort_compare = NULL;
+
+// Total order of the index: the data first, then the node address
+static int entry_order(compare_data_func compare, const Node *a, const Node *b)
+{
+    int order = compare(a->data, b->data);
+    if (order != 0)
+    {
+        return order;
+    }
+    return (uintptr_t)a < (uintptr_t)b ? -1 : (uintptr_t)a > (uintptr_t)b;
+}
+
+static int sort_nodes(const void *a, const void *b)
+{
+    return entry_order(sort_compare, *(Node *const *)a, *(Node *const *)b);
+}
+
+static SkipEntry *entry_create(SkipList *list, Node *node, int height)
+{
+    SkipEntry *entry = (SkipEntry *)pool_alloc(&list->pools[height - 1]);
+    if (entry == NULL)
+    {
+        return NULL; // Memory allocation failed
+    }
+    entry->node = node;
+    entry->height = height;
+    return entry;
+}
+
+// Each level up keeps half of the entries below it
+static int random_height(SkipList *list)
+{
+    unsigned int x = list->seed;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    list->seed = x;
+
+    int height = 1;
+    while (height < SKIP_MAX_LEVEL && (x & 1))
+    {
+        height++;
+        x >>= 1;
+    }
+    return height;
+}
+
+// Empties the index without touching the pools
+static void reset_head(SkipList *list)
+{
+    for (int i = 0; i < SKIP_MAX_LEVEL; i++)
+    {
+        list->head[i].next = NULL;
+        list->head[i].width = 1; // Straight to the end of the empty index
+    }
+    list->level = 0;
+    list->count = 0;
+}
+
+void sl_init(SkipList *list, compare_data_func compare)
+{
+    reset_head(list);
+    list->compare = compare;
+    list->seed = 2463534242u;
+    for (int i = 0; i < SKIP_MAX_LEVEL; i++)
+    {
+        pool_init(&list->pools[i], sizeof(SkipEntry) + (size_t)(i + 1) * sizeof(SkipLink), ENTRIES_PER_CHUNK);
+    }
+}
+
+int sl_build(SkipList *list, Node *head)
+{
+    if (list == NULL || list->compare == NULL)
+    {
+        return -1; // Invalid input
+    }
+    sl_destroy(list);
+
+    size_t count = 0;
+    for (Node *node = head; node != NULL; node = node->next)
+    {
+        count++;
+    }
+    if (count == 0)
+    {
+        return 0;
+    }
+
+    Node **nodes = (Node **)malloc(count * sizeof(Node *));
+    if (nodes == NULL)
+    {
+        return -1; // Memory allocation failed
+    }
+
+    int sorted = 1;
+    size_t i = 0;
+    for (Node *node = head; node != NULL; node = node->next, i++)
+    {
+        nodes[i] = node;
+        if (i > 0 && entry_order(list->compare, nodes[i - 1], node) > 0)
+        {
+            sorted = 0;
+        }
+    }
+    if (!sorted)
+    {
+        sort_compare = list->compare;
+        qsort(nodes, count, sizeof(Node *), sort_nodes);
+        sort_compare = NULL;
+    }
+
+    // Sorted input needs no searching: entry i gets one level per trailing zero bit
+    // of i + 1, which gives a perfectly balanced index in a single pass
+    SkipLink *last[SKIP_MAX_LEVEL];
+    size_t last_position[SKIP_MAX_LEVEL]; // Of the entry last holds a link of, the head is 0
+    for (int l = 0; l < SKIP_MAX_LEVEL; l++)
+    {
+        last[l] = &list->head[l];
+        last_position[l] = 0;
+    }
+    for (i = 0; i < count; i++)
+    {
+        int height = 1;
+        size_t position = i + 1;
+        while (height < SKIP_MAX_LEVEL && (position & 1) == 0)
+        {
+            height++;
+            position >>= 1;
+        }
+
+        SkipEntry *entry = entry_create(list, nodes[i], height);
+        if (entry == NULL)
+        {
+            free(nodes);
+            sl_destroy(list);
+            return -1;
+        }
+        for (int l = 0; l < height; l++)
+        {
+            last[l]->next = entry;
+            last[l]->width = i + 1 - last_position[l];
+            last[l] = &entry->next[l];
+            last_position[l] = i + 1;
+        }
+        if (height > list->level)
+        {
+            list->level = height;
+        }
+    }
+    for (int l = 0; l < SKIP_MAX_LEVEL; l++)
+    {
+        last[l]->next = NULL;
+        last[l]->width = count + 1 - last_position[l];
+    }
+    list->count = count;
+
+    free(nodes);
+    return 0;
+}
+
+// Fills update with the link on every level that points at the first entry not before node,
+// and position with the position of the entry each link belongs to, the head being 0
+static void find_links(SkipList *list, const Node *node, SkipLink *update[], size_t position[])
+{
+    SkipLink *links = list->head;
+    size_t at = 0;
+    for (int l = list->level - 1; l >= 0; l--)
+    {
+        while (links[l].next != NULL && entry_order(list->compare, links[l].next->node, node) < 0)
+        {
+            at += links[l].width;
+            links = links[l].next->next;
+        }
+        update[l] = &links[l];
+        position[l] = at;
+    }
+}
+
+int sl_insert(SkipList *list, Node *node)
+{
+    if (list == NULL || node == NULL || list->compare == NULL)
+    {
+        return -1; // Invalid input
+    }
+
+    SkipLink *update[SKIP_MAX_LEVEL];
+    size_t position[SKIP_MAX_LEVEL];
+    find_links(list, node, update, position);
+
+    int height = random_height(list);
+    SkipEntry *entry = entry_create(list, node, height);
+    if (entry == NULL)
+    {
+        return -1;
+    }
+    for (; list->level < height; list->level++)
+    {
+        update[list->level] = &list->head[list->level];
+        update[list->level]->next = NULL;
+        update[list->level]->width = list->count + 1;
+        position[list->level] = 0;
+    }
+    // The new entry lands right after the one update[0] belongs to
+    size_t at = position[0] + 1;
+    for (int l = 0; l < height; l++)
+    {
+        entry->next[l].next = update[l]->next;
+        entry->next[l].width = position[l] + update[l]->width + 1 - at;
+        update[l]->next = entry;
+        update[l]->width = at - position[l];
+    }
+    for (int l = height; l < list->level; l++)
+    {
+        update[l]->width++; // Passes over the new entry
+    }
+    list->count++;
+    return 0;
+}
+
+void sl_remove(SkipList *list, Node *node)
+{
+    if (list == NULL || node == NULL || list->level == 0)
+    {
+        return; // Invalid input
+    }
+
+    SkipLink *update[SKIP_MAX_LEVEL];
+    size_t position[SKIP_MAX_LEVEL];
+    find_links(list, node, update, position);
+
+    SkipEntry *entry = update[0]->next;
+    if (entry == NULL || entry->node != node)
+    {
+        return; // Not indexed
+    }
+    for (int l = 0; l < list->level; l++)
+    {
+        if (l < entry->height)
+        {
+            update[l]->width += entry->next[l].width - 1;
+            update[l]->next = entry->next[l].next;
+        }
+        else
+        {
+            update[l]->width--;
+        }
+    }
+    pool_free(&list->pools[entry->height - 1], entry);
+    list->count--;
+
+    while (list->level > 0 && list->head[list->level - 1].next == NULL)
+    {
+        list->level--;
+    }
+}
+
+Node *sl_lower_bound(const SkipList *list, const void *key)
+{
+    if (list == NULL || key == NULL)
+    {
+        return NULL;
+    }
+
+    const SkipLink *links = list->head;
+    for (int l = list->level - 1; l >= 0; l--)
+    {
+        while (links[l].next != NULL && list->compare(links[l].next->node->data, key) < 0)
+        {
+            links = links[l].next->next;
+        }
+    }
+    return list->level > 0 && links[0].next != NULL ? links[0].next->node : NULL;
+}
+
+Node *sl_floor(const SkipList *list, const void *key)
+{
+    if (list == NULL || key == NULL)
+    {
+        return NULL;
+    }
+
+    SkipEntry *last = NULL;
+    const SkipLink *links = list->head;
+    for (int l = list->level - 1; l >= 0; l--)
+    {
+        while (links[l].next != NULL && list->compare(links[l].next->node->data, key) <= 0)
+        {
+            last = links[l].next;
+            links = links[l].next->next;
+        }
+    }
+    return last != NULL ? last->node : NULL;
+}
+
+Node *sl_first(const SkipList *list)
+{
+    if (list == NULL || list->level == 0 || list->head[0].next == NULL)
+    {
+        return NULL;
+    }
+    return list->head[0].next->node;
+}
+
+size_t sl_rank(const SkipList *list, const Node *node)
+{
+    if (list == NULL || node == NULL || list->compare == NULL)
+    {
+        return 0; // Invalid input
+    }
+
+    const SkipLink *links = list->head;
+    size_t at = 0;
+    for (int l = list->level - 1; l >= 0; l--)
+    {
+        while (links[l].next != NULL && entry_order(list->compare, links[l].next->node, node) < 0)
+        {
+            at += links[l].width;
+            links = links[l].next->next;
+        }
+    }
+    if (list->level == 0 || links[0].next == NULL || links[0].next->node != node)
+    {
+        return list->count; // Not indexed
+    }
+    return at; // The entry before it is at position at, counting the head as 0
+}
+
+size_t sl_range(const SkipList *list, size_t position, Node **nodes, size_t count)
+{
+    if (list == NULL || nodes == NULL || position >= list->count)
+    {
+        return 0; // Invalid input, or past the end
+    }
+
+    // Down the levels to the entry at position + 1, counting the head as 0
+    const SkipLink *links = list->head;
+    SkipEntry *entry = NULL;
+    size_t at = 0;
+    for (int l = list->level - 1; l >= 0; l--)
+    {
+        while (links[l].next != NULL && at + links[l].width <= position + 1)
+        {
+            at += links[l].width;
+            entry = links[l].next;
+            links = entry->next;
+        }
+    }
+
+    size_t found = 0;
+    for (; entry != NULL && found < count; entry = entry->next[0].next)
+    {
+        nodes[found++] = entry->node;
+    }
+    return found;
+}
+
+void sl_destroy(SkipList *list)
+{
+    if (list == NULL)
+    {
+        return;
+    }
+    for (int i = 0; i < SKIP_MAX_LEVEL; i++)
+    {
+        pool_destroy(&list->pools[i]);
+    }
+    reset_head(list);
+}
@@ -0,0 +1,117 @@
+#ifndef SKIP_LIST_H
+#define SKIP_LIST_H
+
+#include <stddef.h>
+
+#include "linked_list.h"
+#include "pool.h"
+
+// Height limit of a tower, enough for far more nodes than a diary will ever hold
+#define SKIP_MAX_LEVEL 24
+
+/**
+ * @brief A function pointer type for a function that orders two nodes' data.
+ * @param a A pointer to the first data.
+ * @param b A pointer to the second data.
+ * @return A negative number, zero or a positive number as a sorts before, with or after b.
+ */
+typedef int (*compare_data_func)(const void *a, const void *b);
+
+// A forward link of a tower and how many positions it skips
+typedef struct SkipLink
+{
+    struct SkipEntry *next;
+    size_t width; // A link to the end skips to one past the last entry
+} SkipLink;
+
+// An ordered index over the nodes of a linked list. The list keeps its own order,
+// the index only points at its nodes. Nodes that compare equal are kept apart by address.
+// Every link counts the entries it skips, so positions are found as fast as keys.
+typedef struct SkipList
+{
+    SkipLink head[SKIP_MAX_LEVEL];
+    int level; // Levels currently in use
+    size_t count;
+    compare_data_func compare;
+    Pool pools[SKIP_MAX_LEVEL]; // One pool per tower height
+    unsigned int seed;
+} SkipList;
+
+/**
+ * @brief Initializes an empty index.
+ * @param list The index to initialize.
+ * @param compare The function that orders the nodes' data.
+ */
+void sl_init(SkipList *list, compare_data_func compare);
+
+/**
+ * @brief Indexes every node of a linked list, replacing what the index held before.
+ * @param list The index to fill.
+ * @param head The head of the linked list.
+ * @return 0 on success, -1 on failure.
+ */
+int sl_build(SkipList *list, Node *head);
+
+/**
+ * @brief Adds a node to the index.
+ * @param list The index.
+ * @param node The node to add.
+ * @return 0 on success, -1 on failure.
+ */
+int sl_insert(SkipList *list, Node *node);
+
+/**
+ * @brief Removes a node from the index. Must be called before the node is deleted.
+ * @param list The index.
+ * @param node The node to remove.
+ */
+void sl_remove(SkipList *list, Node *node);
+
+/**
+ * @brief Finds the first node whose data does not sort before the key.
+ * @param list The index.
+ * @param key Data to compare the nodes' data with.
+ * @return The node, or NULL if every node sorts before the key.
+ */
+Node *sl_lower_bound(const SkipList *list, const void *key);
+
+/**
+ * @brief Finds the last node whose data does not sort after the key.
+ * @param list The index.
+ * @param key Data to compare the nodes' data with.
+ * @return The node, or NULL if every node sorts after the key.
+ */
+Node *sl_floor(const SkipList *list, const void *key);
+
+/**
+ * @brief Returns the node that sorts first.
+ * @param list The index.
+ * @return The node, or NULL if the index is empty.
+ */
+Node *sl_first(const SkipList *list);
+
+/**
+ * @brief Finds where a node sorts in the index.
+ * @param list The index.
+ * @param node The node to look for.
+ * @return The node's 0-based position, or the number of indexed nodes if it is not indexed.
+ */
+size_t sl_rank(const SkipList *list, const Node *node);
+
+/**
+ * @brief Collects the nodes at consecutive positions, in index order.
+ * @param list The index.
+ * @param position The 0-based position of the first node.
+ * @param nodes Receives the nodes.
+ * @param count The most nodes to collect.
+ * @return The number of nodes collected, fewer than count at the end of the index.
+ */
+size_t sl_range(const SkipList *list, size_t position, Node **nodes, size_t count);
+
+/**
+ * @brief Frees the index. The nodes themselves are left alone.
+ * @param list The index to free.
+ */
+void sl_destroy(SkipList *list);
+
+#endif // SKIP_LIST_H
@@ -0,0 +1,89 @@
+#include "storage.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "file.h"
+#include "record.h"
+#include "trace.h"
+
+DiaryFormat storage_detect(const char *data, size_t size)
+{
+    if (data != NULL && size >= sizeof(BINARY_MAGIC) - 1 && memcmp(data, BINARY_MAGIC, sizeof(BINARY_MAGIC) - 1) == 0)
+    {
+        return DIARY_FORMAT_BINARY;
+    }
+    return DIARY_FORMAT_JSON;
+}
+
+int storage_load(const char *data, size_t size, Node **head, Node **tail, int *length, DiaryFormat *format)
+{
+    if (format == NULL)
+    {
+        return -1; // Invalid input
+    }
+
+    *format = storage_detect(data, size);
+    if (*format == DIARY_FORMAT_BINARY)
+    {
+        return ll_from_binary(data, size, head, tail, deserialize_record_binary, length, record_alloc,
+                              (free_data_func)free_record);
+    }
+    return ll_from_json_parallel(data, size, head, tail, deserialize_record_lazy, sizeof(Record), length, record_alloc,
+                                 (free_data_func)free_record);
+}
+
+int storage_write(Node *head, Writer *writer, DiaryFormat format)
+{
+    if (format == DIARY_FORMAT_BINARY)
+    {
+        return ll_write_binary(head, writer, serialize_record_binary);
+    }
+    return ll_write_json_parallel(head, writer, serialize_record);
+}
+
+int storage_write_file(Node *head, const char *path, DiaryFormat format, int sync, size_t *written)
+{
+    Writer writer;
+    if (writer_open(&writer, path) != 0)
+    {
+        writer_close(&writer);
+        return -1; // File could not be opened for writing
+    }
+
+    long long span = trace_begin(); // The flushes show up as "write" spans inside it
+    int result = storage_write(head, &writer, format);
+    trace_end("serialize", span);
+    size_t position = writer.position;
+    if (result == 0 && sync && writer_sync(&writer) != 0)
+    {
+        result = -1;
+    }
+    if (writer_close(&writer) != 0 || result != 0)
+    {
+        remove(path);
+        return -1; // Write failed
+    }
+    if (written != NULL)
+    {
+        *written = position;
+    }
+    return 0;
+}
+
+int storage_save(Node *head, const char *path, const char *temp_path, DiaryFormat format, int sync, size_t *written)
+{
+    if (storage_write_file(head, temp_path, format, sync, written) != 0)
+    {
+        return -1; // The old file is left untouched
+    }
+    if (replace_file(temp_path, path) != 0)
+    {
+        return -1;
+    }
+    if (sync)
+    {
+        sync_dir(path); // The new diary is already complete on disk, only the rename could be lost
+    }
+    return 0;
+}
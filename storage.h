@@ -0,0 +1,70 @@
+#ifndef STORAGE_H
+#define STORAGE_H
+
+#include <stddef.h>
+
+#include "linked_list.h"
+#include "writer.h"
+
+// On-disk formats of a diary
+typedef enum DiaryFormat
+{
+    DIARY_FORMAT_JSON,  // JSON array of records
+    DIARY_FORMAT_BINARY // Header, fixed-size record index and one note blob
+} DiaryFormat;
+
+/**
+ * @brief Detects the format of a diary file from its first bytes.
+ * @param data The file contents.
+ * @param size The size of the file.
+ * @return The detected format, JSON if it is not binary.
+ */
+DiaryFormat storage_detect(const char *data, size_t size);
+
+/**
+ * @brief Loads diary records from a file's contents, in whichever format they are.
+ * Notes are left in the buffer and decoded on demand, so it must outlive the records.
+ * @param data The file contents, usually a mapping.
+ * @param size The size of the file.
+ * @param head A pointer to the head of the list to populate.
+ * @param tail A pointer to the tail of the list to populate.
+ * @param length A pointer to the number of records, incremented for each record.
+ * @param format Receives the detected format.
+ * @return 0 on success, -1 on failure.
+ */
+int storage_load(const char *data, size_t size, Node **head, Node **tail, int *length, DiaryFormat *format);
+
+/**
+ * @brief Writes diary records in the given format.
+ * @param head The head of the list.
+ * @param writer The writer to write to.
+ * @param format The format to write.
+ * @return 0 on success, -1 on failure.
+ */
+int storage_write(Node *head, Writer *writer, DiaryFormat format);
+
+/**
+ * @brief Writes diary records to a new file. The file is removed again if writing fails.
+ * @param head The head of the list.
+ * @param path The file to create.
+ * @param format The format to write.
+ * @param sync 1 to force the file to disk before returning.
+ * @param written Receives the number of bytes written, may be NULL.
+ * @return 0 on success, -1 on failure.
+ */
+int storage_write_file(Node *head, const char *path, DiaryFormat format, int sync, size_t *written);
+
+/**
+ * @brief Writes diary records to a temporary file and renames it over the target,
+ * so a mapping of the old file stays valid and a crash leaves the old or the new diary.
+ * @param head The head of the list.
+ * @param path The diary file to replace.
+ * @param temp_path The temporary file to write first.
+ * @param format The format to write.
+ * @param sync 1 to force the new file and the rename to disk before returning.
+ * @param written Receives the number of bytes written, may be NULL.
+ * @return 0 on success, -1 on failure.
+ */
+int storage_save(Node *head, const char *path, const char *temp_path, DiaryFormat format, int sync, size_t *written);
+
+#endif // STORAGE_H
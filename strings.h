@@ -1,98 +1,170 @@
-unsigned char strings_ini[] = {
-  0x5b, 0x63, 0x73, 0x5d, 0x0a, 0x68, 0x65, 0x6c, 0x70, 0x20, 0x3d, 0x20,
-  0x44, 0x65, 0x6e, 0xc3, 0xad, 0x6b, 0x20, 0x73, 0x65, 0x20, 0x6f, 0x76,
-  0x6c, 0xc3, 0xa1, 0x64, 0xc3, 0xa1, 0x20, 0x6e, 0xc3, 0xa1, 0x73, 0x6c,
-  0x65, 0x64, 0x75, 0x6a, 0xc3, 0xad, 0x63, 0xc3, 0xad, 0x6d, 0x69, 0x20,
-  0x70, 0xc5, 0x99, 0xc3, 0xad, 0x6b, 0x61, 0x7a, 0x79, 0x3a, 0x5c, 0x6e,
-  0x2d, 0x20, 0x70, 0x72, 0x65, 0x64, 0x63, 0x68, 0x6f, 0x7a, 0x69, 0x3a,
-  0x20, 0x50, 0xc5, 0x99, 0x65, 0x73, 0x75, 0x6e, 0x75, 0x74, 0xc3, 0xad,
-  0x20, 0x6e, 0x61, 0x20, 0x70, 0xc5, 0x99, 0x65, 0x64, 0x63, 0x68, 0x6f,
-  0x7a, 0xc3, 0xad, 0x20, 0x7a, 0xc3, 0xa1, 0x7a, 0x6e, 0x61, 0x6d, 0x5c,
-  0x6e, 0x2d, 0x20, 0x64, 0x61, 0x6c, 0x73, 0x69, 0x3a, 0x20, 0x50, 0xc5,
-  0x99, 0x65, 0x73, 0x75, 0x6e, 0x75, 0x74, 0xc3, 0xad, 0x20, 0x6e, 0x61,
-  0x20, 0x64, 0x61, 0x6c, 0xc5, 0xa1, 0xc3, 0xad, 0x20, 0x7a, 0xc3, 0xa1,
-  0x7a, 0x6e, 0x61, 0x6d, 0x5c, 0x6e, 0x2d, 0x20, 0x6e, 0x6f, 0x76, 0x79,
-  0x3a, 0x20, 0x56, 0x79, 0x74, 0x76, 0x6f, 0xc5, 0x99, 0x65, 0x6e, 0xc3,
-  0xad, 0x20, 0x6e, 0x6f, 0x76, 0xc3, 0xa9, 0x68, 0x6f, 0x20, 0x7a, 0xc3,
-  0xa1, 0x7a, 0x6e, 0x61, 0x6d, 0x75, 0x5c, 0x6e, 0x2d, 0x20, 0x75, 0x6c,
-  0x6f, 0x7a, 0x3a, 0x20, 0x55, 0x6c, 0x6f, 0xc5, 0xbe, 0x65, 0x6e, 0xc3,
-  0xad, 0x20, 0x76, 0x79, 0x74, 0x76, 0x6f, 0xc5, 0x99, 0x65, 0x6e, 0xc3,
-  0xa9, 0x68, 0x6f, 0x20, 0x7a, 0xc3, 0xa1, 0x7a, 0x6e, 0x61, 0x6d, 0x75,
-  0x5c, 0x6e, 0x2d, 0x20, 0x73, 0x6d, 0x61, 0x7a, 0x3a, 0x20, 0x4f, 0x64,
-  0x73, 0x74, 0x72, 0x61, 0x6e, 0xc4, 0x9b, 0x6e, 0xc3, 0xad, 0x20, 0x7a,
-  0xc3, 0xa1, 0x7a, 0x6e, 0x61, 0x6d, 0x75, 0x5c, 0x6e, 0x2d, 0x20, 0x7a,
-  0x61, 0x76, 0x72, 0x69, 0x3a, 0x20, 0x5a, 0x61, 0x76, 0xc5, 0x99, 0x65,
-  0x6e, 0xc3, 0xad, 0x20, 0x64, 0x65, 0x6e, 0xc3, 0xad, 0x6b, 0x75, 0x0a,
-  0x72, 0x65, 0x63, 0x6f, 0x72, 0x64, 0x5f, 0x6e, 0x75, 0x6d, 0x20, 0x3d,
-  0x20, 0x50, 0x6f, 0xc4, 0x8d, 0x65, 0x74, 0x20, 0x7a, 0xc3, 0xa1, 0x7a,
-  0x6e, 0x61, 0x6d, 0xc5, 0xaf, 0x0a, 0x64, 0x61, 0x74, 0x65, 0x20, 0x3d,
-  0x20, 0x44, 0x61, 0x74, 0x75, 0x6d, 0x0a, 0x65, 0x6e, 0x74, 0x65, 0x72,
-  0x5f, 0x63, 0x6f, 0x6d, 0x6d, 0x61, 0x6e, 0x64, 0x20, 0x3d, 0x20, 0x5a,
-  0x61, 0x64, 0x65, 0x6a, 0x74, 0x65, 0x20, 0x70, 0xc5, 0x99, 0xc3, 0xad,
-  0x6b, 0x61, 0x7a, 0x0a, 0x65, 0x6e, 0x74, 0x65, 0x72, 0x5f, 0x64, 0x61,
-  0x74, 0x65, 0x20, 0x3d, 0x20, 0x44, 0x61, 0x74, 0x75, 0x6d, 0x0a, 0x65,
-  0x6e, 0x74, 0x65, 0x72, 0x5f, 0x6e, 0x6f, 0x74, 0x65, 0x20, 0x3d, 0x20,
-  0x54, 0x65, 0x78, 0x74, 0x0a, 0x64, 0x65, 0x6c, 0x65, 0x74, 0x65, 0x5f,
-  0x63, 0x6f, 0x6e, 0x66, 0x69, 0x72, 0x6d, 0x20, 0x3d, 0x20, 0x4f, 0x70,
-  0x72, 0x61, 0x76, 0x64, 0x75, 0x20, 0x63, 0x68, 0x63, 0x65, 0x74, 0x65,
-  0x20, 0x73, 0x6d, 0x61, 0x7a, 0x61, 0x74, 0x20, 0x74, 0x65, 0x6e, 0x74,
-  0x6f, 0x20, 0x7a, 0xc3, 0xa1, 0x7a, 0x6e, 0x61, 0x6d, 0x3f, 0x20, 0x28,
-  0x61, 0x2f, 0x6e, 0x29, 0x0a, 0x63, 0x6d, 0x64, 0x5f, 0x6e, 0x65, 0x78,
-  0x74, 0x20, 0x3d, 0x20, 0x64, 0x61, 0x6c, 0x73, 0x69, 0x0a, 0x63, 0x6d,
-  0x64, 0x5f, 0x70, 0x72, 0x65, 0x76, 0x20, 0x3d, 0x20, 0x70, 0x72, 0x65,
-  0x64, 0x63, 0x68, 0x6f, 0x7a, 0x69, 0x0a, 0x63, 0x6d, 0x64, 0x5f, 0x6e,
-  0x65, 0x77, 0x20, 0x3d, 0x20, 0x6e, 0x6f, 0x76, 0x79, 0x0a, 0x63, 0x6d,
-  0x64, 0x5f, 0x73, 0x61, 0x76, 0x65, 0x20, 0x3d, 0x20, 0x75, 0x6c, 0x6f,
-  0x7a, 0x0a, 0x63, 0x6d, 0x64, 0x5f, 0x64, 0x65, 0x6c, 0x65, 0x74, 0x65,
-  0x20, 0x3d, 0x20, 0x73, 0x6d, 0x61, 0x7a, 0x0a, 0x63, 0x6d, 0x64, 0x5f,
-  0x63, 0x6c, 0x6f, 0x73, 0x65, 0x20, 0x3d, 0x20, 0x7a, 0x61, 0x76, 0x72,
-  0x69, 0x0a, 0x63, 0x6d, 0x64, 0x5f, 0x63, 0x6f, 0x6e, 0x66, 0x69, 0x72,
-  0x6d, 0x20, 0x3d, 0x20, 0x61, 0x6e, 0x6f, 0x0a, 0x0a, 0x0a, 0x5b, 0x65,
-  0x6e, 0x5d, 0x0a, 0x68, 0x65, 0x6c, 0x70, 0x20, 0x3d, 0x20, 0x54, 0x68,
-  0x65, 0x20, 0x64, 0x69, 0x61, 0x72, 0x79, 0x20, 0x69, 0x73, 0x20, 0x63,
-  0x6f, 0x6e, 0x74, 0x72, 0x6f, 0x6c, 0x6c, 0x65, 0x64, 0x20, 0x62, 0x79,
-  0x20, 0x74, 0x68, 0x65, 0x20, 0x66, 0x6f, 0x6c, 0x6c, 0x6f, 0x77, 0x69,
-  0x6e, 0x67, 0x20, 0x63, 0x6f, 0x6d, 0x6d, 0x61, 0x6e, 0x64, 0x73, 0x3a,
-  0x5c, 0x6e, 0x2d, 0x20, 0x70, 0x72, 0x65, 0x76, 0x69, 0x6f, 0x75, 0x73,
-  0x3a, 0x20, 0x4d, 0x6f, 0x76, 0x65, 0x20, 0x74, 0x6f, 0x20, 0x74, 0x68,
-  0x65, 0x20, 0x70, 0x72, 0x65, 0x76, 0x69, 0x6f, 0x75, 0x73, 0x20, 0x72,
-  0x65, 0x63, 0x6f, 0x72, 0x64, 0x5c, 0x6e, 0x2d, 0x20, 0x6e, 0x65, 0x78,
-  0x74, 0x3a, 0x20, 0x4d, 0x6f, 0x76, 0x65, 0x20, 0x74, 0x6f, 0x20, 0x74,
-  0x68, 0x65, 0x20, 0x6e, 0x65, 0x78, 0x74, 0x20, 0x72, 0x65, 0x63, 0x6f,
-  0x72, 0x64, 0x5c, 0x6e, 0x2d, 0x20, 0x6e, 0x65, 0x77, 0x3a, 0x20, 0x43,
-  0x72, 0x65, 0x61, 0x74, 0x65, 0x20, 0x61, 0x20, 0x6e, 0x65, 0x77, 0x20,
-  0x72, 0x65, 0x63, 0x6f, 0x72, 0x64, 0x5c, 0x6e, 0x2d, 0x20, 0x73, 0x61,
-  0x76, 0x65, 0x3a, 0x20, 0x53, 0x61, 0x76, 0x65, 0x20, 0x74, 0x68, 0x65,
-  0x20, 0x63, 0x72, 0x65, 0x61, 0x74, 0x65, 0x64, 0x20, 0x72, 0x65, 0x63,
-  0x6f, 0x72, 0x64, 0x5c, 0x6e, 0x2d, 0x20, 0x64, 0x65, 0x6c, 0x65, 0x74,
-  0x65, 0x3a, 0x20, 0x52, 0x65, 0x6d, 0x6f, 0x76, 0x65, 0x20, 0x61, 0x20,
-  0x72, 0x65, 0x63, 0x6f, 0x72, 0x64, 0x5c, 0x6e, 0x2d, 0x20, 0x63, 0x6c,
-  0x6f, 0x73, 0x65, 0x3a, 0x20, 0x43, 0x6c, 0x6f, 0x73, 0x65, 0x20, 0x74,
-  0x68, 0x65, 0x20, 0x64, 0x69, 0x61, 0x72, 0x79, 0x0a, 0x72, 0x65, 0x63,
-  0x6f, 0x72, 0x64, 0x5f, 0x6e, 0x75, 0x6d, 0x20, 0x3d, 0x20, 0x4e, 0x75,
-  0x6d, 0x62, 0x65, 0x72, 0x20, 0x6f, 0x66, 0x20, 0x72, 0x65, 0x63, 0x6f,
-  0x72, 0x64, 0x73, 0x0a, 0x64, 0x61, 0x74, 0x65, 0x20, 0x3d, 0x20, 0x44,
-  0x61, 0x74, 0x65, 0x0a, 0x65, 0x6e, 0x74, 0x65, 0x72, 0x5f, 0x63, 0x6f,
-  0x6d, 0x6d, 0x61, 0x6e, 0x64, 0x20, 0x3d, 0x20, 0x45, 0x6e, 0x74, 0x65,
-  0x72, 0x20, 0x63, 0x6f, 0x6d, 0x6d, 0x61, 0x6e, 0x64, 0x0a, 0x65, 0x6e,
-  0x74, 0x65, 0x72, 0x5f, 0x64, 0x61, 0x74, 0x65, 0x20, 0x3d, 0x20, 0x44,
-  0x61, 0x74, 0x65, 0x0a, 0x65, 0x6e, 0x74, 0x65, 0x72, 0x5f, 0x6e, 0x6f,
-  0x74, 0x65, 0x20, 0x3d, 0x20, 0x4e, 0x6f, 0x74, 0x65, 0x0a, 0x64, 0x65,
-  0x6c, 0x65, 0x74, 0x65, 0x5f, 0x63, 0x6f, 0x6e, 0x66, 0x69, 0x72, 0x6d,
-  0x20, 0x3d, 0x20, 0x41, 0x72, 0x65, 0x20, 0x79, 0x6f, 0x75, 0x20, 0x73,
-  0x75, 0x72, 0x65, 0x20, 0x79, 0x6f, 0x75, 0x20, 0x77, 0x61, 0x6e, 0x74,
-  0x20, 0x74, 0x6f, 0x20, 0x64, 0x65, 0x6c, 0x65, 0x74, 0x65, 0x20, 0x74,
-  0x68, 0x69, 0x73, 0x20, 0x72, 0x65, 0x63, 0x6f, 0x72, 0x64, 0x3f, 0x20,
-  0x28, 0x79, 0x2f, 0x6e, 0x29, 0x0a, 0x63, 0x6d, 0x64, 0x5f, 0x6e, 0x65,
-  0x78, 0x74, 0x20, 0x3d, 0x20, 0x6e, 0x65, 0x78, 0x74, 0x0a, 0x63, 0x6d,
-  0x64, 0x5f, 0x70, 0x72, 0x65, 0x76, 0x20, 0x3d, 0x20, 0x70, 0x72, 0x65,
-  0x76, 0x69, 0x6f, 0x75, 0x73, 0x0a, 0x63, 0x6d, 0x64, 0x5f, 0x6e, 0x65,
-  0x77, 0x20, 0x3d, 0x20, 0x6e, 0x65, 0x77, 0x0a, 0x63, 0x6d, 0x64, 0x5f,
-  0x73, 0x61, 0x76, 0x65, 0x20, 0x3d, 0x20, 0x73, 0x61, 0x76, 0x65, 0x0a,
-  0x63, 0x6d, 0x64, 0x5f, 0x64, 0x65, 0x6c, 0x65, 0x74, 0x65, 0x20, 0x3d,
-  0x20, 0x64, 0x65, 0x6c, 0x65, 0x74, 0x65, 0x0a, 0x63, 0x6d, 0x64, 0x5f,
-  0x63, 0x6c, 0x6f, 0x73, 0x65, 0x20, 0x3d, 0x20, 0x63, 0x6c, 0x6f, 0x73,
-  0x65, 0x0a, 0x63, 0x6d, 0x64, 0x5f, 0x63, 0x6f, 0x6e, 0x66, 0x69, 0x72,
-  0x6d, 0x20, 0x3d, 0x20, 0x79, 0x65, 0x73, 0x0a
+// Generated from strings.ini by tools/gen_strings, do not edit.
+
+#ifndef STRINGS_H
+#define STRINGS_H
+
+// The keys, numbered by their slot in the perfect hash
+typedef enum StringKey
+{
+    STR_overview,
+    STR_paste_file,
+    STR_cmd_goto,
+    STR_cmd_confirm,
+    STR_record_num,
+    STR_cmd_edit,
+    STR_grep_matches,
+    STR_delete_confirm,
+    STR_cmd_new,
+    STR_cmd_lang,
+    STR_press_enter,
+    STR_cmd_overview,
+    STR_edit_help,
+    STR_cmd_search,
+    STR_search_none,
+    STR_cmd_save,
+    STR_enter_note,
+    STR_enter_date,
+    STR_cmd_grep,
+    STR_cmd_prev,
+    STR_help,
+    STR_search_result,
+    STR_edit_title,
+    STR_date,
+    STR_cmd_delete,
+    STR_pasted,
+    STR_enter_command,
+    STR_paste_help,
+    STR_cmd_paste,
+    STR_cmd_next,
+    STR_overview_help,
+    STR_cmd_close,
+    STRING_COUNT
+} StringKey;
+
+// The sections
+typedef enum Language
+{
+    LANG_cs,
+    LANG_en,
+    LANGUAGE_COUNT
+} Language;
+
+// The tables themselves are only compiled into i18n.c
+#if defined(STRINGS_TABLES)
+static const char *const string_keys[STRING_COUNT] = {
+    "overview",
+    "paste_file",
+    "cmd_goto",
+    "cmd_confirm",
+    "record_num",
+    "cmd_edit",
+    "grep_matches",
+    "delete_confirm",
+    "cmd_new",
+    "cmd_lang",
+    "press_enter",
+    "cmd_overview",
+    "edit_help",
+    "cmd_search",
+    "search_none",
+    "cmd_save",
+    "enter_note",
+    "enter_date",
+    "cmd_grep",
+    "cmd_prev",
+    "help",
+    "search_result",
+    "edit_title",
+    "date",
+    "cmd_delete",
+    "pasted",
+    "enter_command",
+    "paste_help",
+    "cmd_paste",
+    "cmd_next",
+    "overview_help",
+    "cmd_close",
 };
-unsigned int strings_ini_len = 1136;
+
+static const unsigned int string_seeds[STRING_COUNT] = {
+    1, 0, 3, 0, 1, 0, 0, 3,
+    1, 2, 1, 5, 6, 3, 0, 1,
+    1, 1, 2, 2, 0, 8, 0, 3,
+    6, 6, 2, 6, 6, 0, 0, 28,
+};
+
+static const char *const language_codes[LANGUAGE_COUNT] = {"cs", "en"};
+
+static const char *const string_table[LANGUAGE_COUNT][STRING_COUNT] = {
+    {
+        "Přehled",
+        "Soubor, nebo Enter pro vložení textu",
+        "prejdi",
+        "ano",
+        "Počet záznamů",
+        "uprav",
+        "Nalezené záznamy",
+        "Opravdu chcete smazat tento záznam\? (a/n)",
+        "novy",
+        "jazyk",
+        "Stiskněte Enter pro procházení",
+        "prehled",
+        "Ctrl-S: uložit  Esc: zahodit změny",
+        "hledej",
+        "Žádný záznam neobsahuje všechna slova",
+        "uloz",
+        "Text",
+        "Datum",
+        "najdi",
+        "predchozi",
+        "Deník se ovládá následujícími příkazy:\n- predchozi [počet]: Přesunutí na předchozí záznam\n- dalsi [počet]: Přesunutí na další záznam\n- prejdi <datum>: Přesunutí na první záznam od data\n- hledej <slova>: Hledání záznamů se všemi slovy, dalsi a predchozi procházejí nalezené, samotné hledej hledání ukončí\n- najdi <text>: Vypsání záznamů obsahujících text, dalsi a predchozi je pak procházejí\n- novy: Vytvoření nového záznamu\n- uloz: Uložení vytvořeného záznamu\n- vloz: Při psaní textu vložení jeho zbytku najednou nebo ze souboru, záznam se pak uloží\n- uprav: Úprava textu záznamu\n- smaz: Odstranění záznamu\n- jazyk <kód>: Přepnutí jazyka (cs, en)\n- prehled: Přehled záznamů podle data, řádek na záznam\n- zavri: Zavření deníku\nPříkazy lze zkrátit, např. d pro dalsi nebo p pro predchozi\nŠipky, PgUp/PgDn a Home/End procházejí záznamy bez Enteru",
+        "Výsledek hledání",
+        "Úprava záznamu",
+        "Datum",
+        "smaz",
+        "Vloženo bajtů",
+        "Zadejte příkaz",
+        "Vložte text, Ctrl-D jej ukončí, Ctrl-C zahodí",
+        "vloz",
+        "dalsi",
+        "Šipky, PgUp/PgDn, Home/End: posun  Enter: otevřít  q/Esc: zpět",
+        "zavri",
+    },
+    {
+        "Overview",
+        "File, or Enter to paste the text",
+        "goto",
+        "yes",
+        "Number of records",
+        "edit",
+        "Matching records",
+        "Are you sure you want to delete this record\? (y/n)",
+        "new",
+        "lang",
+        "Press Enter to step through them",
+        "overview",
+        "Ctrl-S: save  Esc: discard the changes",
+        "search",
+        "No record contains all the words",
+        "save",
+        "Note",
+        "Date",
+        "grep",
+        "previous",
+        "The diary is controlled by the following commands:\n- previous [count]: Move to the previous record\n- next [count]: Move to the next record\n- goto <date>: Move to the first record on or after a date\n- search <words>: Find records containing all the words, next and previous step through them, search alone ends the search\n- grep <text>: List the records containing the text, next and previous then step through them\n- new: Create a new record\n- save: Save the created record\n- paste: While writing a note, paste the rest of it at once or read it from a file, then save the record\n- edit: Edit the note of the record\n- delete: Remove a record\n- lang <code>: Switch the language (cs, en)\n- overview: List the records by date, a line each\n- close: Close the diary\nCommands can be shortened, e.g. n for next or p for previous\nThe arrow keys, PgUp/PgDn and Home/End move through the records without Enter",
+        "Search result",
+        "Editing",
+        "Date",
+        "delete",
+        "Bytes pasted",
+        "Enter command",
+        "Paste the note, Ctrl-D ends it, Ctrl-C discards it",
+        "paste",
+        "next",
+        "Arrows, PgUp/PgDn, Home/End: scroll  Enter: open  q/Esc: back",
+        "close",
+    },
+};
+#endif // STRINGS_TABLES
+
+#endif // STRINGS_H
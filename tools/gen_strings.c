@@ -0,0 +1,425 @@
+// Turns strings.ini into strings.h, the translation tables the diary is built with.
+//
+//   gen_strings <strings.ini> > strings.h
+//
+// Every [section] becomes a language and every key a StringKey constant, so _(key) is an
+// array index checked by the compiler. Keys looked up by name at runtime go through a
+// minimal perfect hash: hash(name, seeds[hash(name, 0) % n]) % n is the key's slot, and
+// the constants are numbered by slot, so a lookup is one probe and one strcmp.
+// Every language must define every key, a missing or repeated one fails the build.
+
+#include <ctype.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_LANGUAGES 16
+#define MAX_KEYS 256
+#define MAX_LINE 4096
+#define MAX_SEED (1u << 20)
+
+typedef struct Language
+{
+    char *code;
+    char *values[MAX_KEYS]; // By key index, NULL until the section defines it
+} Language;
+
+static char *keys[MAX_KEYS];
+static int num_keys = 0;
+static Language languages[MAX_LANGUAGES];
+static int num_languages = 0;
+
+// FNV-1a, must stay the same as string_hash in i18n.c
+static uint32_t string_hash(const char *key, uint32_t seed)
+{
+    uint32_t hash = 2166136261u ^ seed;
+    while (*key != '\0')
+    {
+        hash ^= (unsigned char)*key++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static char *copy_string(const char *s)
+{
+    char *copy = (char *)malloc(strlen(s) + 1);
+    if (copy == NULL)
+    {
+        fprintf(stderr, "gen_strings: out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+    strcpy(copy, s);
+    return copy;
+}
+
+static char *trim_whitespace(char *str)
+{
+    while (isspace((unsigned char)*str))
+    {
+        str++;
+    }
+    char *end = str + strlen(str);
+    while (end > str && isspace((unsigned char)end[-1]))
+    {
+        end--;
+    }
+    *end = '\0';
+    return str;
+}
+
+// The same escapes i18n.c used to turn into characters at startup
+static void unescape_in_place(char *str)
+{
+    char *read = str;
+    char *write = str;
+    while (*read != '\0')
+    {
+        if (*read != '\\' || read[1] == '\0')
+        {
+            *write++ = *read++;
+            continue;
+        }
+        read++;
+        switch (*read)
+        {
+        case 'n':
+            *write++ = '\n';
+            break;
+        case 't':
+            *write++ = '\t';
+            break;
+        case 'r':
+            *write++ = '\r';
+            break;
+        case '\\':
+            *write++ = '\\';
+            break;
+        case '"':
+            *write++ = '"';
+            break;
+        default:
+            *write++ = '\\';
+            *write++ = *read;
+            break;
+        }
+        read++;
+    }
+    *write = '\0';
+}
+
+static int is_identifier(const char *s)
+{
+    if (!isalpha((unsigned char)*s) && *s != '_')
+    {
+        return 0;
+    }
+    for (; *s != '\0'; s++)
+    {
+        if (!isalnum((unsigned char)*s) && *s != '_')
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int key_index(const char *key)
+{
+    for (int i = 0; i < num_keys; i++)
+    {
+        if (strcmp(keys[i], key) == 0)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static int parse(FILE *file, const char *path)
+{
+    char line[MAX_LINE];
+    int line_number = 0;
+    Language *language = NULL;
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        line_number++;
+        char *trimmed = trim_whitespace(line);
+        if (trimmed[0] == '#' || trimmed[0] == '\0')
+        {
+            continue;
+        }
+        if (trimmed[0] == '[')
+        {
+            char *close = strchr(trimmed, ']');
+            if (close == NULL || close[1] != '\0' || close == trimmed + 1 || num_languages == MAX_LANGUAGES)
+            {
+                fprintf(stderr, "%s:%d: bad section\n", path, line_number);
+                return -1;
+            }
+            *close = '\0';
+            if (!is_identifier(trimmed + 1))
+            {
+                fprintf(stderr, "%s:%d: language code must be an identifier\n", path, line_number);
+                return -1;
+            }
+            language = &languages[num_languages++];
+            language->code = copy_string(trimmed + 1);
+            continue;
+        }
+
+        char *equals = strchr(trimmed, '=');
+        if (language == NULL || equals == NULL)
+        {
+            fprintf(stderr, "%s:%d: expected key = value inside a section\n", path, line_number);
+            return -1;
+        }
+        *equals = '\0';
+        char *key = trim_whitespace(trimmed);
+        char *value = trim_whitespace(equals + 1);
+        if (!is_identifier(key))
+        {
+            fprintf(stderr, "%s:%d: key '%s' must be an identifier\n", path, line_number, key);
+            return -1;
+        }
+        int index = key_index(key);
+        if (index < 0)
+        {
+            if (num_keys == MAX_KEYS)
+            {
+                fprintf(stderr, "%s:%d: too many keys\n", path, line_number);
+                return -1;
+            }
+            index = num_keys++;
+            keys[index] = copy_string(key);
+        }
+        if (language->values[index] != NULL)
+        {
+            fprintf(stderr, "%s:%d: '%s' is defined twice in [%s]\n", path, line_number, key, language->code);
+            return -1;
+        }
+        unescape_in_place(value);
+        language->values[index] = copy_string(value);
+    }
+
+    int status = num_languages > 0 ? 0 : -1;
+    if (status != 0)
+    {
+        fprintf(stderr, "%s: no sections\n", path);
+    }
+    for (int l = 0; l < num_languages; l++)
+    {
+        for (int k = 0; k < num_keys; k++)
+        {
+            if (languages[l].values[k] == NULL)
+            {
+                fprintf(stderr, "%s: [%s] is missing '%s'\n", path, languages[l].code, keys[k]);
+                status = -1;
+            }
+        }
+    }
+    return status;
+}
+
+// Hash and displace: the keys are split into buckets by hash(key, 0), then the fullest
+// bucket first, every bucket gets the smallest seed that sends its keys to free slots
+static int build_hash(uint32_t *seeds, int *slot_of_key)
+{
+    uint32_t n = (uint32_t)num_keys;
+    int bucket_of_key[MAX_KEYS];
+    int bucket_size[MAX_KEYS] = {0};
+    int order[MAX_KEYS];
+    int taken[MAX_KEYS] = {0};
+
+    for (int k = 0; k < num_keys; k++)
+    {
+        bucket_of_key[k] = (int)(string_hash(keys[k], 0) % n);
+        bucket_size[bucket_of_key[k]]++;
+    }
+    for (int b = 0; b < num_keys; b++)
+    {
+        order[b] = b;
+        seeds[b] = 0;
+    }
+    for (int i = 1; i < num_keys; i++) // Insertion sort by bucket size, largest first
+    {
+        int bucket = order[i];
+        int j = i;
+        while (j > 0 && bucket_size[order[j - 1]] < bucket_size[bucket])
+        {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = bucket;
+    }
+
+    for (int i = 0; i < num_keys && bucket_size[order[i]] > 0; i++)
+    {
+        int bucket = order[i];
+        uint32_t seed;
+        for (seed = 1; seed < MAX_SEED; seed++)
+        {
+            int ok = 1;
+            for (int k = 0; k < num_keys && ok; k++)
+            {
+                if (bucket_of_key[k] != bucket)
+                {
+                    continue;
+                }
+                int slot = (int)(string_hash(keys[k], seed) % n);
+                ok = !taken[slot];
+                taken[slot] = ok ? 2 : taken[slot]; // 2 marks slots of this attempt
+                slot_of_key[k] = slot;
+            }
+            if (ok)
+            {
+                break;
+            }
+            for (int s = 0; s < num_keys; s++)
+            {
+                taken[s] = taken[s] == 2 ? 0 : taken[s];
+            }
+        }
+        if (seed == MAX_SEED)
+        {
+            return -1;
+        }
+        for (int s = 0; s < num_keys; s++)
+        {
+            taken[s] = taken[s] != 0;
+        }
+        seeds[bucket] = seed;
+    }
+    return 0;
+}
+
+static void put_literal(const char *s)
+{
+    putchar('"');
+    for (; *s != '\0'; s++)
+    {
+        switch (*s)
+        {
+        case '\n':
+            fputs("\\n", stdout);
+            break;
+        case '\t':
+            fputs("\\t", stdout);
+            break;
+        case '\r':
+            fputs("\\r", stdout);
+            break;
+        case '\\':
+            fputs("\\\\", stdout);
+            break;
+        case '"':
+            fputs("\\\"", stdout);
+            break;
+        case '?':
+            fputs("\\?", stdout); // No trigraphs
+            break;
+        default:
+            putchar(*s);
+            break;
+        }
+    }
+    putchar('"');
+}
+
+static void write_header(const char *path, const uint32_t *seeds, const int *slot_of_key)
+{
+    int key_of_slot[MAX_KEYS];
+    for (int k = 0; k < num_keys; k++)
+    {
+        key_of_slot[slot_of_key[k]] = k;
+    }
+
+    printf("// Generated from %s by tools/gen_strings, do not edit.\n\n", path);
+    printf("#ifndef STRINGS_H\n#define STRINGS_H\n\n");
+    printf("// The keys, numbered by their slot in the perfect hash\n");
+    printf("typedef enum StringKey\n{\n");
+    for (int s = 0; s < num_keys; s++)
+    {
+        printf("    STR_%s,\n", keys[key_of_slot[s]]);
+    }
+    printf("    STRING_COUNT\n} StringKey;\n\n");
+
+    printf("// The sections\n");
+    printf("typedef enum Language\n{\n");
+    for (int l = 0; l < num_languages; l++)
+    {
+        printf("    LANG_%s,\n", languages[l].code);
+    }
+    printf("    LANGUAGE_COUNT\n} Language;\n\n");
+
+    printf("// The tables themselves are only compiled into i18n.c\n");
+    printf("#if defined(STRINGS_TABLES)\n");
+    printf("static const char *const string_keys[STRING_COUNT] = {\n");
+    for (int s = 0; s < num_keys; s++)
+    {
+        printf("    \"%s\",\n", keys[key_of_slot[s]]);
+    }
+    printf("};\n\n");
+
+    printf("static const unsigned int string_seeds[STRING_COUNT] = {");
+    for (int b = 0; b < num_keys; b++)
+    {
+        printf(b % 8 == 0 ? "\n    %u," : " %u,", (unsigned int)seeds[b]);
+    }
+    printf("\n};\n\n");
+
+    printf("static const char *const language_codes[LANGUAGE_COUNT] = {");
+    for (int l = 0; l < num_languages; l++)
+    {
+        printf(l > 0 ? ", \"%s\"" : "\"%s\"", languages[l].code);
+    }
+    printf("};\n\n");
+
+    printf("static const char *const string_table[LANGUAGE_COUNT][STRING_COUNT] = {\n");
+    for (int l = 0; l < num_languages; l++)
+    {
+        printf("    {\n");
+        for (int s = 0; s < num_keys; s++)
+        {
+            printf("        ");
+            put_literal(languages[l].values[key_of_slot[s]]);
+            printf(",\n");
+        }
+        printf("    },\n");
+    }
+    printf("};\n");
+    printf("#endif // STRINGS_TABLES\n\n");
+    printf("#endif // STRINGS_H\n");
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 2)
+    {
+        fprintf(stderr, "usage: gen_strings <strings.ini> > strings.h\n");
+        return EXIT_FAILURE;
+    }
+    FILE *file = fopen(argv[1], "r");
+    if (file == NULL)
+    {
+        perror(argv[1]);
+        return EXIT_FAILURE;
+    }
+    int parsed = parse(file, argv[1]);
+    fclose(file);
+    if (parsed != 0)
+    {
+        return EXIT_FAILURE;
+    }
+
+    uint32_t seeds[MAX_KEYS];
+    int slot_of_key[MAX_KEYS];
+    if (num_keys > 0 && build_hash(seeds, slot_of_key) != 0)
+    {
+        fprintf(stderr, "gen_strings: no perfect hash found\n");
+        return EXIT_FAILURE;
+    }
+    write_header(argv[1], seeds, slot_of_key);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,293 @@
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "trace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#endif
+
+#if !defined(_WIN32) || defined(__MINGW32__)
+#include <pthread.h>
+#define TRACE_THREADS 1
+#endif
+
+#include "writer.h"
+
+#define TRACE_MAX_EVENTS (256 * 1024) // Later spans still count towards the summary
+#define TRACE_MAX_NAMES 64
+
+int trace_enabled = 0;
+static long long counters[TRACE_COUNTER_COUNT];
+
+// One finished span
+typedef struct TraceEvent
+{
+    const char *name;
+    long long start; // ns since trace_init
+    long long duration;
+    int thread; // 1 for the thread that called trace_init, 2 for any other
+} TraceEvent;
+
+// Every span with one name, summed up
+typedef struct TraceTotal
+{
+    const char *name;
+    unsigned long count;
+    long long total;
+    long long max;
+} TraceTotal;
+
+static const char *counter_names[TRACE_COUNTER_COUNT] = {
+    "bytes_read", "bytes_written", "records_parsed", "records_serialized", "allocations", "allocation_chunks", "syncs", "screen_bytes"};
+
+static const char *report_path = NULL;
+static long long origin = 0;
+static TraceEvent *events = NULL;
+static size_t num_events = 0;
+static size_t events_capacity = 0;
+static unsigned long dropped_events = 0;
+static TraceTotal totals[TRACE_MAX_NAMES];
+static size_t num_totals = 0;
+
+#if defined(TRACE_THREADS)
+// The background saver records spans and counts too
+static pthread_mutex_t trace_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_t main_thread;
+#endif
+
+static void lock(void)
+{
+#if defined(TRACE_THREADS)
+    pthread_mutex_lock(&trace_lock);
+#endif
+}
+
+static void unlock(void)
+{
+#if defined(TRACE_THREADS)
+    pthread_mutex_unlock(&trace_lock);
+#endif
+}
+
+static int current_thread(void)
+{
+#if defined(TRACE_THREADS)
+    return pthread_equal(pthread_self(), main_thread) ? 1 : 2;
+#else
+    return 1;
+#endif
+}
+
+static long long now_ns(void)
+{
+#if defined(_WIN32)
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (long long)((double)counter.QuadPart * 1e9 / (double)frequency.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+#endif
+}
+
+void trace_init(void)
+{
+    const char *value = getenv("DIARY_TRACE");
+    if (value == NULL || value[0] == '\0')
+    {
+        return;
+    }
+    report_path = strcmp(value, "1") == 0 || strcmp(value, "-") == 0 ? NULL : value;
+    memset(counters, 0, sizeof(counters));
+#if defined(TRACE_THREADS)
+    main_thread = pthread_self();
+#endif
+    origin = now_ns() - 1; // Keeps every start above 0, which stands for "tracing off"
+    trace_enabled = 1;
+}
+
+void trace_add(TraceCounter counter, long long amount)
+{
+    lock();
+    counters[counter] += amount;
+    unlock();
+}
+
+long long trace_begin(void)
+{
+    if (!trace_enabled)
+    {
+        return 0;
+    }
+    return now_ns() - origin;
+}
+
+static TraceTotal *total_for(const char *name)
+{
+    for (size_t i = 0; i < num_totals; i++)
+    {
+        if (totals[i].name == name || strcmp(totals[i].name, name) == 0)
+        {
+            return &totals[i];
+        }
+    }
+    if (num_totals == TRACE_MAX_NAMES)
+    {
+        return NULL;
+    }
+    TraceTotal *total = &totals[num_totals++];
+    total->name = name;
+    return total;
+}
+
+void trace_end(const char *name, long long start)
+{
+    if (!trace_enabled || start == 0 || name == NULL)
+    {
+        return;
+    }
+    long long duration = now_ns() - origin - start;
+    int thread = current_thread();
+
+    lock();
+    TraceTotal *total = total_for(name);
+    if (total != NULL)
+    {
+        total->count++;
+        total->total += duration;
+        total->max = duration > total->max ? duration : total->max;
+    }
+
+    if (num_events == events_capacity && events_capacity < TRACE_MAX_EVENTS)
+    {
+        size_t capacity = events_capacity ? events_capacity * 2 : 1024;
+        TraceEvent *grown = (TraceEvent *)realloc(events, capacity * sizeof(TraceEvent));
+        if (grown != NULL)
+        {
+            events = grown;
+            events_capacity = capacity;
+        }
+    }
+    if (num_events == events_capacity)
+    {
+        dropped_events++;
+    }
+    else
+    {
+        events[num_events].name = name;
+        events[num_events].start = start;
+        events[num_events].duration = duration;
+        events[num_events].thread = thread;
+        num_events++;
+    }
+    unlock();
+}
+
+// Writes a time in microseconds, Chrome's unit
+static void put_us(Writer *writer, long long ns)
+{
+    char number[32];
+    snprintf(number, sizeof(number), "%lld.%03lld", ns / 1000, ns % 1000);
+    writer_puts(writer, number);
+}
+
+// Counters can pass what a long holds on Windows
+static void put_count(Writer *writer, long long value)
+{
+    char number[32];
+    snprintf(number, sizeof(number), "%lld", value);
+    writer_puts(writer, number);
+}
+
+static void write_report(Writer *writer, long long end)
+{
+    writer_puts(writer, "{\"traceEvents\": [\n");
+    for (size_t i = 0; i < num_events; i++)
+    {
+        writer_puts(writer, "{\"name\": \"");
+        writer_puts(writer, events[i].name);
+        writer_puts(writer, events[i].thread == 1 ? "\", \"ph\": \"X\", \"pid\": 1, \"tid\": 1, \"ts\": "
+                                                  : "\", \"ph\": \"X\", \"pid\": 1, \"tid\": 2, \"ts\": ");
+        put_us(writer, events[i].start);
+        writer_puts(writer, ", \"dur\": ");
+        put_us(writer, events[i].duration);
+        writer_puts(writer, "},\n");
+    }
+
+    writer_puts(writer, "{\"name\": \"counters\", \"ph\": \"C\", \"pid\": 1, \"tid\": 1, \"ts\": ");
+    put_us(writer, end);
+    writer_puts(writer, ", \"args\": {");
+    for (int i = 0; i < TRACE_COUNTER_COUNT; i++)
+    {
+        writer_puts(writer, i > 0 ? ", \"" : "\"");
+        writer_puts(writer, counter_names[i]);
+        writer_puts(writer, "\": ");
+        put_count(writer, counters[i]);
+    }
+    writer_puts(writer, "}}\n],\n\"displayTimeUnit\": \"ms\",\n\"summary\": {\"total_us\": ");
+    put_us(writer, end);
+    writer_puts(writer, ", \"dropped_events\": ");
+    put_count(writer, (long long)dropped_events);
+    writer_puts(writer, ", \"spans\": {");
+    for (size_t i = 0; i < num_totals; i++)
+    {
+        writer_puts(writer, i > 0 ? ",\n  \"" : "\n  \"");
+        writer_puts(writer, totals[i].name);
+        writer_puts(writer, "\": {\"count\": ");
+        put_count(writer, (long long)totals[i].count);
+        writer_puts(writer, ", \"total_us\": ");
+        put_us(writer, totals[i].total);
+        writer_puts(writer, ", \"max_us\": ");
+        put_us(writer, totals[i].max);
+        writer_putc(writer, '}');
+    }
+    writer_puts(writer, "},\n\"counters\": {");
+    for (int i = 0; i < TRACE_COUNTER_COUNT; i++)
+    {
+        writer_puts(writer, i > 0 ? ", \"" : "\"");
+        writer_puts(writer, counter_names[i]);
+        writer_puts(writer, "\": ");
+        put_count(writer, counters[i]);
+    }
+    writer_puts(writer, "}}}\n");
+}
+
+int trace_finish(void)
+{
+    if (!trace_enabled)
+    {
+        return 0;
+    }
+    // Every other thread has finished by now
+    long long end = now_ns() - origin;
+    trace_enabled = 0; // Writing the report must not count towards it
+
+    Writer writer;
+    int result = report_path != NULL ? writer_open(&writer, report_path) : writer_init_file(&writer, stderr);
+    if (result == 0)
+    {
+        write_report(&writer, end);
+    }
+    if (writer_close(&writer) != 0)
+    {
+        result = -1;
+    }
+
+    free(events);
+    events = NULL;
+    num_events = 0;
+    events_capacity = 0;
+    dropped_events = 0;
+    num_totals = 0;
+    return result;
+}
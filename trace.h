@@ -0,0 +1,64 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+// Counters kept while tracing
+typedef enum TraceCounter
+{
+    TRACE_BYTES_READ,
+    TRACE_BYTES_WRITTEN,
+    TRACE_RECORDS_PARSED,     // Records built from the snapshot and the journal
+    TRACE_RECORDS_SERIALIZED, // Records written to a snapshot or the journal
+    TRACE_ALLOCATIONS,        // Objects and strings handed out by pools and arenas
+    TRACE_ALLOCATION_CHUNKS,  // Chunks the pools and arenas took from malloc
+    TRACE_SYNCS,              // Files and directories forced to disk
+    TRACE_SCREEN_BYTES,       // Bytes sent to the terminal to draw the main screen
+    TRACE_COUNTER_COUNT
+} TraceCounter;
+
+// Set by trace_init when DIARY_TRACE is set. Everything below is a single branch while it is 0.
+extern int trace_enabled;
+
+// Adds to a counter
+#define TRACE_COUNT(counter, amount)                      \
+    do                                                    \
+    {                                                     \
+        if (trace_enabled)                                \
+        {                                                 \
+            trace_add(counter, (long long)(amount));      \
+        }                                                 \
+    } while (0)
+
+/**
+ * @brief Turns tracing on if DIARY_TRACE is set. Its value names the report file, "1" or "-" send the report to stderr.
+ */
+void trace_init(void);
+
+/**
+ * @brief Adds to a counter, use TRACE_COUNT instead so nothing is called while tracing is off.
+ * @param counter The counter to add to.
+ * @param amount The amount to add.
+ */
+void trace_add(TraceCounter counter, long long amount);
+
+/**
+ * @brief Starts a span. Spans can be recorded from any thread.
+ * @return The start time to pass to trace_end, 0 when tracing is off.
+ */
+long long trace_begin(void);
+
+/**
+ * @brief Ends a span and records it.
+ * @param name The span name. It is not copied, so it must outlive the trace (a string literal).
+ * @param start The value trace_begin returned.
+ */
+void trace_end(const char *name, long long start);
+
+/**
+ * @brief Writes the report in Chrome trace format and releases the recorded spans.
+ * Spans from other threads than the one that called trace_init are shown on a second track.
+ * The spans are also summed up per name under "summary", next to the counters.
+ * @return 0 on success (or when tracing is off), -1 on failure.
+ */
+int trace_finish(void);
+
+#endif // TRACE_H
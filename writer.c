@@ -0,0 +1,399 @@
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "writer.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "file.h"
+#include "trace.h"
+
+#if defined(_WIN32)
+#include <io.h>
+#define write _write
+#define fsync _commit
+#else
+#include <sys/uio.h>
+#include <unistd.h>
+#define WRITER_WRITEV 1
+#define WRITER_MAX_VECTORS 64 // Well below IOV_MAX everywhere
+#endif
+
+static void writer_reset(Writer *writer, WriterSink sink)
+{
+    memset(writer, 0, sizeof(Writer));
+    writer->sink = sink;
+    writer->fd = -1;
+}
+
+static int writer_alloc_chunk(Writer *writer)
+{
+    writer->buffer = (char *)malloc(WRITER_CHUNK_SIZE);
+    if (writer->buffer == NULL)
+    {
+        writer->error = 1;
+        return -1; // Memory allocation failed
+    }
+    writer->capacity = WRITER_CHUNK_SIZE;
+    return 0;
+}
+
+void writer_init_memory(Writer *writer)
+{
+    writer_reset(writer, WRITER_MEMORY);
+}
+
+int writer_init_file(Writer *writer, FILE *file)
+{
+    writer_reset(writer, WRITER_FILE);
+    writer->file = file;
+    if (file == NULL)
+    {
+        writer->error = 1;
+        return -1; // Invalid input
+    }
+    return writer_alloc_chunk(writer);
+}
+
+int writer_init_fd(Writer *writer, int fd)
+{
+    writer_reset(writer, WRITER_FD);
+    writer->fd = fd;
+    if (fd < 0)
+    {
+        writer->error = 1;
+        return -1; // Invalid input
+    }
+    return writer_alloc_chunk(writer);
+}
+
+int writer_open(Writer *writer, const char *filename)
+{
+    FILE *file = filename != NULL ? fopen(filename, "wb") : NULL;
+    if (writer_init_file(writer, file) != 0)
+    {
+        if (file != NULL)
+        {
+            fclose(file);
+        }
+        writer->file = NULL;
+        return -1; // File could not be opened for writing
+    }
+    writer->owns_file = 1;
+    return 0;
+}
+
+// Sends bytes straight to the file or fd, bypassing the buffer
+static int writer_emit(Writer *writer, const char *data, size_t len)
+{
+    long long span = trace_begin();
+    TRACE_COUNT(TRACE_BYTES_WRITTEN, len);
+    if (writer->sink == WRITER_FILE)
+    {
+        int result = fwrite(data, 1, len, writer->file) == len ? 0 : -1;
+        trace_end("write", span);
+        return result;
+    }
+
+    while (len > 0)
+    {
+        long written = (long)write(writer->fd, data, (unsigned int)(len > WRITER_CHUNK_SIZE ? WRITER_CHUNK_SIZE : len));
+        if (written < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return -1;
+        }
+        data += written;
+        len -= (size_t)written;
+    }
+    trace_end("write", span);
+    return 0;
+}
+
+int writer_flush(Writer *writer)
+{
+    if (writer == NULL || writer->error)
+    {
+        return -1;
+    }
+    if (writer->sink == WRITER_MEMORY || writer->used == 0)
+    {
+        return 0;
+    }
+
+    if (writer_emit(writer, writer->buffer, writer->used) != 0)
+    {
+        writer->error = 1;
+        return -1;
+    }
+    writer->used = 0;
+    return 0;
+}
+
+int writer_sync(Writer *writer)
+{
+    if (writer_flush(writer) != 0)
+    {
+        return -1;
+    }
+    int result = 0;
+    if (writer->sink == WRITER_FILE)
+    {
+        result = sync_file(writer->file);
+    }
+    else if (writer->sink == WRITER_FD)
+    {
+        result = fsync(writer->fd) == 0 ? 0 : -1;
+        TRACE_COUNT(TRACE_SYNCS, 1);
+    }
+    if (result != 0)
+    {
+        writer->error = 1;
+    }
+    return result;
+}
+
+int writer_write(Writer *writer, const void *data, size_t len)
+{
+    if (writer == NULL || writer->error)
+    {
+        return -1;
+    }
+    if (len == 0)
+    {
+        return 0;
+    }
+    if (data == NULL)
+    {
+        writer->error = 1;
+        return -1; // Invalid input
+    }
+
+    if (writer->used + len > writer->capacity)
+    {
+        if (writer->sink == WRITER_MEMORY)
+        {
+            // Grow geometrically so appending stays linear overall
+            size_t new_capacity = writer->capacity ? writer->capacity : 256;
+            while (new_capacity < writer->used + len + 1)
+            {
+                new_capacity *= 2;
+            }
+            char *grown = (char *)realloc(writer->buffer, new_capacity);
+            if (grown == NULL)
+            {
+                writer->error = 1;
+                return -1; // Memory allocation failed
+            }
+            writer->buffer = grown;
+            writer->capacity = new_capacity;
+        }
+        else
+        {
+            if (writer_flush(writer) != 0)
+            {
+                return -1;
+            }
+            if (len >= writer->capacity)
+            {
+                // Large writes skip the buffer instead of being copied through it
+                if (writer_emit(writer, (const char *)data, len) != 0)
+                {
+                    writer->error = 1;
+                    return -1;
+                }
+                writer->position += len;
+                return 0;
+            }
+        }
+    }
+
+    memcpy(writer->buffer + writer->used, data, len);
+    writer->used += len;
+    writer->position += len;
+    return 0;
+}
+
+int writer_write_chunks(Writer *writer, const WriterChunk *chunks, size_t count)
+{
+    if (writer == NULL || writer->error || (chunks == NULL && count > 0))
+    {
+        return -1;
+    }
+    if (writer->sink == WRITER_MEMORY)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            writer_write(writer, chunks[i].data, chunks[i].len);
+        }
+        return writer->error ? -1 : 0;
+    }
+    if (writer_flush(writer) != 0)
+    {
+        return -1;
+    }
+
+    size_t total = 0;
+#if defined(WRITER_WRITEV)
+    // The stream's own buffer is empty after the flush, so its descriptor can be written directly
+    if (writer->sink == WRITER_FILE && fflush(writer->file) != 0)
+    {
+        writer->error = 1;
+        return -1;
+    }
+    int fd = writer->sink == WRITER_FILE ? fileno(writer->file) : writer->fd;
+    long long span = trace_begin();
+    size_t i = 0;
+    size_t offset = 0; // Bytes of chunks[i] already written
+    while (i < count)
+    {
+        struct iovec vectors[WRITER_MAX_VECTORS];
+        int num_vectors = 0;
+        for (size_t k = i; k < count && num_vectors < WRITER_MAX_VECTORS; k++)
+        {
+            size_t skip = k == i ? offset : 0;
+            vectors[num_vectors].iov_base = (void *)(chunks[k].data + skip);
+            vectors[num_vectors].iov_len = chunks[k].len - skip;
+            num_vectors++;
+        }
+        ssize_t written = writev(fd, vectors, num_vectors);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            writer->error = 1;
+            trace_end("write", span);
+            return -1;
+        }
+        TRACE_COUNT(TRACE_BYTES_WRITTEN, written);
+        total += (size_t)written;
+
+        size_t left = (size_t)written;
+        while (i < count && left >= chunks[i].len - offset)
+        {
+            left -= chunks[i].len - offset;
+            offset = 0;
+            i++;
+        }
+        offset += left;
+    }
+    trace_end("write", span);
+#else
+    for (size_t i = 0; i < count; i++)
+    {
+        if (chunks[i].len > 0 && writer_emit(writer, chunks[i].data, chunks[i].len) != 0)
+        {
+            writer->error = 1;
+            return -1;
+        }
+        total += chunks[i].len;
+    }
+#endif
+    writer->position += total;
+    return 0;
+}
+
+int writer_puts(Writer *writer, const char *str)
+{
+    if (str == NULL)
+    {
+        if (writer != NULL)
+        {
+            writer->error = 1;
+        }
+        return -1; // Invalid input
+    }
+    return writer_write(writer, str, strlen(str));
+}
+
+int writer_putc(Writer *writer, char c)
+{
+    if (writer != NULL && !writer->error && writer->used < writer->capacity)
+    {
+        writer->buffer[writer->used++] = c;
+        writer->position++;
+        return 0;
+    }
+    return writer_write(writer, &c, 1);
+}
+
+int writer_put_int(Writer *writer, long value)
+{
+    char digits[24];
+    size_t pos = sizeof(digits);
+    unsigned long magnitude = value < 0 ? 0UL - (unsigned long)value : (unsigned long)value;
+
+    do
+    {
+        digits[--pos] = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude != 0);
+
+    if (value < 0)
+    {
+        digits[--pos] = '-';
+    }
+    return writer_write(writer, digits + pos, sizeof(digits) - pos);
+}
+
+char *writer_detach(Writer *writer, size_t *len)
+{
+    if (writer == NULL || writer->sink != WRITER_MEMORY || writer->error)
+    {
+        return NULL;
+    }
+
+    // Make room for the terminator even when nothing was written
+    if (writer->used + 1 > writer->capacity)
+    {
+        char *grown = (char *)realloc(writer->buffer, writer->used + 1);
+        if (grown == NULL)
+        {
+            writer->error = 1;
+            return NULL; // Memory allocation failed
+        }
+        writer->buffer = grown;
+    }
+
+    char *result = writer->buffer;
+    result[writer->used] = '\0';
+    if (len != NULL)
+    {
+        *len = writer->used;
+    }
+    writer_reset(writer, WRITER_MEMORY);
+    return result;
+}
+
+int writer_close(Writer *writer)
+{
+    if (writer == NULL)
+    {
+        return -1;
+    }
+
+    int result = writer_flush(writer);
+    if (writer->file != NULL && writer->owns_file)
+    {
+        if (fclose(writer->file) != 0)
+        {
+            result = -1;
+        }
+    }
+    else if (writer->file != NULL && fflush(writer->file) != 0)
+    {
+        result = -1;
+    }
+
+    free(writer->buffer);
+    writer_reset(writer, writer->sink);
+    return result;
+}
@@ -0,0 +1,142 @@
+#ifndef WRITER_H
+#define WRITER_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+// Size of the chunks a file or fd writer flushes
+#define WRITER_CHUNK_SIZE (64 * 1024)
+
+// A piece of output that was put together elsewhere, see writer_write_chunks
+typedef struct WriterChunk
+{
+    const char *data;
+    size_t len;
+} WriterChunk;
+
+// Where a writer sends its output
+typedef enum WriterSink
+{
+    WRITER_MEMORY, // Growable in-memory string
+    WRITER_FILE,   // FILE* stream, flushed in fixed-size chunks
+    WRITER_FD      // File descriptor, flushed in fixed-size chunks
+} WriterSink;
+
+// A buffered output sink that tracks its write position
+typedef struct Writer
+{
+    WriterSink sink;
+    char *buffer;
+    size_t capacity;
+    size_t used;     // Bytes waiting in the buffer
+    size_t position; // Bytes written through the writer so far
+    FILE *file;
+    int fd;
+    int owns_file;
+    int error;
+} Writer;
+
+/**
+ * @brief Initializes a writer that collects everything in a growable string.
+ * @param writer The writer to initialize.
+ */
+void writer_init_memory(Writer *writer);
+
+/**
+ * @brief Initializes a writer that flushes to an open stream. The stream is not closed by the writer.
+ * @param writer The writer to initialize.
+ * @param file The stream to write to.
+ * @return 0 on success, -1 on failure.
+ */
+int writer_init_file(Writer *writer, FILE *file);
+
+/**
+ * @brief Initializes a writer that flushes to a file descriptor. The descriptor is not closed by the writer.
+ * @param writer The writer to initialize.
+ * @param fd The file descriptor to write to.
+ * @return 0 on success, -1 on failure.
+ */
+int writer_init_fd(Writer *writer, int fd);
+
+/**
+ * @brief Opens a file for writing (truncating it) and initializes a writer that owns it.
+ * @param writer The writer to initialize.
+ * @param filename The name of the file to write to.
+ * @return 0 on success, -1 on failure.
+ */
+int writer_open(Writer *writer, const char *filename);
+
+/**
+ * @brief Writes bytes to the writer.
+ * @param writer The writer to write to.
+ * @param data The bytes to write.
+ * @param len The number of bytes to write.
+ * @return 0 on success, -1 on failure. Once a write fails, all later writes fail too.
+ */
+int writer_write(Writer *writer, const void *data, size_t len);
+
+/**
+ * @brief Writes several pieces of output in order without copying them through the buffer.
+ * File and fd writers hand them to the OS in one gathered write (writev) where the platform has it.
+ * @param writer The writer to write to.
+ * @param chunks The pieces to write.
+ * @param count The number of pieces.
+ * @return 0 on success, -1 on failure. Once a write fails, all later writes fail too.
+ */
+int writer_write_chunks(Writer *writer, const WriterChunk *chunks, size_t count);
+
+/**
+ * @brief Writes a null-terminated string to the writer.
+ * @param writer The writer to write to.
+ * @param str The string to write.
+ * @return 0 on success, -1 on failure.
+ */
+int writer_puts(Writer *writer, const char *str);
+
+/**
+ * @brief Writes a single character to the writer.
+ * @param writer The writer to write to.
+ * @param c The character to write.
+ * @return 0 on success, -1 on failure.
+ */
+int writer_putc(Writer *writer, char c);
+
+/**
+ * @brief Writes a decimal integer to the writer.
+ * @param writer The writer to write to.
+ * @param value The integer to write.
+ * @return 0 on success, -1 on failure.
+ */
+int writer_put_int(Writer *writer, long value);
+
+/**
+ * @brief Sends buffered bytes to the file or fd. Does nothing for memory writers.
+ * @param writer The writer to flush.
+ * @return 0 on success, -1 on failure.
+ */
+int writer_flush(Writer *writer);
+
+/**
+ * @brief Flushes the writer and forces its file or fd to disk. Does nothing more for memory writers.
+ * @param writer The writer to sync.
+ * @return 0 on success, -1 on failure.
+ */
+int writer_sync(Writer *writer);
+
+/**
+ * @brief Takes the collected string out of a memory writer. The caller must free it.
+ * The writer is left empty and may be reused.
+ * @param writer The memory writer.
+ * @param len Receives the string length, may be NULL.
+ * @return The null-terminated string, or NULL on failure.
+ */
+char *writer_detach(Writer *writer, size_t *len);
+
+/**
+ * @brief Flushes the writer, closes a file it owns and frees its buffer.
+ * @param writer The writer to close.
+ * @return 0 if everything was written, -1 if any write failed.
+ */
+int writer_close(Writer *writer);
+
+#endif // WRITER_H